@@ -10,6 +10,9 @@ DRIVERSRC += $(DRIVERPATH)/src/eicu_driver.c
 DRIVERSRC += $(DRIVERPATH)/src/eeprom_driver.c
 DRIVERSRC += $(DRIVERPATH)/src/24xx_driver.c
 DRIVERSRC += $(DRIVERPATH)/src/25xx_driver.c
+DRIVERSRC += $(DRIVERPATH)/src/eeprom_lz.c
+DRIVERSRC += $(DRIVERPATH)/src/eeprom_counter.c
+DRIVERSRC += $(DRIVERPATH)/src/eeprom_wave.c
 
 DRIVERINC += $(DRIVERPATH)/inc
 
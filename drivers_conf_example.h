@@ -44,7 +44,7 @@
 #define STM32_DAC_CHN1_DMA_STREAM          STM32_DMA_STREAM_ID(2, 3)
 #define STM32_DAC_CHN2_DMA_STREAM          STM32_DMA_STREAM_ID(2, 4)
 #define STM32_DAC_CHN3_DMA_STREAM          STM32_DMA_STREAM_ID(2, 5)
-#define STM32_DAC_DMA_ERROR_HOOK(dacp)   chSysHalt()
+#define STM32_DAC_DMA_ERROR_HOOK(dacp)   chSysHalt("DMA failure")
 
 /*
  * TIMCAP driver system settings.
@@ -61,8 +61,33 @@
  */
 #define STM32_IUART_USE_USART1             TRUE
 #define STM32_IUART_USE_USART2             FALSE
+#define STM32_IUART_USE_UART4              FALSE
+#define STM32_IUART_USE_UART5              FALSE
+#define STM32_IUART_USE_USART6             FALSE
+#define STM32_IUART_USE_UART7              FALSE
+#define STM32_IUART_USE_UART8              FALSE
+#define STM32_IUART_USE_LPUART1            FALSE
 #define STM32_IUART_USART1_IRQ_PRIORITY      3
 #define STM32_IUART_USART2_IRQ_PRIORITY      3
+#define STM32_IUART_USART1_USE_RX_DMA        FALSE
+#define STM32_IUART_USART1_USE_TX_DMA        FALSE
+#define STM32_IUART_USART2_USE_RX_DMA        FALSE
+#define STM32_IUART_USART2_USE_TX_DMA        FALSE
+#define IUART_USE_RXRING                     FALSE
+#define IUART_USE_TXQUEUE                    FALSE
+#define IUART_USE_FRAMING                    FALSE
+#define IUART_USE_DEFERRED                   FALSE
+#define IUART_USE_CHANNEL                    FALSE
+#define IUART_USE_RS485                      FALSE
+#define IUART_USE_STATS                      FALSE
+#define IUART_USE_MODBUS                     FALSE
+#define IUART_USE_CRC                        FALSE
+#define IUART_USE_BRIDGE                     FALSE
+#define IUART_USE_MUTE                       FALSE
+#define IUART_USE_RXCHAIN                    FALSE
+#define IUART_USE_TXPRIO                     FALSE
+#define IUART_USE_FLOWCTL                    FALSE
+#define IUART_USE_TIMESTAMP                  FALSE
 
 /*
  * Extended ICU driver system settings.
@@ -89,5 +114,9 @@
  */
 #define EEPROM_DRV_USE_25XX              TRUE
 #define EEPROM_DRV_USE_24XX              FALSE
+#define EEPROM_USE_STATIC_BINDING        FALSE
+#define EEPROM_USE_COMPRESSION           FALSE
+#define EEPROM_USE_COUNTER               FALSE
+#define EEPROM_USE_WAVE                  FALSE
 
 #endif /* _DRIVERS_CONF_H */
\ No newline at end of file
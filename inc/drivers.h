@@ -5,6 +5,9 @@
 #include "drivers_conf.h"
 #include "dac_driver.h"
 #include "eeprom_driver.h"
+#include "eeprom_lz.h"
+#include "eeprom_counter.h"
+#include "eeprom_wave.h"
 #include "iwdg_driver.h"
 #include "timcap_driver.h"
 #include "iuart_driver.h"
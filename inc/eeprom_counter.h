@@ -0,0 +1,104 @@
+/*
+  Copyright (c) 2013 Timon Wong
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/*
+  Copyright 2012 Uladzimir Pylinski aka barthess.
+  You may use this work without restrictions, as long as this notice is included.
+  The work is provided "as is" without warranty of any kind, neither express nor implied.
+*/
+
+
+/**
+ * @file    eeprom_counter.h
+ * @brief   High endurance counter stored in EEPROM file.
+ * @details Counter occupies 4 byte base value followed by ring of
+ *          @p ncells single byte cells. Cells are marked one by one with
+ *          tag of current lap, counter value is base plus number of
+ *          marked cells. When all cells are marked, next increment
+ *          moves base forward by (ncells + 1), which flips the lap tag
+ *          and so implicitly unmarks all cells.
+ *
+ *          Every increment writes single byte (or base value once per lap)
+ *          and every cell is written once per (ncells + 1) increments.
+ */
+
+#ifndef __EEPROM_COUNTER_H__
+#define __EEPROM_COUNTER_H__
+
+#include "eeprom_driver.h"
+
+#if (defined(DRIVER_USE_EEPROM) && DRIVER_USE_EEPROM &&                     \
+     EEPROM_USE_COUNTER) || defined(__DOXYGEN__)
+
+/**
+ * @brief   Maximum number of cells in counter ring.
+ * @note    Counter read uses stack buffer of this size.
+ */
+#ifndef EEPROM_COUNTER_MAX_CELLS
+#define EEPROM_COUNTER_MAX_CELLS  64
+#endif
+
+/**
+ * @brief   Space taken by counter in EEPROM file.
+ */
+#define EEPROM_COUNTER_SIZE(ncells)   (4 + (ncells))
+
+/**
+ * @brief   Counter configuration.
+ */
+typedef struct {
+  /**
+   * EEPROM file holding counter.
+   */
+  EepromFileStream  *efs;
+  /**
+   * Offset of counter in file. Base value must not cross page boundary.
+   */
+  uint32_t          offset;
+  /**
+   * Number of cells, up to @p EEPROM_COUNTER_MAX_CELLS.
+   */
+  uint16_t          ncells;
+} EepromCounterConfig;
+
+/**
+ * @brief   Counter object, caches state read from EEPROM.
+ */
+typedef struct {
+  const EepromCounterConfig *cfg;
+  /**
+   * Base value stored in EEPROM.
+   */
+  uint32_t          base;
+  /**
+   * Number of marked cells.
+   */
+  uint16_t          marked;
+} EepromCounter;
+
+msg_t EepromCounterOpen(EepromCounter *cnt, const EepromCounterConfig *cfg);
+uint32_t EepromCounterGet(const EepromCounter *cnt);
+msg_t EepromCounterIncrement(EepromCounter *cnt);
+msg_t EepromCounterSet(EepromCounter *cnt, uint32_t value);
+
+#endif /* DRIVER_USE_EEPROM && EEPROM_USE_COUNTER */
+#endif /* __EEPROM_COUNTER_H__ */
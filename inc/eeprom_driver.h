@@ -32,7 +32,8 @@
 #if defined(DRIVER_USE_EEPROM) && DRIVER_USE_EEPROM
 
 #include "ch.h"
-#include "drivers.h"
+/* Not drivers.h, it includes the adapters built on this header. */
+#include "hal.h"
 
 #ifndef EEPROM_DRV_USE_25XX
 #define EEPROM_DRV_USE_25XX FALSE
@@ -50,6 +51,42 @@
 #error "No EEPROM device selected!"
 #endif
 
+/**
+ * @brief   Binds EEPROM files to the only enabled device at compile time.
+ * @details Device lookup by name is not performed and file read/write
+ *          functions call low level routines of device directly, bypassing
+ *          virtual methods table.
+ * @note    Can be used only when exactly one EEPROM device is enabled.
+ */
+#ifndef EEPROM_USE_STATIC_BINDING
+#define EEPROM_USE_STATIC_BINDING FALSE
+#endif
+
+/**
+ * @brief   Enables compressing stream adapter for EEPROM files.
+ */
+#ifndef EEPROM_USE_COMPRESSION
+#define EEPROM_USE_COMPRESSION FALSE
+#endif
+
+/**
+ * @brief   Enables high endurance counters stored in EEPROM files.
+ */
+#ifndef EEPROM_USE_COUNTER
+#define EEPROM_USE_COUNTER FALSE
+#endif
+
+/**
+ * @brief   Enables waveform playback from EEPROM files through DAC.
+ */
+#ifndef EEPROM_USE_WAVE
+#define EEPROM_USE_WAVE FALSE
+#endif
+
+#if EEPROM_USE_STATIC_BINDING && (EEPROM_DRV_TABLE_SIZE != 1)
+#error "EEPROM static binding requires exactly one EEPROM device"
+#endif
+
 #define _eeprom_file_config_data                                            \
   /* Lower barrier of file in EEPROM memory array. */                       \
   uint32_t        barrier_low;                                              \
@@ -77,6 +114,8 @@ typedef struct {
   _base_sequential_stream_data                                                    \
   uint32_t                    errors;                                       \
   uint32_t                    position;                                     \
+  /* Page offset mask, zero when page size is not a power of two. */        \
+  uint32_t                    pagemask;                                     \
 
 /**
  * @extends BaseFileStreamVMT
@@ -101,6 +140,30 @@ typedef struct {
   const EepromFileConfig *cfg;
 } EepromFileStream;
 
+/**
+ * @brief   Low level page access operations of an EEPROM backend.
+ * @details Used by the common transfer engine, which splits requests
+ *          on page boundaries and waits for write cycles completion.
+ */
+typedef struct {
+  /**
+   * Read @p len bytes starting at file offset @p offset.
+   */
+  msg_t (*read)(const EepromFileConfig *cfg, uint32_t offset,
+                uint8_t *data, size_t len);
+  /**
+   * Write @p len bytes starting at file offset @p offset. Data must be
+   * fitted in single page.
+   */
+  msg_t (*write)(const EepromFileConfig *cfg, uint32_t offset,
+                 const uint8_t *data, size_t len);
+  /**
+   * Return @p true while write cycle is in progress. May be @p NULL,
+   * in that case engine just sleeps for @p write_time after every page.
+   */
+  bool (*is_busy)(const EepromFileConfig *cfg);
+} EepromBackendOps;
+
 /**
  * @brief   Low level device descriptor.
  */
@@ -243,8 +306,71 @@ EepromFileStream *SPIEepromFileOpen(SPIEepromFileStream *efs,
 #define chFileStreamWrite(ip, bp, n) (chSequentialStreamWrite(ip, bp, n))
 #endif
 
+#if EEPROM_DRV_USE_24XX
+extern EepromDevice eepdev_24xx;
+msg_t eeprom_24xx_read(const EepromFileConfig *cfg, uint32_t offset,
+                       uint8_t *data, size_t len);
+msg_t eeprom_24xx_write(const EepromFileConfig *cfg, uint32_t offset,
+                        const uint8_t *data, size_t len);
+#endif
+
+#if EEPROM_DRV_USE_25XX
+extern EepromDevice eepdev_25xx;
+msg_t eeprom_25xx_read(const EepromFileConfig *cfg, uint32_t offset,
+                       uint8_t *data, size_t len);
+msg_t eeprom_25xx_write(const EepromFileConfig *cfg, uint32_t offset,
+                        const uint8_t *data, size_t len);
+bool eeprom_25xx_is_busy(const EepromFileConfig *cfg);
+#endif
+
+#if EEPROM_USE_STATIC_BINDING || defined(__DOXYGEN__)
+
+#if EEPROM_DRV_USE_25XX
+#define EEPROM_STATIC_DEVICE      eepdev_25xx
+#define eeprom_static_read        eeprom_25xx_read
+#define eeprom_static_write       eeprom_25xx_write
+#define eeprom_static_is_busy     eeprom_25xx_is_busy
+#define EEPROM_STATIC_HAS_BUSY    TRUE
+#else /* EEPROM_DRV_USE_24XX */
+#define EEPROM_STATIC_DEVICE      eepdev_24xx
+#define eeprom_static_read        eeprom_24xx_read
+#define eeprom_static_write       eeprom_24xx_write
+#define EEPROM_STATIC_HAS_BUSY    FALSE
+#endif
+
+/**
+ * @brief   Returns the only enabled EEPROM device, @p name is ignored.
+ */
+#define EepromFindDevice(name) ((void)(name), &EEPROM_STATIC_DEVICE)
+
+/**
+ * @brief   EEPROM file read calling device routines directly.
+ */
+#define EepromFileRead(efs, bp, n)                                          \
+  eepfs_read((EepromFileStream *)(efs), NULL, (bp), (n))
+
+/**
+ * @brief   EEPROM file write calling device routines directly.
+ */
+#define EepromFileWrite(efs, bp, n)                                         \
+  eepfs_write((EepromFileStream *)(efs), NULL, (bp), (n))
+
+#else /* !EEPROM_USE_STATIC_BINDING */
+
+/**
+ * @brief   EEPROM file read.
+ */
+#define EepromFileRead(efs, bp, n)  chFileStreamRead(efs, bp, n)
+
+/**
+ * @brief   EEPROM file write.
+ */
+#define EepromFileWrite(efs, bp, n) chFileStreamWrite(efs, bp, n)
+
 const EepromDevice *EepromFindDevice(const char *name);
 
+#endif /* !EEPROM_USE_STATIC_BINDING */
+
 EepromFileStream *EepromFileOpen(EepromFileStream *efs,
                                  const EepromFileConfig *eepcfg,
                                  const EepromDevice *eepdev);
@@ -256,6 +382,11 @@ size_t EepromWriteByte(EepromFileStream *efs, uint8_t data);
 size_t EepromWriteHalfword(EepromFileStream *efs, uint16_t data);
 size_t EepromWriteWord(EepromFileStream *efs, uint32_t data);
 
+size_t eepfs_write(void *ip, const EepromBackendOps *ops,
+                   const uint8_t *bp, size_t n);
+size_t eepfs_read(void *ip, const EepromBackendOps *ops,
+                  uint8_t *bp, size_t n);
+
 fileoffset_t eepfs_getsize(void *ip);
 fileoffset_t eepfs_getposition(void *ip);
 fileoffset_t eepfs_lseek(void *ip, fileoffset_t offset);
@@ -0,0 +1,152 @@
+/*
+  Copyright (c) 2013 Timon Wong
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/*
+  Copyright 2012 Uladzimir Pylinski aka barthess.
+  You may use this work without restrictions, as long as this notice is included.
+  The work is provided "as is" without warranty of any kind, neither express nor implied.
+*/
+
+
+/**
+ * @file    eeprom_lz.h
+ * @brief   Compressing stream adapter for EEPROM files.
+ * @details Data written to the adapter is split in blocks, every block is
+ *          compressed with small LZ77 (LZF alike) compressor and stored in
+ *          EEPROM file starting from page boundary. RAM usage is bounded by
+ *          two block sized buffers and a hash table.
+ *
+ *          Block layout in EEPROM:
+ *          - 16 bit little endian payload length, bit 15 set for blocks
+ *            stored without compression.
+ *          - 16 bit little endian raw data length, 0 or 0xFFFF mark the
+ *            end of data.
+ *          - payload.
+ *          .
+ *          Flush writes a zero header at the page boundary following the
+ *          last block, reading stops there.
+ */
+
+#ifndef __EEPROM_LZ_H__
+#define __EEPROM_LZ_H__
+
+#include "eeprom_driver.h"
+
+#if (defined(DRIVER_USE_EEPROM) && DRIVER_USE_EEPROM &&                     \
+     EEPROM_USE_COMPRESSION) || defined(__DOXYGEN__)
+
+/**
+ * @brief   Size of block header in bytes.
+ */
+#define EEPROM_LZ_HEADER_SIZE     4
+
+/**
+ * @brief   Maximum block size.
+ */
+#define EEPROM_LZ_MAX_BLOCK       8192
+
+/**
+ * @brief   Required size of packed data buffer for given block size.
+ */
+#define EEPROM_LZ_PACKBUF_SIZE(blocksize)                                   \
+  ((blocksize) + EEPROM_LZ_HEADER_SIZE)
+
+/**
+ * @brief   Log2 of compressor hash table size.
+ * @note    Hash table takes 2 * 2^EEPROM_LZ_HASH_LOG bytes of RAM inside
+ *          of every @p EepromLzStream object.
+ */
+#ifndef EEPROM_LZ_HASH_LOG
+#define EEPROM_LZ_HASH_LOG        8
+#endif
+
+/**
+ * @brief   Compressing stream configuration.
+ */
+typedef struct {
+  /**
+   * Uncompressed block buffer, @p blocksize bytes.
+   */
+  uint8_t         *rawbuf;
+  /**
+   * Compressed block buffer, @p EEPROM_LZ_PACKBUF_SIZE(blocksize) bytes.
+   */
+  uint8_t         *packbuf;
+  /**
+   * Size of uncompressed block. Reader must use the same or bigger
+   * block size than writer.
+   */
+  uint16_t        blocksize;
+} EepromLzConfig;
+
+/**
+ * @brief   @p EepromLzStream specific data.
+ */
+#define _eeprom_lz_stream_data                                              \
+  _base_sequential_stream_data                                              \
+  /* Underlying EEPROM file. */                                             \
+  EepromFileStream            *efs;                                         \
+  const EepromLzConfig        *cfg;                                         \
+  /* Number of valid bytes in raw buffer. */                                \
+  size_t                      fill;                                         \
+  /* Read position in raw buffer. */                                        \
+  size_t                      rpos;                                         \
+  /* Stream opened for writing. */                                          \
+  bool                        writing;                                      \
+  /* End of data reached. */                                                \
+  bool                        eof;                                          \
+  uint16_t                    htab[1 << EEPROM_LZ_HASH_LOG];
+
+/**
+ * @extends BaseSequentialStreamVMT
+ *
+ * @brief   @p EepromLzStream virtual methods table.
+ */
+struct EepromLzStreamVMT {
+  _base_sequential_stream_methods
+};
+
+/**
+ * @extends BaseSequentialStream
+ *
+ * @brief   Compressing EEPROM stream class.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct EepromLzStreamVMT *vmt;
+  _eeprom_lz_stream_data
+} EepromLzStream;
+
+EepromLzStream *EepromLzOpenWrite(EepromLzStream *lzs, EepromFileStream *efs,
+                                  const EepromLzConfig *cfg);
+EepromLzStream *EepromLzOpenRead(EepromLzStream *lzs, EepromFileStream *efs,
+                                 const EepromLzConfig *cfg);
+msg_t EepromLzFlush(EepromLzStream *lzs);
+msg_t EepromLzClose(EepromLzStream *lzs);
+
+size_t eeprom_lz_compress(uint16_t *htab, const uint8_t *in, size_t inlen,
+                          uint8_t *out, size_t outlen);
+size_t eeprom_lz_decompress(const uint8_t *in, size_t inlen,
+                            uint8_t *out, size_t outlen);
+
+#endif /* DRIVER_USE_EEPROM && EEPROM_USE_COMPRESSION */
+#endif /* __EEPROM_LZ_H__ */
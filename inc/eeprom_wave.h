@@ -0,0 +1,157 @@
+/*
+  Copyright (c) 2013 Timon Wong
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/*
+  Copyright 2012 Uladzimir Pylinski aka barthess.
+  You may use this work without restrictions, as long as this notice is included.
+  The work is provided "as is" without warranty of any kind, neither express nor implied.
+*/
+
+
+/**
+ * @file    eeprom_wave.h
+ * @brief   Waveform playback from EEPROM file through DAC.
+ * @details Samples are streamed from EEPROM file into circular DAC buffer.
+ *          While DMA plays one half of the buffer the other half is refilled
+ *          by worker thread woken from DAC half and full callbacks, so long
+ *          waveforms can be played using two small RAM buffers.
+ *
+ *          Samples are stored in file as little endian @p dacsample_t
+ *          values, multichannel rows are stored interleaved.
+ */
+
+#ifndef __EEPROM_WAVE_H__
+#define __EEPROM_WAVE_H__
+
+#include "eeprom_driver.h"
+#include "dac_driver.h"
+
+#if (defined(DRIVER_USE_EEPROM) && DRIVER_USE_EEPROM &&                     \
+     defined(DRIVER_USE_DAC) && DRIVER_USE_DAC && EEPROM_USE_WAVE) ||        \
+    defined(__DOXYGEN__)
+
+/**
+ * @brief   Waveform player structure.
+ */
+typedef struct EepromWave EepromWave;
+
+/**
+ * @brief   Waveform end notification callback type.
+ *
+ * @param[in] wavp      pointer to the @p EepromWave object
+ */
+typedef void (*ewavcb_t)(EepromWave *wavp);
+
+/**
+ * @brief   Waveform player configuration.
+ */
+typedef struct {
+  /**
+   * Sampling frequency in Hz.
+   */
+  uint32_t          frequency;
+  /**
+   * Number of DAC channels.
+   */
+  uint32_t          num_channels;
+  /**
+   * Circular buffer of @p depth rows.
+   */
+  dacsample_t       *buffer;
+  /**
+   * Buffer depth, must be even.
+   */
+  size_t            depth;
+  /**
+   * Restart from the beginning of file at the end of waveform.
+   */
+  bool              loop;
+  /**
+   * Value output after the end of waveform.
+   */
+  dacsample_t       idle;
+  /**
+   * Worker thread working area.
+   */
+  void              *wsp;
+  /**
+   * Worker thread working area size.
+   */
+  size_t            wssize;
+  /**
+   * Worker thread priority, must be high enough to refill half buffer
+   * while DMA plays another one.
+   */
+  tprio_t           prio;
+  /**
+   * End of playback callback or @p NULL, called from worker thread.
+   */
+  ewavcb_t          end_cb;
+} EepromWaveConfig;
+
+/**
+ * @brief   Waveform player structure.
+ */
+struct EepromWave {
+  /**
+   * DAC conversion group, must be the first member, DAC callback finds
+   * player object by the conversion group pointer.
+   */
+  DACConversionGroup        grp;
+  const EepromWaveConfig    *cfg;
+  DACDriver                 *dacp;
+  EepromFileStream          *efs;
+  thread_t                  *thread;
+  /**
+   * Worker wakeup semaphore.
+   */
+  semaphore_t               sem;
+  /**
+   * Pending worker requests.
+   */
+  volatile uint8_t          pending;
+  /**
+   * Halves being refilled by worker.
+   */
+  volatile uint8_t          filling;
+  /**
+   * Next half of the buffer to be refilled.
+   */
+  uint8_t                   next;
+  /**
+   * Half of the buffer holding the last samples of waveform, 2 once it
+   * has been played, or -1.
+   */
+  volatile int8_t           last;
+  /**
+   * Number of halves played before they were refilled.
+   */
+  volatile uint32_t         underruns;
+};
+
+void EepromWaveObjectInit(EepromWave *wavp);
+void EepromWaveStart(EepromWave *wavp, DACDriver *dacp,
+                     EepromFileStream *efs, const EepromWaveConfig *cfg);
+void EepromWaveStop(EepromWave *wavp);
+
+#endif /* DRIVER_USE_EEPROM && DRIVER_USE_DAC && EEPROM_USE_WAVE */
+#endif /* __EEPROM_WAVE_H__ */
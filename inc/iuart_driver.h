@@ -52,16 +52,237 @@
 #define IUART_OVERRUN_ERROR      16  /**< @brief Overflow happened.          */
 #define IUART_NOISE_ERROR        32  /**< @brief Noise on the line.          */
 #define IUART_BREAK_DETECTED     64  /**< @brief Break detected.             */
+#define IUART_RING_FULL          128 /**< @brief Receive ring overflow.      */
+#define IUART_EVENT_LOST         256 /**< @brief Deferred event dropped.     */
+#define IUART_CRC_ERROR          512 /**< @brief Frame check failed.         */
+/** @} */
+
+/**
+ * @name    IUART deferred event types
+ * @{
+ */
+#define IUART_EV_TXEND1          0   /**< @brief @p txend1_cb event.         */
+#define IUART_EV_TXEND2          1   /**< @brief @p txend2_cb event.         */
+#define IUART_EV_RXEND           2   /**< @brief @p rxend_cb event.          */
+#define IUART_EV_RXCHAR          3   /**< @brief @p rxchar_cb event.         */
+#define IUART_EV_RXERR           4   /**< @brief @p rxerr_cb event.          */
+#define IUART_EV_RXFRAME         5   /**< @brief @p rxframe_cb event.        */
+#define IUART_EV_FLOW            6   /**< @brief @p flow_cb event.           */
+#define IUART_EV_TXURGENT        7   /**< @brief @p txurgent_cb event.       */
+/** @} */
+
+/**
+ * @name    IUART mute mode wakeup methods
+ * @{
+ */
+#define IUART_MUTE_OFF           0   /**< @brief Mute mode not used.         */
+#define IUART_MUTE_IDLE          1   /**< @brief Woken by an idle line.      */
+#define IUART_MUTE_ADDRESS       2   /**< @brief Woken by the node address.  */
+/** @} */
+
+/**
+ * @name    IUART flow control modes
+ * @{
+ */
+#define IUART_FLOW_NONE          0   /**< @brief No flow control.            */
+#define IUART_FLOW_RTSCTS        1   /**< @brief RTS and CTS by the USART.   */
+#define IUART_FLOW_SWRTS         2   /**< @brief CTS by the USART, RTS by
+                                                 @p rts_cb.               */
 /** @} */
 
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @name    IUART configuration options
+ * @{
+ */
+/**
+ * @brief   Enables the receive ring buffer mode.
+ * @details Characters received while no block receive is active are stored
+ *          into a ring buffer supplied by the configuration and read back
+ *          by a thread using @p iuartRead().
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_RXRING) || defined(__DOXYGEN__)
+#define IUART_USE_RXRING            FALSE
+#endif
+
+/**
+ * @brief   Enables the transmit queue.
+ * @details Data written with @p iuartWrite() is copied into a queue
+ *          supplied by the configuration and sent back to back, also
+ *          while another transmission is in progress.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_TXQUEUE) || defined(__DOXYGEN__)
+#define IUART_USE_TXQUEUE           FALSE
+#endif
+
+/**
+ * @brief   Enables hardware frame delimiting.
+ * @details A block receive completes early when the line stays idle for
+ *          the configured receiver timeout or when the match character
+ *          is received.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_FRAMING) || defined(__DOXYGEN__)
+#define IUART_USE_FRAMING           FALSE
+#endif
+
+/**
+ * @brief   Enables deferred callbacks.
+ * @details When an event queue is supplied by the configuration the ISR
+ *          only posts the callback events, a thread invokes the callbacks
+ *          through @p iuartDispatch().
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_DEFERRED) || defined(__DOXYGEN__)
+#define IUART_USE_DEFERRED          FALSE
+#endif
+
+/**
+ * @brief   Enables the @p BaseChannel interface.
+ * @details The driver object can then be used as a stream by @p chprintf(),
+ *          the shell and the other channel based code. Data goes through
+ *          the receive ring and the transmit queue.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_CHANNEL) || defined(__DOXYGEN__)
+#define IUART_USE_CHANNEL           FALSE
+#endif
+
+/**
+ * @brief   Enables the RS-485 driver enable output.
+ * @details The USART drives the transceiver DE pin around each
+ *          transmission with the configured assertion and deassertion
+ *          times, no software direction switching is needed.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_RS485) || defined(__DOXYGEN__)
+#define IUART_USE_RS485             FALSE
+#endif
+
+/**
+ * @brief   Enables the per port statistics.
+ * @details Traffic, error and drop counters, ring high-water marks and
+ *          the USART ISR duration in cycles, read with @p iuartGetStats().
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_STATS) || defined(__DOXYGEN__)
+#define IUART_USE_STATS             FALSE
+#endif
+
+/**
+ * @brief   Enables the Modbus RTU framing mode.
+ * @details The receiver timeout is set to the t3.5 silent interval and
+ *          the frame CRC is computed as the characters arrive, frames
+ *          reach @p rxframe_cb already checked.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_MODBUS) || defined(__DOXYGEN__)
+#define IUART_USE_MODBUS            FALSE
+#endif
+
+/**
+ * @brief   Enables the running CRC of block transfers.
+ * @details The CRC selected by the configuration is computed by the ISR
+ *          as the characters of block sends and receives go through, it
+ *          can also be appended to the sent data.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_CRC) || defined(__DOXYGEN__)
+#define IUART_USE_CRC               FALSE
+#endif
+
+/**
+ * @brief   Enables the port to port bridge mode.
+ * @details Characters received outside of a block receive are put by the
+ *          ISR straight into the transmit queue of another port, no
+ *          thread is involved in the forwarding.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_BRIDGE) || defined(__DOXYGEN__)
+#define IUART_USE_BRIDGE            FALSE
+#endif
+
+/**
+ * @brief   Enables the multiprocessor mute mode.
+ * @details The receiver ignores the traffic until woken by an idle line or
+ *          by an address mark carrying the node address, frames for other
+ *          nodes cause no interrupt.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_MUTE) || defined(__DOXYGEN__)
+#define IUART_USE_MUTE              FALSE
+#endif
+
+/**
+ * @brief   Enables the chained receive buffers.
+ * @details Receive buffers are queued in advance with
+ *          @p iuartQueueReceive(), the ISR moves to the next one without
+ *          gap and the filled ones are fetched in order with
+ *          @p iuartFetchReceive().
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_RXCHAIN) || defined(__DOXYGEN__)
+#define IUART_USE_RXCHAIN           FALSE
+#endif
+
+/**
+ * @brief   Enables the urgent transmit lane.
+ * @details A message started with @p iuartStartSendUrgent() is inserted
+ *          in the block send in progress at the next boundary, the block
+ *          resuming after it.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_TXPRIO) || defined(__DOXYGEN__)
+#define IUART_USE_TXPRIO            FALSE
+#endif
+
+/**
+ * @brief   Enables the RTS/CTS flow control.
+ * @details The sender is stopped when the receive ring reaches its high
+ *          watermark and released when @p iuartRead() brings it down to
+ *          the low watermark.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_FLOWCTL) || defined(__DOXYGEN__)
+#define IUART_USE_FLOWCTL           FALSE
+#endif
+
+/**
+ * @brief   Enables the receive timestamps.
+ * @details A free running counter is latched by the ISR at the first and
+ *          at the last data frame of each block receive.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(IUART_USE_TIMESTAMP) || defined(__DOXYGEN__)
+#define IUART_USE_TIMESTAMP         FALSE
+#endif
+/** @} */
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if IUART_USE_CHANNEL && (!IUART_USE_RXRING || !IUART_USE_TXQUEUE)
+#error "IUART_USE_CHANNEL requires IUART_USE_RXRING and IUART_USE_TXQUEUE"
+#endif
+
+#if IUART_USE_BRIDGE && !IUART_USE_TXQUEUE
+#error "IUART_USE_BRIDGE requires IUART_USE_TXQUEUE"
+#endif
+
+#if IUART_USE_MODBUS && !IUART_USE_FRAMING
+#error "IUART_USE_MODBUS requires IUART_USE_FRAMING"
+#endif
+
+#if IUART_USE_FLOWCTL && !IUART_USE_RXRING
+#error "IUART_USE_FLOWCTL requires IUART_USE_RXRING"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -93,16 +314,357 @@ typedef enum {
   IUART_RX_COMPLETE = 2              /**< Buffer complete.                   */
 } iuartrxstate_t;
 
+#if IUART_USE_DEFERRED || defined(__DOXYGEN__)
+/**
+ * @brief   Deferred callback event.
+ */
+typedef struct {
+  uint32_t                  type;     /**< @brief Event type.                 */
+  uint32_t                  arg;      /**< @brief Character, error mask or
+                                                  frame length.           */
+} iuartevent_t;
+#endif
+
+#if IUART_USE_RXCHAIN || defined(__DOXYGEN__)
+/**
+ * @brief   Chained receive buffer.
+ */
+typedef struct {
+  void                      *buf;     /**< @brief Receive buffer.           */
+  size_t                    n;        /**< @brief Size in data frames, the
+                                                  number received once
+                                                  filled.                 */
+} iuartrxdesc_t;
+#endif
+
+#if IUART_USE_TIMESTAMP || defined(__DOXYGEN__)
+/**
+ * @brief   Block receive timestamps, in counter ticks.
+ */
+typedef struct {
+  uint32_t                  start;    /**< @brief First data frame.       */
+  uint32_t                  end;      /**< @brief Last data frame.        */
+} iuartstamp_t;
+#endif
+
+#if IUART_USE_CRC || defined(__DOXYGEN__)
+/**
+ * @brief   CRC algorithm, initialized by @p iuartCRCObjectInit().
+ * @details Reflected algorithms keep the CRC in the low bits, the others
+ *          keep it left aligned, so any width up to 32 bits costs a table
+ *          lookup per character.
+ */
+typedef struct {
+  uint32_t                  table[256]; /**< @brief Lookup table.         */
+  uint32_t                  init;     /**< @brief Initial register value. */
+  uint32_t                  xorout;   /**< @brief Final XOR value.        */
+  uint8_t                   width;    /**< @brief CRC width in bits.      */
+  bool                      reflected; /**< @brief LSB first algorithm.   */
+} iuartcrc_t;
+#endif
+
+#if IUART_USE_STATS || defined(__DOXYGEN__)
+/**
+ * @brief   IUART statistics.
+ * @note    The ISR cycle figures stay zero on cores without a cycle
+ *          counter.
+ */
+typedef struct {
+  uint32_t                  rxbytes;  /**< @brief Data frames received.     */
+  uint32_t                  txbytes;  /**< @brief Data frames sent.         */
+  uint32_t                  parity;   /**< @brief Parity errors.            */
+  uint32_t                  framing;  /**< @brief Framing errors.           */
+  uint32_t                  overrun;  /**< @brief Overrun errors.           */
+  uint32_t                  noise;    /**< @brief Noise errors.             */
+  uint32_t                  breaks;   /**< @brief Breaks detected.          */
+  uint32_t                  dropped;  /**< @brief Characters lost on a
+                                                  full receive ring.      */
+  size_t                    rxhwm;    /**< @brief Receive ring high-water
+                                                  mark.                   */
+  size_t                    txhwm;    /**< @brief Transmit queue high-water
+                                                  mark.                   */
+  uint32_t                  isrcount; /**< @brief USART ISR invocations.    */
+  uint32_t                  isrmin;   /**< @brief Shortest ISR, cycles.     */
+  uint32_t                  isrmax;   /**< @brief Longest ISR, cycles.      */
+  uint32_t                  isrmean;  /**< @brief Mean ISR, cycles, only
+                                                  valid in snapshots.     */
+  uint64_t                  isrtotal; /**< @brief Cumulative ISR cycles.    */
+} iuartstats_t;
+#endif
+
+#if IUART_USE_CHANNEL || defined(__DOXYGEN__)
+/**
+ * @brief   @p IUARTDriver virtual methods table.
+ */
+struct IUARTDriverVMT {
+  _base_channel_methods
+};
+#endif
+
 #include "iuart_driver_lld.h"
 
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
 
+#if IUART_USE_FRAMING || defined(__DOXYGEN__)
+/**
+ * @brief   Frame delimiter setting for the @p match configuration field.
+ *
+ * @param[in] c         delimiter character
+ */
+#define IUART_MATCH(c)          (0x100U | (uint8_t)(c))
+#endif
+
+#if IUART_USE_MODBUS || defined(__DOXYGEN__)
+/**
+ * @brief   Modbus CRC initial value.
+ */
+#define IUART_MODBUS_CRC_INIT   0xFFFFU
+
+/**
+ * @brief   Adds a character to a running Modbus CRC.
+ * @details A frame followed by its own CRC, low byte first, leaves a zero
+ *          CRC.
+ *
+ * @param[in] crc       running CRC
+ * @param[in] c         character
+ */
+#define IUART_MODBUS_CRC_UPDATE(crc, c)                                     \
+  ((uint16_t)(((crc) >> 8) ^ iuart_crc16_table[((crc) ^ (c)) & 0xFFU]))
+#endif
+
+#if IUART_USE_CRC || defined(__DOXYGEN__)
+/**
+ * @brief   Adds a character to a running CRC.
+ * @note    This macro is meant to be used in the driver implementation
+ *          only.
+ *
+ * @param[in] cp        pointer to the @p iuartcrc_t object
+ * @param[in] crc       running CRC
+ * @param[in] c         character
+ *
+ * @notapi
+ */
+#define _iuart_crc_update(cp, crc, c)                                       \
+  ((cp)->reflected ?                                                        \
+   ((crc) >> 8) ^ (cp)->table[((crc) ^ (c)) & 0xFFU] :                      \
+   ((crc) << 8) ^ (cp)->table[(((crc) >> 24) ^ (c)) & 0xFFU])
+
+/**
+ * @brief   Final CRC value from the running CRC.
+ * @note    This macro is meant to be used in the driver implementation
+ *          only.
+ *
+ * @param[in] cp        pointer to the @p iuartcrc_t object
+ * @param[in] crc       running CRC
+ *
+ * @notapi
+ */
+#define _iuart_crc_final(cp, crc)                                           \
+  (((cp)->reflected ? (crc) : (crc) >> (32U - (cp)->width)) ^ (cp)->xorout)
+#endif
+
+#if IUART_USE_STATS || defined(__DOXYGEN__)
+/**
+ * @brief   Adds to a statistics counter.
+ * @note    This macro is meant to be used in the driver implementation
+ *          only.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] field     counter in @p iuartstats_t
+ * @param[in] n         amount to add
+ *
+ * @notapi
+ */
+#define _iuart_stats_add(iuartp, field, n)                                  \
+  ((iuartp)->stats.field += (n))
+
+/**
+ * @brief   Raises a statistics high-water mark.
+ * @note    This macro is meant to be used in the driver implementation
+ *          only.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] field     mark in @p iuartstats_t
+ * @param[in] v         current level
+ *
+ * @notapi
+ */
+#define _iuart_stats_max(iuartp, field, v)                                  \
+  ((v) > (iuartp)->stats.field ? (void)((iuartp)->stats.field = (v)) :      \
+                                 (void)0)
+#else
+#define _iuart_stats_add(iuartp, field, n)  ((void)0)
+#define _iuart_stats_max(iuartp, field, v)  ((void)0)
+#endif
+
+#if IUART_USE_DEFERRED || defined(__DOXYGEN__)
+/**
+ * @brief   Posts a callback event to the dispatcher.
+ * @details A full queue drops the event and marks the loss, reported later
+ *          as @p IUART_EVENT_LOST.
+ * @note    This macro is meant to be used in the low level drivers
+ *          implementation only.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] ev        event type
+ * @param[in] a         event argument
+ *
+ * @notapi
+ */
+#define _iuart_post_isr(iuartp, ev, a) {                                    \
+  size_t evh = (iuartp)->evhead;                                            \
+  if (evh - (iuartp)->evtail < (iuartp)->config->evq_size) {                \
+    iuartevent_t *evp = &(iuartp)->config->evq[evh &                        \
+                                      ((iuartp)->config->evq_size - 1)];    \
+    evp->type = (ev);                                                       \
+    evp->arg  = (uint32_t)(a);                                              \
+    (iuartp)->evhead = evh + 1;                                             \
+  }                                                                         \
+  else                                                                      \
+    (iuartp)->evlost = true;                                                \
+  if ((iuartp)->evthread != NULL) {                                         \
+    osalSysLockFromISR();                                                   \
+    osalThreadResumeI(&(iuartp)->evthread, MSG_OK);                         \
+    osalSysUnlockFromISR();                                                 \
+  }                                                                         \
+}
+
+/**
+ * @brief   Common ISR code, callback notification.
+ * @details The callback is invoked directly or, with an event queue in
+ *          configuration, deferred to @p iuartDispatch().
+ * @note    This macro is meant to be used in the low level drivers
+ *          implementation only.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] cb        name of the callback field in @p IUARTConfig
+ * @param[in] ev        event type
+ * @param[in] a         event argument
+ * @param[in] args      parenthesized callback arguments
+ *
+ * @notapi
+ */
+#define _iuart_notify_isr(iuartp, cb, ev, a, args) {                        \
+  if ((iuartp)->config->cb != NULL) {                                       \
+    if ((iuartp)->config->evq != NULL)                                      \
+      _iuart_post_isr(iuartp, ev, a)                                        \
+    else                                                                    \
+      (iuartp)->config->cb args;                                            \
+  }                                                                         \
+}
+#else /* !IUART_USE_DEFERRED */
+#define _iuart_notify_isr(iuartp, cb, ev, a, args) {                        \
+  if ((iuartp)->config->cb != NULL)                                         \
+    (iuartp)->config->cb args;                                              \
+}
+#endif /* !IUART_USE_DEFERRED */
+
+#if IUART_USE_RXRING || defined(__DOXYGEN__)
+/**
+ * @brief   Wakes up the ring reader, if any.
+ * @note    This macro is meant to be used in the low level drivers
+ *          implementation only.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @notapi
+ */
+#define _iuart_rx_ring_wakeup_isr(iuartp) {                                 \
+  if ((iuartp)->rxthread != NULL) {                                         \
+    osalSysLockFromISR();                                                   \
+    osalThreadResumeI(&(iuartp)->rxthread, MSG_OK);                         \
+    osalSysUnlockFromISR();                                                 \
+  }                                                                         \
+}
+
+/**
+ * @brief   Common ISR code, character received in ring mode.
+ * @details This code handles the portable part of the ISR code:
+ *          - Storing the character into the ring.
+ *          - Waking up the reader once the threshold is reached.
+ *          - Error callback invocation on ring overflow.
+ *          .
+ * @note    The ring is written only here and read only by @p iuartRead(),
+ *          so the indexes need no locking.
+ * @note    This macro is meant to be used in the low level drivers
+ *          implementation only.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] c         received character
+ *
+ * @notapi
+ */
+#define _iuart_rx_ring_put_isr(iuartp, c) {                                 \
+  size_t head = (iuartp)->rxhead;                                           \
+  size_t used = head - (iuartp)->rxtail;                                    \
+  if (used < (iuartp)->config->rxring_size) {                               \
+    (iuartp)->config->rxring[head & ((iuartp)->config->rxring_size - 1)] =  \
+                                                              (uint8_t)(c); \
+    (iuartp)->rxhead = head + 1;                                            \
+    _iuart_stats_max(iuartp, rxhwm, used + 1);                              \
+    if (used + 1 >= (iuartp)->config->rxthreshold)                          \
+      _iuart_rx_ring_wakeup_isr(iuartp);                                    \
+  }                                                                         \
+  else {                                                                    \
+    _iuart_stats_add(iuartp, dropped, 1);                                   \
+    _iuart_notify_isr(iuartp, rxerr_cb, IUART_EV_RXERR, IUART_RING_FULL,    \
+                      (iuartp, IUART_RING_FULL))                            \
+  }                                                                         \
+}
+#endif /* IUART_USE_RXRING */
+
+#if IUART_USE_RXCHAIN || defined(__DOXYGEN__)
+/**
+ * @brief   Wakes up the thread waiting for a filled buffer, if any.
+ * @note    This macro is meant to be used in the low level drivers
+ *          implementation only.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @notapi
+ */
+#define _iuart_rx_chain_wakeup_isr(iuartp) {                                \
+  if ((iuartp)->chthread != NULL) {                                         \
+    osalSysLockFromISR();                                                   \
+    osalThreadResumeI(&(iuartp)->chthread, MSG_OK);                         \
+    osalSysUnlockFromISR();                                                 \
+  }                                                                         \
+}
+#endif /* IUART_USE_RXCHAIN */
+
+#if IUART_USE_TXQUEUE || defined(__DOXYGEN__)
+/**
+ * @brief   Wakes up a writer waiting for queue space, if any.
+ * @details The writer is woken once half of the queue is free, so a long
+ *          write costs a few wakeups instead of one per character.
+ * @note    This macro is meant to be used in the low level drivers
+ *          implementation only.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @notapi
+ */
+#define _iuart_tx_queue_wakeup_isr(iuartp) {                                \
+  if (((iuartp)->txthread != NULL) &&                                       \
+      ((iuartp)->txhead - (iuartp)->txtail <=                               \
+                                   (iuartp)->config->txring_size / 2)) {    \
+    osalSysLockFromISR();                                                   \
+    osalThreadResumeI(&(iuartp)->txthread, MSG_OK);                         \
+    osalSysUnlockFromISR();                                                 \
+  }                                                                         \
+}
+#endif /* IUART_USE_TXQUEUE */
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
 
+#if IUART_USE_MODBUS && !defined(__DOXYGEN__)
+extern const uint16_t iuart_crc16_table[256];
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -118,6 +680,56 @@ extern "C" {
   void iuartStartReceiveI(IUARTDriver *iuartp, size_t n, void *rxbuf);
   size_t iuartStopReceive(IUARTDriver *iuartp);
   size_t iuartStopReceiveI(IUARTDriver *iuartp);
+  uint32_t iuartGetBaudRate(IUARTDriver *iuartp, int32_t *errp);
+#if IUART_USE_RXRING
+  size_t iuartRead(IUARTDriver *iuartp, uint8_t *bp, size_t n,
+                   systime_t timeout);
+  size_t iuartReadAvailable(IUARTDriver *iuartp);
+#endif
+#if IUART_USE_TXQUEUE
+  size_t iuartWrite(IUARTDriver *iuartp, const uint8_t *bp, size_t n);
+  size_t iuartWriteI(IUARTDriver *iuartp, const uint8_t *bp, size_t n);
+  size_t iuartWriteSpace(IUARTDriver *iuartp);
+  size_t iuartWriteTimeout(IUARTDriver *iuartp, const uint8_t *bp, size_t n,
+                           systime_t timeout);
+#endif
+#if IUART_USE_DEFERRED
+  msg_t iuartDispatch(IUARTDriver *iuartp, systime_t timeout);
+#endif
+#if IUART_USE_MODBUS
+  uint16_t iuartModbusCRC(const uint8_t *bp, size_t n);
+#endif
+#if IUART_USE_RXCHAIN
+  bool iuartQueueReceive(IUARTDriver *iuartp, size_t n, void *rxbuf);
+  bool iuartQueueReceiveI(IUARTDriver *iuartp, size_t n, void *rxbuf);
+  size_t iuartFetchReceive(IUARTDriver *iuartp, void **bufp,
+                           systime_t timeout);
+#endif
+#if IUART_USE_TIMESTAMP
+  void iuartGetRxTimestamp(IUARTDriver *iuartp, iuartstamp_t *sp);
+#endif
+#if IUART_USE_TXPRIO
+  bool iuartStartSendUrgent(IUARTDriver *iuartp, size_t n, const void *txbuf);
+  bool iuartStartSendUrgentI(IUARTDriver *iuartp, size_t n,
+                             const void *txbuf);
+#endif
+#if IUART_USE_MUTE
+  void iuartMute(IUARTDriver *iuartp);
+  void iuartMuteI(IUARTDriver *iuartp);
+#endif
+#if IUART_USE_CRC
+  void iuartCRCObjectInit(iuartcrc_t *cp, uint8_t width, uint32_t poly,
+                          uint32_t init, uint32_t xorout, bool reflected);
+  uint32_t iuartCRCUpdate(const iuartcrc_t *cp, uint32_t crc,
+                          const uint8_t *bp, size_t n);
+  uint32_t iuartCRC(const iuartcrc_t *cp, const uint8_t *bp, size_t n);
+  uint32_t iuartGetRxCRC(IUARTDriver *iuartp);
+  uint32_t iuartGetTxCRC(IUARTDriver *iuartp);
+#endif
+#if IUART_USE_STATS
+  void iuartGetStats(IUARTDriver *iuartp, iuartstats_t *sp);
+  void iuartResetStats(IUARTDriver *iuartp);
+#endif
 #ifdef __cplusplus
 }
 #endif
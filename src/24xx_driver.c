@@ -109,21 +109,42 @@ static systime_t calc_timeout(I2CDriver *i2cp, size_t txbytes, size_t rxbytes) {
 /**
  * @brief   EEPROM read routine.
  *
- * @param[in] eepcfg    pointer to configuration structure of eeprom file
+ * @param[in] cfg       pointer to configuration structure of eeprom file
  * @param[in] offset    addres of 1-st byte to be read
  * @param[in] data      pointer to buffer with data to be written
  * @param[in] len       number of bytes to be red
  */
-static msg_t eeprom_read(const I2CEepromFileConfig *eepcfg,
-                         uint32_t offset, uint8_t *data, size_t len) {
+msg_t eeprom_24xx_read(const EepromFileConfig *cfg,
+                       uint32_t offset, uint8_t *data, size_t len) {
 
+  const I2CEepromFileConfig *eepcfg = (const I2CEepromFileConfig *)cfg;
   msg_t status = MSG_RESET;
-  systime_t tmo = calc_timeout(eepcfg->i2cp, 2, len);
+  uint32_t addr = offset + eepcfg->barrier_low;
+  systime_t tmo;
+#if defined(STM32F1XX_I2C)
+  uint8_t __buf[2];
+  uint8_t *dst = NULL;
+#endif
 
   osalDbgAssert(((len <= eepcfg->size) && ((offset + len) <= eepcfg->size)),
              "out of device bounds");
 
-  eeprom_split_addr(eepcfg->write_buf, (offset + eepcfg->barrier_low));
+  /* Stupid I2C cell in STM32F1x does not allow to read single byte.
+     So we must read 2 bytes and return needed one. Dummy byte is the
+     following one, or the preceding one for the last byte of IC. Device
+     address is used, so file offset 0 never wraps around. */
+#if defined(STM32F1XX_I2C)
+  if (len == 1) {
+    dst  = data;
+    data = __buf;
+    len  = 2;
+    if ((addr + 1) >= eepcfg->size)
+      addr--;
+  }
+#endif /* defined(STM32F1XX_I2C) */
+
+  tmo = calc_timeout(eepcfg->i2cp, 2, len);
+  eeprom_split_addr(eepcfg->write_buf, addr);
 
 #if I2C_USE_MUTUAL_EXCLUSION
   i2cAcquireBus(eepcfg->i2cp);
@@ -136,21 +157,29 @@ static msg_t eeprom_read(const I2CEepromFileConfig *eepcfg,
   i2cReleaseBus(eepcfg->i2cp);
 #endif
 
+#if defined(STM32F1XX_I2C)
+  if (dst != NULL)
+    dst[0] = (addr == (offset + eepcfg->barrier_low)) ? __buf[0] : __buf[1];
+#endif /* defined(STM32F1XX_I2C) */
+
   return status;
 }
 
 /**
  * @brief   EEPROM write routine.
- * @details Function writes data to EEPROM.
+ * @details Function writes data to EEPROM. Waiting for the end of write
+ *          cycle is performed by the common transfer engine.
  * @pre     Data must be fit to single EEPROM page.
  *
- * @param[in] eepcfg  pointer to configuration structure of eeprom file
+ * @param[in] cfg     pointer to configuration structure of eeprom file
  * @param[in] offset  addres of 1-st byte to be write
  * @param[in] data    pointer to buffer with data to be written
  * @param[in] len     number of bytes to be written
  */
-static msg_t eeprom_write(const I2CEepromFileConfig *eepcfg, uint32_t offset,
-                          const uint8_t *data, size_t len) {
+msg_t eeprom_24xx_write(const EepromFileConfig *cfg, uint32_t offset,
+                        const uint8_t *data, size_t len) {
+
+  const I2CEepromFileConfig *eepcfg = (const I2CEepromFileConfig *)cfg;
   msg_t status = MSG_RESET;
   systime_t tmo = calc_timeout(eepcfg->i2cp, (len + 2), 0);
 
@@ -176,39 +205,18 @@ static msg_t eeprom_write(const I2CEepromFileConfig *eepcfg, uint32_t offset,
   i2cReleaseBus(eepcfg->i2cp);
 #endif
 
-  /* wait until EEPROM process data */
-  chThdSleep(eepcfg->write_time);
-
   return status;
 }
 
 /**
- * @brief   Determines and returns size of data that can be processed
+ * @brief   Page operations used by common transfer engine.
+ * @note    24XX has no status register, engine waits @p write_time.
  */
-static size_t __clamp_size(void *ip, size_t n) {
-
-  if ((eepfs_getposition(ip) + n) > eepfs_getsize(ip))
-    return eepfs_getsize(ip) - eepfs_getposition(ip);
-  else
-    return n;
-}
-
-/**
- * @brief   Write data that can be fitted in one page boundary
- */
-static void __fitted_write(void *ip, const uint8_t *data, size_t len, uint32_t *written) {
-
-  msg_t status = MSG_RESET;
-
-  osalDbgAssert(len != 0, "something broken in hi level part");
-
-  status = eeprom_write(((I2CEepromFileStream *)ip)->cfg,
-                        eepfs_getposition(ip), data, len);
-  if (status == MSG_OK) {
-    *written += len;
-    eepfs_lseek(ip, eepfs_getposition(ip) + len);
-  }
-}
+static const EepromBackendOps ops = {
+  eeprom_24xx_read,
+  eeprom_24xx_write,
+  NULL
+};
 
 /**
  * @brief     Write data to EEPROM.
@@ -219,60 +227,7 @@ static void __fitted_write(void *ip, const uint8_t *data, size_t len, uint32_t *
  */
 static size_t write(void *ip, const uint8_t *bp, size_t n) {
 
-  size_t   len = 0;     /* bytes to be written at one trasaction */
-  uint32_t written; /* total bytes successfully written */
-  uint16_t pagesize;
-  uint32_t firstpage;
-  uint32_t lastpage;
-
-  osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
-
-  if (n == 0)
-    return 0;
-
-  n = __clamp_size(ip, n);
-  if (n == 0)
-    return 0;
-
-  pagesize  =  ((EepromFileStream *)ip)->cfg->pagesize;
-  firstpage = (((EepromFileStream *)ip)->cfg->barrier_low +
-               eepfs_getposition(ip)) / pagesize;
-  lastpage  = (((EepromFileStream *)ip)->cfg->barrier_low +
-               eepfs_getposition(ip) + n - 1) / pagesize;
-
-  written = 0;
-  /* data fitted in single page */
-  if (firstpage == lastpage) {
-    len = n;
-    __fitted_write(ip, bp, len, &written);
-    bp += len;
-    return written;
-  }
-
-  else {
-    /* write first piece of data to first page boundary */
-    len =  ((firstpage + 1) * pagesize) - eepfs_getposition(ip);
-    len -= ((EepromFileStream *)ip)->cfg->barrier_low;
-    __fitted_write(ip, bp, len, &written);
-    bp += len;
-
-    /* now writes blocks at a size of pages (may be no one) */
-    while ((n - written) > pagesize) {
-      len = pagesize;
-      __fitted_write(ip, bp, len, &written);
-      bp += len;
-    }
-
-    /* wrtie tail */
-    len = n - written;
-    if (len == 0)
-      return written;
-    else {
-      __fitted_write(ip, bp, len, &written);
-    }
-  }
-
-  return written;
+  return eepfs_write(ip, &ops, bp, n);
 }
 
 /**
@@ -281,54 +236,8 @@ static size_t write(void *ip, const uint8_t *bp, size_t n) {
  * of read bytes.
  */
 static size_t read(void *ip, uint8_t *bp, size_t n) {
-  msg_t status = MSG_OK;
 
-  osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
-
-  if (n == 0)
-    return 0;
-
-  n = __clamp_size(ip, n);
-  if (n == 0)
-    return 0;
-
-  /* Stupid I2C cell in STM32F1x does not allow to read single byte.
-     So we must read 2 bytes and return needed one. */
-#if defined(STM32F1XX_I2C)
-  if (n == 1) {
-    uint8_t __buf[2];
-    /* if NOT last byte of file requested */
-    if ((eepfs_getposition(ip) + 1) < eepfs_getsize(ip)) {
-      if (read(ip, __buf, 2) == 2) {
-        eepfs_lseek(ip, (eepfs_getposition(ip) + 1));
-        bp[0] = __buf[0];
-        return 1;
-      }
-      else
-        return 0;
-    }
-    else {
-      eepfs_lseek(ip, (eepfs_getposition(ip) - 1));
-      if (read(ip, __buf, 2) == 2) {
-        eepfs_lseek(ip, (eepfs_getposition(ip) + 2));
-        bp[0] = __buf[1];
-        return 1;
-      }
-      else
-        return 0;
-    }
-  }
-#endif /* defined(STM32F1XX_I2C) */
-
-  /* call low level function */
-  status  = eeprom_read(((I2CEepromFileStream *)ip)->cfg,
-                        eepfs_getposition(ip), bp, n);
-  if (status != MSG_OK)
-    return 0;
-  else {
-    eepfs_lseek(ip, (eepfs_getposition(ip) + n));
-    return n;
-  }
+  return eepfs_read(ip, &ops, bp, n);
 }
 
 static const struct EepromFileStreamVMT vmt = {
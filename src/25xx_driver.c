@@ -96,9 +96,9 @@ static void ll_25xx_transmit_receive(const SPIEepromFileConfig *eepcfg,
 
   spiStart(eepcfg->spip, eepcfg->spicfg);
   spiSelect(eepcfg->spip);
-  spiSend(eepcfg->spip, txlen, &txbuf);
+  spiSend(eepcfg->spip, txlen, txbuf);
   if (rxlen) /* Check if receive is needed. */
-    spiReceive(eepcfg->spip, rxlen, &rxbuf);
+    spiReceive(eepcfg->spip, rxlen, rxbuf);
   spiUnselect(eepcfg->spip);
 
 #if SPI_USE_MUTUAL_EXCLUSION
@@ -122,17 +122,6 @@ static bool ll_eeprom_is_busy(const SPIEepromFileConfig *eepcfg) {
   return FALSE;
 }
 
-/**
- * @brief Lock device.
- *
- * @param[in] eepcfg  pointer to configuration structure of eeprom file.
- */
-static void ll_eeprom_lock(const SPIEepromFileConfig *eepcfg) {
-
-  uint8_t cmd = CMD_WRDI;
-  ll_25xx_transmit_receive(eepcfg, &cmd, 1, NULL, 0);
-}
-
 /**
  * @brief Unlock device.
  *
@@ -180,14 +169,15 @@ static uint8_t ll_eeprom_prepare_seq(uint8_t *seq, uint32_t size, uint8_t cmd,
 /**
  * @brief   EEPROM read routine.
  *
- * @param[in]  eepcfg   pointer to configuration structure of eeprom file.
+ * @param[in]  cfg      pointer to configuration structure of eeprom file.
  * @param[in]  offset   addres of 1-st byte to be read.
  * @param[out] data     pointer to buffer with data to be written.
  * @param[in]  len      number of bytes to be red.
  */
-static msg_t ll_eeprom_read(const SPIEepromFileConfig *eepcfg, uint32_t offset,
-                            uint8_t *data, size_t len) {
+msg_t eeprom_25xx_read(const EepromFileConfig *cfg, uint32_t offset,
+                       uint8_t *data, size_t len) {
 
+  const SPIEepromFileConfig *eepcfg = (const SPIEepromFileConfig *)cfg;
   uint8_t txbuff[4];
   uint8_t txlen;
 
@@ -203,20 +193,22 @@ static msg_t ll_eeprom_read(const SPIEepromFileConfig *eepcfg, uint32_t offset,
 
 /**
  * @brief   EEPROM write routine.
- * @details Function writes data to EEPROM.
+ * @details Function writes data to EEPROM. Waiting for the end of write
+ *          cycle is performed by the common transfer engine. Write enable
+ *          latch is reset by IC itself at the end of write cycle.
  * @pre     Data must be fit to single EEPROM page.
  *
- * @param[in] eepcfg  pointer to configuration structure of eeprom file.
+ * @param[in] cfg     pointer to configuration structure of eeprom file.
  * @param[in] offset  addres of 1-st byte to be writen.
  * @param[in] data    pointer to buffer with data to be written.
  * @param[in] len     number of bytes to be written.
  */
-static msg_t ll_eeprom_write(const SPIEepromFileConfig *eepcfg, uint32_t offset,
-                             const uint8_t *data, size_t len) {
+msg_t eeprom_25xx_write(const EepromFileConfig *cfg, uint32_t offset,
+                        const uint8_t *data, size_t len) {
 
+  const SPIEepromFileConfig *eepcfg = (const SPIEepromFileConfig *)cfg;
   uint8_t txbuff[4];
   uint8_t txlen;
-  systime_t now;
 
   osalDbgAssert(((len <= eepcfg->size) && ((offset + len) <= eepcfg->size)),
              "out of device bounds");
@@ -243,48 +235,28 @@ static msg_t ll_eeprom_write(const SPIEepromFileConfig *eepcfg, uint32_t offset,
   spiReleaseBus(eepcfg->spip);
 #endif
 
-  /* Wait until EEPROM process data. */
-  now = chVTGetSystemTimeX();
-  while (ll_eeprom_is_busy(eepcfg)) {
-    if ((chVTGetSystemTimeX() - now) > eepcfg->write_time) {
-      return MSG_TIMEOUT;
-    }
-
-    chThdYield();
-  }
-
-  /* Lock array preventing unexpected access */
-  ll_eeprom_lock(eepcfg);
   return MSG_OK;
 }
 
 /**
- * @brief   Determines and returns size of data that can be processed
+ * @brief Check whether the device is busy (writing in progress).
+ *
+ * @param[in] cfg   pointer to configuration structure of eeprom file.
+ * @return @p true on busy.
  */
-static size_t __clamp_size(void *ip, size_t n) {
+bool eeprom_25xx_is_busy(const EepromFileConfig *cfg) {
 
-  if ((eepfs_getposition(ip) + n) > eepfs_getsize(ip))
-    return eepfs_getsize(ip) - eepfs_getposition(ip);
-  else
-    return n;
+  return ll_eeprom_is_busy((const SPIEepromFileConfig *)cfg);
 }
 
 /**
- * @brief   Write data that can be fitted in one page boundary
+ * @brief   Page operations used by common transfer engine.
  */
-static void __fitted_write(void *ip, const uint8_t *data, size_t len, uint32_t *written) {
-
-  msg_t status = MSG_RESET;
-
-  osalDbgAssert(len != 0, "something broken in hi level part");
-
-  status = ll_eeprom_write(((SPIEepromFileStream *)ip)->cfg,
-                           eepfs_getposition(ip), data, len);
-  if (status == MSG_OK) {
-    *written += len;
-    eepfs_lseek(ip, eepfs_getposition(ip) + len);
-  }
-}
+static const EepromBackendOps ops = {
+  eeprom_25xx_read,
+  eeprom_25xx_write,
+  eeprom_25xx_is_busy
+};
 
 /**
  * @brief     Write data to EEPROM.
@@ -295,57 +267,7 @@ static void __fitted_write(void *ip, const uint8_t *data, size_t len, uint32_t *
  */
 static size_t write(void *ip, const uint8_t *bp, size_t n) {
 
-  size_t   len = 0;     /* bytes to be written at one trasaction */
-  uint32_t written; /* total bytes successfully written */
-  uint16_t pagesize;
-  uint32_t firstpage;
-  uint32_t lastpage;
-
-  osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
-
-  if (n == 0)
-    return 0;
-
-  n = __clamp_size(ip, n);
-  if (n == 0)
-    return 0;
-
-  pagesize  = ((EepromFileStream *)ip)->cfg->pagesize;
-  firstpage = (((EepromFileStream *)ip)->cfg->barrier_low + eepfs_getposition(ip)) / pagesize;
-  lastpage  = (((EepromFileStream *)ip)->cfg->barrier_low + eepfs_getposition(ip) + n - 1) / pagesize;
-
-  written = 0;
-  /* data fitted in single page */
-  if (firstpage == lastpage) {
-    len = n;
-    __fitted_write(ip, bp, len, &written);
-    bp += len;
-    return written;
-  }
-  else {
-    /* write first piece of data to first page boundary */
-    len =  ((firstpage + 1) * pagesize) - eepfs_getposition(ip);
-    len -= ((EepromFileStream *)ip)->cfg->barrier_low;
-    __fitted_write(ip, bp, len, &written);
-    bp += len;
-
-    /* now writes blocks at a size of pages (may be no one) */
-    while ((n - written) > pagesize) {
-      len = pagesize;
-      __fitted_write(ip, bp, len, &written);
-      bp += len;
-    }
-
-    /* wrtie tail */
-    len = n - written;
-    if (len == 0)
-      return written;
-    else {
-      __fitted_write(ip, bp, len, &written);
-    }
-  }
-
-  return written;
+  return eepfs_write(ip, &ops, bp, n);
 }
 
 /**
@@ -355,26 +277,7 @@ static size_t write(void *ip, const uint8_t *bp, size_t n) {
  */
 static size_t read(void *ip, uint8_t *bp, size_t n) {
 
-  msg_t status = MSG_OK;
-
-  osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
-
-  if (n == 0)
-    return 0;
-
-  n = __clamp_size(ip, n);
-  if (n == 0)
-    return 0;
-
-  /* call low level function */
-  status = ll_eeprom_read(((SPIEepromFileStream *)ip)->cfg,
-                          eepfs_getposition(ip), bp, n);
-  if (status != MSG_OK)
-    return 0;
-  else {
-    eepfs_lseek(ip, (eepfs_getposition(ip) + n));
-    return n;
-  }
+  return eepfs_read(ip, &ops, bp, n);
 }
 
 static const struct EepromFileStreamVMT vmt = {
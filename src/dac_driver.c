@@ -284,6 +284,9 @@ void dacStopConversionI(DACDriver *dacp) {
  *          channels number configured into the conversion group and N is the
  *          buffer depth. The samples are sequentially written into the buffer
  *          with no gaps.
+ * @note    With a circular group the conversion never ends by itself, the
+ *          function returns when it is stopped, for example from the
+ *          callback with @p dacStopConversionI().
  *
  * @param[in] dacp      pointer to the @p DACDriver object
  * @param[in] grpp      pointer to a @p DACConversionGroup object
@@ -0,0 +1,199 @@
+/*
+  Copyright (c) 2013 Timon Wong
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/*
+  Copyright 2012 Uladzimir Pylinski aka barthess.
+  You may use this work without restrictions, as long as this notice is included.
+  The work is provided "as is" without warranty of any kind, neither express nor implied.
+*/
+
+
+/**
+ * @file    eeprom_counter.c
+ * @brief   High endurance counter stored in EEPROM file.
+ */
+
+#include "eeprom_counter.h"
+#include <string.h>
+
+#if (defined(DRIVER_USE_EEPROM) && DRIVER_USE_EEPROM &&                     \
+     EEPROM_USE_COUNTER) || defined(__DOXYGEN__)
+
+/*
+ ******************************************************************************
+ * DEFINES
+ ******************************************************************************
+ */
+/* Cell tags of even and odd laps, neither matches erased cell. */
+#define TAG_EVEN          0x5A
+#define TAG_ODD           0xA5
+
+/*
+ *******************************************************************************
+ * LOCAL FUNCTIONS
+ *******************************************************************************
+ */
+
+/**
+ * @brief   Returns tag marking cells in lap started at @p base.
+ */
+static uint8_t lap_tag(const EepromCounter *cnt, uint32_t base) {
+
+  return ((base / (cnt->cfg->ncells + 1U)) & 1) ? TAG_ODD : TAG_EVEN;
+}
+
+/**
+ * @brief   Writes data at given offset of counter.
+ */
+static msg_t counter_write(const EepromCounter *cnt, uint32_t offset,
+                           const uint8_t *data, size_t len) {
+
+  EepromFileStream *efs = cnt->cfg->efs;
+
+  eepfs_lseek(efs, cnt->cfg->offset + offset);
+  if (EepromFileWrite(efs, data, len) != len)
+    return MSG_RESET;
+  return MSG_OK;
+}
+
+/**
+ * @brief   Writes base value.
+ */
+static msg_t counter_write_base(const EepromCounter *cnt, uint32_t base) {
+
+  uint8_t buf[4];
+
+  buf[0] = (uint8_t)(base & 0xFF);
+  buf[1] = (uint8_t)((base >> 8) & 0xFF);
+  buf[2] = (uint8_t)((base >> 16) & 0xFF);
+  buf[3] = (uint8_t)((base >> 24) & 0xFF);
+  return counter_write(cnt, 0, buf, sizeof(buf));
+}
+
+/*
+ *******************************************************************************
+ * EXPORTED FUNCTIONS
+ *******************************************************************************
+ */
+
+/**
+ * @brief   Opens counter and reads its state with single burst read.
+ * @pre     Counter area must be initialized with @p EepromCounterSet()
+ *          once.
+ *
+ * @param[out] cnt      pointer to the @p EepromCounter object
+ * @param[in] cfg       pointer to the @p EepromCounterConfig object
+ */
+msg_t EepromCounterOpen(EepromCounter *cnt, const EepromCounterConfig *cfg) {
+
+  uint8_t buf[EEPROM_COUNTER_SIZE(EEPROM_COUNTER_MAX_CELLS)];
+  size_t len;
+  uint8_t tag;
+
+  osalDbgCheck((cnt != NULL) && (cfg != NULL) && (cfg->efs != NULL));
+  osalDbgAssert((cfg->ncells > 0) &&
+                (cfg->ncells <= EEPROM_COUNTER_MAX_CELLS), "wrong cells number");
+
+  cnt->cfg    = cfg;
+  cnt->base   = 0;
+  cnt->marked = 0;
+
+  len = EEPROM_COUNTER_SIZE(cfg->ncells);
+  eepfs_lseek(cfg->efs, cfg->offset);
+  if (EepromFileRead(cfg->efs, buf, len) != len)
+    return MSG_RESET;
+
+  cnt->base = (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+              ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+  tag = lap_tag(cnt, cnt->base);
+  while ((cnt->marked < cfg->ncells) && (buf[4 + cnt->marked] == tag))
+    cnt->marked++;
+  return MSG_OK;
+}
+
+/**
+ * @brief   Returns counter value.
+ */
+uint32_t EepromCounterGet(const EepromCounter *cnt) {
+
+  osalDbgCheck((cnt != NULL) && (cnt->cfg != NULL));
+
+  return cnt->base + cnt->marked;
+}
+
+/**
+ * @brief   Increments counter.
+ * @details Writes single cell, or base value when all cells are marked.
+ */
+msg_t EepromCounterIncrement(EepromCounter *cnt) {
+
+  uint8_t tag;
+  uint32_t base;
+
+  osalDbgCheck((cnt != NULL) && (cnt->cfg != NULL));
+
+  if (cnt->marked < cnt->cfg->ncells) {
+    tag = lap_tag(cnt, cnt->base);
+    if (counter_write(cnt, 4 + cnt->marked, &tag, 1) != MSG_OK)
+      return MSG_RESET;
+    cnt->marked++;
+  }
+  else {
+    base = cnt->base + cnt->cfg->ncells + 1;
+    if (counter_write_base(cnt, base) != MSG_OK)
+      return MSG_RESET;
+    cnt->base   = base;
+    cnt->marked = 0;
+  }
+  return MSG_OK;
+}
+
+/**
+ * @brief   Sets counter value, also used to initialize counter area.
+ * @details All cells are rewritten, so use it rarely.
+ * @note    Operation is not atomic, counter value is undefined after
+ *          power loss in the middle of it.
+ * @pre     Counter must be opened with @p EepromCounterOpen(), its status
+ *          may be ignored when the area is not initialized yet.
+ */
+msg_t EepromCounterSet(EepromCounter *cnt, uint32_t value) {
+
+  uint8_t cells[EEPROM_COUNTER_MAX_CELLS];
+
+  osalDbgCheck((cnt != NULL) && (cnt->cfg != NULL));
+  osalDbgAssert((cnt->cfg->ncells > 0) &&
+                (cnt->cfg->ncells <= EEPROM_COUNTER_MAX_CELLS),
+                "wrong cells number");
+
+  /* Unmark all cells for the lap of new base. */
+  memset(cells, (lap_tag(cnt, value) == TAG_EVEN) ? TAG_ODD : TAG_EVEN,
+         cnt->cfg->ncells);
+  if ((counter_write(cnt, 4, cells, cnt->cfg->ncells) != MSG_OK) ||
+      (counter_write_base(cnt, value) != MSG_OK))
+    return MSG_RESET;
+
+  cnt->base   = value;
+  cnt->marked = 0;
+  return MSG_OK;
+}
+
+#endif /* DRIVER_USE_EEPROM && EEPROM_USE_COUNTER */
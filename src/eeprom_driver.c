@@ -31,8 +31,7 @@
 #include "eeprom_driver.h"
 #include <string.h>
 
-extern EepromDevice eepdev_24xx;
-extern EepromDevice eepdev_25xx;
+#if !EEPROM_USE_STATIC_BINDING
 
 EepromDevice *__eeprom_drv_table[] = {
   /* I2C related. */
@@ -75,6 +74,8 @@ const EepromDevice *EepromFindDevice(const char *name) {
   return NULL;
 }
 
+#endif /* !EEPROM_USE_STATIC_BINDING */
+
 /**
  * Open EEPROM IC as file and return pointer to the file stream object
  * @note      Fucntion allways successfully open file. All checking makes
@@ -95,43 +96,180 @@ EepromFileStream *EepromFileOpen(EepromFileStream *efs,
   efs->cfg      = eepcfg;
   efs->errors   = FILE_OK;
   efs->position = 0;
+  /* Power of two pages are split using mask instead of division. */
+  if ((eepcfg->pagesize & (eepcfg->pagesize - 1)) == 0)
+    efs->pagemask = eepcfg->pagesize - 1;
+  else
+    efs->pagemask = 0;
   return (EepromFileStream *)efs;
 }
 
+/**
+ * @brief   Determines and returns size of data that can be processed
+ */
+static size_t __clamp_size(void *ip, size_t n) {
+
+  if ((eepfs_getposition(ip) + n) > eepfs_getsize(ip))
+    return eepfs_getsize(ip) - eepfs_getposition(ip);
+  else
+    return n;
+}
+
+#if EEPROM_USE_STATIC_BINDING
+/* Device routines are called directly, operations table is not used. */
+#define __ll_read(ops, cfg, offset, data, len)                              \
+  eeprom_static_read(cfg, offset, data, len)
+#define __ll_write(ops, cfg, offset, data, len)                             \
+  eeprom_static_write(cfg, offset, data, len)
+#define __ll_has_busy(ops)          EEPROM_STATIC_HAS_BUSY
+#define __ll_is_busy(ops, cfg)      eeprom_static_is_busy(cfg)
+#else
+#define __ll_read(ops, cfg, offset, data, len)                              \
+  (ops)->read(cfg, offset, data, len)
+#define __ll_write(ops, cfg, offset, data, len)                             \
+  (ops)->write(cfg, offset, data, len)
+#define __ll_has_busy(ops)          ((ops)->is_busy != NULL)
+#define __ll_is_busy(ops, cfg)      (ops)->is_busy(cfg)
+#endif
+
+/**
+ * @brief   Waits until device finishes write cycle.
+ */
+static msg_t __wait_ready(const EepromBackendOps *ops,
+                          const EepromFileConfig *cfg) {
+
+  (void)ops;
+  if (!__ll_has_busy(ops)) {
+    chThdSleep(cfg->write_time);
+    return MSG_OK;
+  }
+
+#if !EEPROM_USE_STATIC_BINDING || EEPROM_STATIC_HAS_BUSY
+  {
+    systime_t now = chVTGetSystemTimeX();
+    while (__ll_is_busy(ops, cfg)) {
+      if ((chVTGetSystemTimeX() - now) > cfg->write_time)
+        return MSG_TIMEOUT;
+      chThdYield();
+    }
+  }
+#endif
+  return MSG_OK;
+}
+
+/**
+ * @brief     Write data to EEPROM using backend page operations.
+ * @details   Only one EEPROM page can be written at once. So fucntion
+ *            splits large data chunks in small EEPROM transactions if needed.
+ *            Transfer stops on first failed page, position pointer is
+ *            advanced only by the number of actually written bytes.
+ * @note      To achieve the maximum effectivity use write operations
+ *            aligned to EEPROM page boundaries.
+ *
+ * @return    Number of bytes successfully written.
+ */
+size_t eepfs_write(void *ip, const EepromBackendOps *ops,
+                   const uint8_t *bp, size_t n) {
+
+  EepromFileStream *efs = ip;
+  const EepromFileConfig *cfg;
+  uint32_t addr;    /* absolute address of current chunk */
+  size_t   len;     /* bytes to be written at one trasaction */
+  size_t   written; /* total bytes successfully written */
+
+  osalDbgCheck((ip != NULL) && (efs->vmt != NULL) &&
+               (EEPROM_USE_STATIC_BINDING || (ops != NULL)));
+
+  n = __clamp_size(ip, n);
+  if (n == 0)
+    return 0;
+
+  cfg  = efs->cfg;
+  addr = cfg->barrier_low + efs->position;
+  written = 0;
+  while (written < n) {
+    /* bytes left up to the end of current page */
+    if (efs->pagemask != 0)
+      len = cfg->pagesize - (addr & efs->pagemask);
+    else
+      len = cfg->pagesize - (addr % cfg->pagesize);
+    if (len > (n - written))
+      len = n - written;
+
+    if ((__ll_write(ops, cfg, efs->position, bp, len) != MSG_OK) ||
+        (__wait_ready(ops, cfg) != MSG_OK)) {
+      efs->errors = FILE_ERROR;
+      break;
+    }
+
+    bp            += len;
+    addr          += len;
+    written       += len;
+    efs->position += len;
+  }
+
+  return written;
+}
+
+/**
+ * Read some bytes from current position in file using backend operations.
+ * After successful read operation the position pointer will be increased
+ * by the number of read bytes.
+ */
+size_t eepfs_read(void *ip, const EepromBackendOps *ops,
+                  uint8_t *bp, size_t n) {
+
+  EepromFileStream *efs = ip;
+
+  osalDbgCheck((ip != NULL) && (efs->vmt != NULL) &&
+               (EEPROM_USE_STATIC_BINDING || (ops != NULL)));
+
+  n = __clamp_size(ip, n);
+  if (n == 0)
+    return 0;
+
+  if (__ll_read(ops, efs->cfg, efs->position, bp, n) != MSG_OK) {
+    efs->errors = FILE_ERROR;
+    return 0;
+  }
+  efs->position += n;
+  return n;
+}
+
 uint8_t EepromReadByte(EepromFileStream *efs) {
 
   uint8_t buf;
-  chFileStreamRead(efs, &buf, sizeof(buf));
+  EepromFileRead(efs, &buf, sizeof(buf));
   return buf;
 }
 
 uint16_t EepromReadHalfword(EepromFileStream *efs) {
 
   uint16_t buf;
-  chFileStreamRead(efs, (uint8_t *)&buf, sizeof(buf));
+  EepromFileRead(efs, (uint8_t *)&buf, sizeof(buf));
   return buf;
 }
 
 uint32_t EepromReadWord(EepromFileStream *efs) {
 
   uint32_t buf;
-  chFileStreamRead(efs, (uint8_t *)&buf, sizeof(buf));
+  EepromFileRead(efs, (uint8_t *)&buf, sizeof(buf));
   return buf;
 }
 
 size_t EepromWriteByte(EepromFileStream *efs, uint8_t data) {
 
-  return chFileStreamWrite(efs, &data, sizeof(data));
+  return EepromFileWrite(efs, &data, sizeof(data));
 }
 
 size_t EepromWriteHalfword(EepromFileStream *efs, uint16_t data) {
 
-  return chFileStreamWrite(efs, (uint8_t *)&data, sizeof(data));
+  return EepromFileWrite(efs, (uint8_t *)&data, sizeof(data));
 }
 
 size_t EepromWriteWord(EepromFileStream *efs, uint32_t data) {
 
-  return chFileStreamWrite(efs, (uint8_t *)&data, sizeof(data));
+  return EepromFileWrite(efs, (uint8_t *)&data, sizeof(data));
 }
 
 fileoffset_t eepfs_getsize(void *ip) {
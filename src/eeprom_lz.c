@@ -0,0 +1,485 @@
+/*
+  Copyright (c) 2013 Timon Wong
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/*
+  Copyright 2012 Uladzimir Pylinski aka barthess.
+  You may use this work without restrictions, as long as this notice is included.
+  The work is provided "as is" without warranty of any kind, neither express nor implied.
+*/
+
+
+/**
+ * @file    eeprom_lz.c
+ * @brief   Compressing stream adapter for EEPROM files.
+ */
+
+#include "eeprom_lz.h"
+#include <string.h>
+
+#if (defined(DRIVER_USE_EEPROM) && DRIVER_USE_EEPROM &&                     \
+     EEPROM_USE_COMPRESSION) || defined(__DOXYGEN__)
+
+/*
+ ******************************************************************************
+ * DEFINES
+ ******************************************************************************
+ */
+/* Compressed data format:
+ *   000LLLLL                      literal run of L + 1 bytes follows
+ *   LLLooooo oooooooo             match of L + 2 bytes, L = 1..6
+ *   111ooooo EEEEEEEE oooooooo    match of E + 9 bytes
+ * Match offset is o + 1 bytes back from current output position. */
+#define LZ_MAX_LIT        32
+#define LZ_MAX_OFF        8192
+#define LZ_MIN_MATCH      3
+#define LZ_MAX_MATCH      (7 + 255 + 2)
+
+#define LZ_HASH(p)                                                          \
+  ((uint32_t)((((uint32_t)(p)[0] << 16) | ((uint32_t)(p)[1] << 8) |          \
+               (p)[2]) * 2654435761U) >> (32 - EEPROM_LZ_HASH_LOG))
+
+#define LZ_STORED         0x8000U
+#define LZ_LEN_MASK       0x7FFFU
+
+/*
+ *******************************************************************************
+ * LOCAL FUNCTIONS
+ *******************************************************************************
+ */
+
+/**
+ * @brief   Emits pending literals.
+ *
+ * @return  New output pointer or @p NULL if output buffer is too small.
+ */
+static uint8_t *lz_put_literals(uint8_t *op, const uint8_t *out_end,
+                                const uint8_t *lit, size_t n) {
+
+  while (n > 0) {
+    size_t run = (n > LZ_MAX_LIT) ? LZ_MAX_LIT : n;
+    if ((size_t)(out_end - op) < (run + 1))
+      return NULL;
+    *op++ = (uint8_t)(run - 1);
+    memcpy(op, lit, run);
+    op  += run;
+    lit += run;
+    n   -= run;
+  }
+  return op;
+}
+
+/**
+ * @brief   Returns number of free bytes in page containing file offset.
+ */
+static size_t lz_page_room(const EepromFileStream *efs, uint32_t pos) {
+
+  uint32_t addr = efs->cfg->barrier_low + pos;
+
+  if (efs->pagemask != 0)
+    return efs->cfg->pagesize - (addr & efs->pagemask);
+  return efs->cfg->pagesize - (addr % efs->cfg->pagesize);
+}
+
+/**
+ * @brief   Moves file position to the next page boundary.
+ */
+static void lz_align(EepromFileStream *efs) {
+
+  uint32_t pos = eepfs_getposition(efs);
+  size_t room = lz_page_room(efs, pos);
+
+  if (room != efs->cfg->pagesize)
+    eepfs_lseek(efs, pos + room);
+}
+
+/**
+ * @brief   Compresses and stores content of raw buffer.
+ * @details Block starts at page boundary, file position is left at the
+ *          next one, where the reader looks for the next header.
+ *
+ * @param[in] lzs       pointer to the @p EepromLzStream object
+ */
+static msg_t lz_emit(EepromLzStream *lzs) {
+
+  const EepromLzConfig *cfg = lzs->cfg;
+  EepromFileStream *efs = lzs->efs;
+  uint8_t *pk = cfg->packbuf;
+  size_t plen, total;
+  uint16_t hdr;
+
+  if (lzs->fill == 0)
+    return MSG_OK;
+
+  /* Compressed block must be smaller than raw one, store it as is
+     otherwise. */
+  plen = eeprom_lz_compress(lzs->htab, cfg->rawbuf, lzs->fill,
+                            &pk[EEPROM_LZ_HEADER_SIZE], lzs->fill - 1);
+  hdr = (uint16_t)plen;
+  if (plen == 0) {
+    memcpy(&pk[EEPROM_LZ_HEADER_SIZE], cfg->rawbuf, lzs->fill);
+    plen = lzs->fill;
+    hdr  = (uint16_t)(plen | LZ_STORED);
+  }
+  pk[0] = (uint8_t)(hdr & 0xFF);
+  pk[1] = (uint8_t)(hdr >> 8);
+  pk[2] = (uint8_t)(lzs->fill & 0xFF);
+  pk[3] = (uint8_t)(lzs->fill >> 8);
+  total = EEPROM_LZ_HEADER_SIZE + plen;
+
+  if (EepromFileWrite(efs, pk, total) != total)
+    return MSG_RESET;
+
+  lz_align(efs);
+  lzs->fill = 0;
+  return MSG_OK;
+}
+
+/**
+ * @brief   Loads and decompresses next block.
+ */
+static bool lz_load(EepromLzStream *lzs) {
+
+  const EepromLzConfig *cfg = lzs->cfg;
+  EepromFileStream *efs = lzs->efs;
+  uint8_t *pk = cfg->packbuf;
+  size_t plen, rlen;
+
+  lzs->fill = 0;
+  lzs->rpos = 0;
+  if (EepromFileRead(efs, pk, EEPROM_LZ_HEADER_SIZE) != EEPROM_LZ_HEADER_SIZE)
+    goto END;
+
+  plen = pk[0] | ((uint16_t)pk[1] << 8);
+  rlen = pk[2] | ((uint16_t)pk[3] << 8);
+  if ((rlen == 0) || (rlen == 0xFFFF) || (rlen > cfg->blocksize) ||
+      ((plen & LZ_LEN_MASK) > cfg->blocksize))
+    goto END;
+
+  if (plen & LZ_STORED) {
+    plen &= LZ_LEN_MASK;
+    if ((plen != rlen) || (EepromFileRead(efs, cfg->rawbuf, plen) != plen))
+      goto END;
+  }
+  else {
+    if ((EepromFileRead(efs, pk, plen) != plen) ||
+        (eeprom_lz_decompress(pk, plen, cfg->rawbuf, rlen) != rlen))
+      goto END;
+  }
+
+  lz_align(efs);
+  lzs->fill = rlen;
+  return true;
+
+END:
+  lzs->eof = true;
+  return false;
+}
+
+static size_t write(void *ip, const uint8_t *bp, size_t n) {
+
+  EepromLzStream *lzs = ip;
+  size_t done = 0;
+
+  osalDbgCheck((ip != NULL) && (lzs->vmt != NULL));
+  osalDbgAssert(lzs->writing, "stream opened for reading");
+
+  while (done < n) {
+    size_t len = lzs->cfg->blocksize - lzs->fill;
+    if (len > (n - done))
+      len = n - done;
+    memcpy(&lzs->cfg->rawbuf[lzs->fill], bp, len);
+    lzs->fill += len;
+    bp        += len;
+    done      += len;
+    if ((lzs->fill == lzs->cfg->blocksize) && (lz_emit(lzs) != MSG_OK))
+      return (done > lzs->fill) ? (done - lzs->fill) : 0;
+  }
+  return done;
+}
+
+static size_t read(void *ip, uint8_t *bp, size_t n) {
+
+  EepromLzStream *lzs = ip;
+  size_t done = 0;
+
+  osalDbgCheck((ip != NULL) && (lzs->vmt != NULL));
+  osalDbgAssert(!lzs->writing, "stream opened for writing");
+
+  while (done < n) {
+    size_t len;
+    if ((lzs->rpos == lzs->fill) && (lzs->eof || !lz_load(lzs)))
+      break;
+    len = lzs->fill - lzs->rpos;
+    if (len > (n - done))
+      len = n - done;
+    memcpy(bp, &lzs->cfg->rawbuf[lzs->rpos], len);
+    lzs->rpos += len;
+    bp        += len;
+    done      += len;
+  }
+  return done;
+}
+
+static msg_t put(void *ip, uint8_t b) {
+
+  return (write(ip, &b, 1) == 1) ? MSG_OK : MSG_RESET;
+}
+
+static msg_t get(void *ip) {
+
+  uint8_t b;
+
+  return (read(ip, &b, 1) == 1) ? b : MSG_RESET;
+}
+
+static const struct EepromLzStreamVMT vmt = {
+  write,
+  read,
+  put,
+  get
+};
+
+/**
+ * @brief   Common part of open functions.
+ */
+static EepromLzStream *lz_open(EepromLzStream *lzs, EepromFileStream *efs,
+                               const EepromLzConfig *cfg, bool writing) {
+
+  osalDbgCheck((lzs != NULL) && (efs != NULL) && (efs->vmt != NULL) &&
+               (cfg != NULL) && (cfg->rawbuf != NULL) &&
+               (cfg->packbuf != NULL));
+  osalDbgAssert((cfg->blocksize > 1) &&
+                (cfg->blocksize <= EEPROM_LZ_MAX_BLOCK), "wrong block size");
+
+  lzs->vmt     = &vmt;
+  lzs->efs     = efs;
+  lzs->cfg     = cfg;
+  lzs->fill    = 0;
+  lzs->rpos    = 0;
+  lzs->writing = writing;
+  lzs->eof     = false;
+  lz_align(efs);
+  return lzs;
+}
+
+/*
+ *******************************************************************************
+ * EXPORTED FUNCTIONS
+ *******************************************************************************
+ */
+
+/**
+ * @brief   Compresses buffer.
+ *
+ * @param[in] htab      hash table of 2^EEPROM_LZ_HASH_LOG entries
+ * @param[in] in        data to be compressed
+ * @param[in] inlen     size of data, up to @p EEPROM_LZ_MAX_BLOCK
+ * @param[out] out      output buffer
+ * @param[in] outlen    size of output buffer
+ * @return              Size of compressed data or 0 if it does not fit in
+ *                      output buffer.
+ */
+size_t eeprom_lz_compress(uint16_t *htab, const uint8_t *in, size_t inlen,
+                          uint8_t *out, size_t outlen) {
+
+  const uint8_t *out_end = out + outlen;
+  uint8_t *op = out;
+  size_t ip = 0;
+  size_t lit = 0;
+
+  osalDbgCheck(inlen <= EEPROM_LZ_MAX_BLOCK);
+
+  /* Entries hold position + 1, zero is an empty slot. */
+  memset(htab, 0, sizeof(uint16_t) << EEPROM_LZ_HASH_LOG);
+
+  while ((ip + LZ_MIN_MATCH) <= inlen) {
+    uint32_t h = LZ_HASH(&in[ip]);
+    size_t ref = (size_t)htab[h] - 1;
+    htab[h] = (uint16_t)(ip + 1);
+
+    if ((ref < ip) && ((ip - ref) <= LZ_MAX_OFF) &&
+        (in[ref] == in[ip]) && (in[ref + 1] == in[ip + 1]) &&
+        (in[ref + 2] == in[ip + 2])) {
+      size_t len = LZ_MIN_MATCH;
+      size_t maxlen = inlen - ip;
+      size_t off = ip - ref - 1;
+      size_t l;
+
+      if (maxlen > LZ_MAX_MATCH)
+        maxlen = LZ_MAX_MATCH;
+      while ((len < maxlen) && (in[ref + len] == in[ip + len]))
+        len++;
+
+      op = lz_put_literals(op, out_end, &in[lit], ip - lit);
+      if ((op == NULL) || ((out_end - op) < 3))
+        return 0;
+
+      l = len - 2;
+      if (l < 7) {
+        *op++ = (uint8_t)((l << 5) | (off >> 8));
+      }
+      else {
+        *op++ = (uint8_t)((7 << 5) | (off >> 8));
+        *op++ = (uint8_t)(l - 7);
+      }
+      *op++ = (uint8_t)(off & 0xFF);
+
+      /* Hash positions covered by match to improve following matches. */
+      ip++;
+      len--;
+      while ((len > 0) && ((ip + LZ_MIN_MATCH) <= inlen)) {
+        htab[LZ_HASH(&in[ip])] = (uint16_t)(ip + 1);
+        ip++;
+        len--;
+      }
+      ip += len;
+      lit = ip;
+    }
+    else
+      ip++;
+  }
+
+  op = lz_put_literals(op, out_end, &in[lit], inlen - lit);
+  if (op == NULL)
+    return 0;
+  return op - out;
+}
+
+/**
+ * @brief   Decompresses buffer.
+ *
+ * @param[in] in        compressed data
+ * @param[in] inlen     size of compressed data
+ * @param[out] out      output buffer
+ * @param[in] outlen    size of output buffer
+ * @return              Size of decompressed data or 0 on corrupted input.
+ */
+size_t eeprom_lz_decompress(const uint8_t *in, size_t inlen,
+                            uint8_t *out, size_t outlen) {
+
+  const uint8_t *in_end = in + inlen;
+  uint8_t *op = out;
+  uint8_t *out_end = out + outlen;
+
+  while (in < in_end) {
+    uint8_t ctrl = *in++;
+    size_t len = ctrl >> 5;
+
+    if (len == 0) {
+      len = ctrl + 1;
+      if (((size_t)(in_end - in) < len) || ((size_t)(out_end - op) < len))
+        return 0;
+      memcpy(op, in, len);
+      op += len;
+      in += len;
+    }
+    else {
+      const uint8_t *ref;
+      if (len == 7) {
+        if (in >= in_end)
+          return 0;
+        len += *in++;
+      }
+      if (in >= in_end)
+        return 0;
+      ref = op - ((((size_t)ctrl & 0x1F) << 8) | *in++) - 1;
+      len += 2;
+      if ((ref < out) || ((size_t)(out_end - op) < len))
+        return 0;
+      /* Byte by byte, source and destination may overlap. */
+      while (len-- > 0)
+        *op++ = *ref++;
+    }
+  }
+  return op - out;
+}
+
+/**
+ * @brief   Opens compressing stream for writing.
+ * @details Blocks are stored starting from current position of @p efs
+ *          rounded up to page boundary.
+ */
+EepromLzStream *EepromLzOpenWrite(EepromLzStream *lzs, EepromFileStream *efs,
+                                  const EepromLzConfig *cfg) {
+
+  return lz_open(lzs, efs, cfg, true);
+}
+
+/**
+ * @brief   Opens compressing stream for reading.
+ * @details Blocks are read starting from current position of @p efs
+ *          rounded up to page boundary.
+ */
+EepromLzStream *EepromLzOpenRead(EepromLzStream *lzs, EepromFileStream *efs,
+                                 const EepromLzConfig *cfg) {
+
+  return lz_open(lzs, efs, cfg, false);
+}
+
+/**
+ * @brief   Stores buffered data and end of data marker.
+ * @details Marker is written at the page boundary following the last
+ *          block, where the reader looks for the next header, so stale
+ *          blocks of a longer stream written before are never read back.
+ *          Next block written overwrites it.
+ * @note    Every flush starts new block and costs one more page write for
+ *          the marker, so flush only at the end of logical record.
+ */
+msg_t EepromLzFlush(EepromLzStream *lzs) {
+
+  static const uint8_t eod[EEPROM_LZ_HEADER_SIZE] = {0, 0, 0, 0};
+  EepromFileStream *efs;
+  uint32_t pos;
+
+  osalDbgCheck((lzs != NULL) && (lzs->vmt != NULL));
+  osalDbgAssert(lzs->writing, "stream opened for reading");
+
+  if (lz_emit(lzs) != MSG_OK)
+    return MSG_RESET;
+
+  /* Nothing to mark when the last block ends at the end of file. */
+  efs = lzs->efs;
+  pos = eepfs_getposition(efs);
+  if ((pos + EEPROM_LZ_HEADER_SIZE) > eepfs_getsize(efs))
+    return MSG_OK;
+  if (EepromFileWrite(efs, eod, EEPROM_LZ_HEADER_SIZE) != EEPROM_LZ_HEADER_SIZE)
+    return MSG_RESET;
+  eepfs_lseek(efs, pos);
+  return MSG_OK;
+}
+
+/**
+ * @brief   Closes compressing stream, buffered data is flushed.
+ */
+msg_t EepromLzClose(EepromLzStream *lzs) {
+
+  msg_t status = MSG_OK;
+
+  osalDbgCheck((lzs != NULL) && (lzs->vmt != NULL));
+
+  if (lzs->writing)
+    status = EepromLzFlush(lzs);
+  lzs->vmt = NULL;
+  return status;
+}
+
+#endif /* DRIVER_USE_EEPROM && EEPROM_USE_COMPRESSION */
@@ -0,0 +1,253 @@
+/*
+  Copyright (c) 2013 Timon Wong
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/*
+  Copyright 2012 Uladzimir Pylinski aka barthess.
+  You may use this work without restrictions, as long as this notice is included.
+  The work is provided "as is" without warranty of any kind, neither express nor implied.
+*/
+
+
+/**
+ * @file    eeprom_wave.c
+ * @brief   Waveform playback from EEPROM file through DAC.
+ */
+
+#include "eeprom_wave.h"
+
+#if (defined(DRIVER_USE_EEPROM) && DRIVER_USE_EEPROM &&                     \
+     defined(DRIVER_USE_DAC) && DRIVER_USE_DAC && EEPROM_USE_WAVE) ||        \
+    defined(__DOXYGEN__)
+
+/*
+ ******************************************************************************
+ * DEFINES
+ ******************************************************************************
+ */
+/* Worker requests. */
+#define WAVE_HALF0        0x01
+#define WAVE_HALF1        0x02
+#define WAVE_STOP         0x04
+
+/* Value of last once its half has been played. */
+#define WAVE_LAST_PLAYED  2
+
+/*
+ *******************************************************************************
+ * LOCAL FUNCTIONS
+ *******************************************************************************
+ */
+
+/**
+ * @brief   Refills next half of the buffer from file.
+ * @details Half which is not completely filled from file is padded with
+ *          idle value and the end of waveform is recorded.
+ */
+static void wave_fill(EepromWave *wavp) {
+
+  const EepromWaveConfig *cfg = wavp->cfg;
+  uint8_t half = wavp->next;
+  size_t n = (cfg->depth / 2) * cfg->num_channels;
+  dacsample_t *dst = cfg->buffer + (half * n);
+  bool data = false;
+  bool rewound = false;
+
+  wavp->next = half ^ 1;
+
+  while ((wavp->last < 0) && (n > 0)) {
+    size_t got = EepromFileRead(wavp->efs, (uint8_t *)dst,
+                                n * sizeof(dacsample_t)) / sizeof(dacsample_t);
+    dst += got;
+    n   -= got;
+    if (got > 0) {
+      data    = true;
+      rewound = false;
+    }
+    else if (cfg->loop && !rewound) {
+      eepfs_lseek(wavp->efs, 0);
+      rewound = true;
+    }
+    else {
+      /* Last samples are here or in the previously filled half. */
+      wavp->last = data ? half : (half ^ 1);
+    }
+  }
+
+  while (n-- > 0)
+    *dst++ = cfg->idle;
+}
+
+/**
+ * @brief   DAC half and full buffer callback.
+ */
+static void wave_cb(DACDriver *dacp, const dacsample_t *buffer, size_t n) {
+
+  /* Conversion group is the first member of player object. */
+  EepromWave *wavp = (EepromWave *)dacp->grpp;
+  uint8_t half = (buffer == wavp->cfg->buffer) ? 0 : 1;
+  uint8_t req = half ? WAVE_HALF1 : WAVE_HALF0;
+
+  (void)n;
+
+  osalSysLockFromISR();
+  if (wavp->last == WAVE_LAST_PLAYED) {
+    /* DMA runs one row ahead of the output, so the idle half following
+       the last one is played before stopping. */
+    wavp->pending |= WAVE_STOP;
+  }
+  else {
+    if (wavp->last == half)
+      wavp->last = WAVE_LAST_PLAYED;
+    /* Half played again before its refill was requested or completed.*/
+    if ((wavp->pending | wavp->filling) & req)
+      wavp->underruns++;
+    wavp->pending |= req;
+  }
+  chSemSignalI(&wavp->sem);
+  osalSysUnlockFromISR();
+}
+
+/**
+ * @brief   Refilling worker thread.
+ */
+static THD_FUNCTION(wave_thread, arg) {
+
+  EepromWave *wavp = arg;
+  uint8_t pending;
+
+  chRegSetThreadName("eeprom_wave");
+
+  while (true) {
+    chSemWait(&wavp->sem);
+    osalSysLock();
+    pending = wavp->pending;
+    wavp->pending = 0;
+    wavp->filling = pending & (WAVE_HALF0 | WAVE_HALF1);
+    osalSysUnlock();
+
+    if (pending & WAVE_STOP)
+      break;
+    if (pending & (WAVE_HALF0 | WAVE_HALF1))
+      wave_fill(wavp);
+    if ((pending & (WAVE_HALF0 | WAVE_HALF1)) == (WAVE_HALF0 | WAVE_HALF1))
+      wave_fill(wavp);
+
+    osalSysLock();
+    wavp->filling = 0;
+    osalSysUnlock();
+  }
+
+  dacStopConversion(wavp->dacp);
+  if (wavp->cfg->end_cb != NULL)
+    wavp->cfg->end_cb(wavp);
+}
+
+/*
+ *******************************************************************************
+ * EXPORTED FUNCTIONS
+ *******************************************************************************
+ */
+
+/**
+ * @brief   Initializes waveform player object.
+ *
+ * @param[out] wavp     pointer to the @p EepromWave object
+ */
+void EepromWaveObjectInit(EepromWave *wavp) {
+
+  osalDbgCheck(wavp != NULL);
+
+  wavp->cfg       = NULL;
+  wavp->dacp      = NULL;
+  wavp->efs       = NULL;
+  wavp->thread    = NULL;
+  wavp->pending   = 0;
+  wavp->filling   = 0;
+  wavp->next      = 0;
+  wavp->last      = -1;
+  wavp->underruns = 0;
+  chSemObjectInit(&wavp->sem, 0);
+}
+
+/**
+ * @brief   Starts playback from current position of EEPROM file.
+ * @details Both halves of the buffer are filled before DAC is started.
+ *
+ * @param[in] wavp      pointer to the @p EepromWave object
+ * @param[in] dacp      pointer to the started @p DACDriver object
+ * @param[in] efs       opened EEPROM file holding samples
+ * @param[in] cfg       pointer to the @p EepromWaveConfig object
+ */
+void EepromWaveStart(EepromWave *wavp, DACDriver *dacp,
+                     EepromFileStream *efs, const EepromWaveConfig *cfg) {
+
+  osalDbgCheck((wavp != NULL) && (dacp != NULL) && (efs != NULL) &&
+               (cfg != NULL) && (cfg->buffer != NULL) && (cfg->wsp != NULL));
+  osalDbgAssert((cfg->depth >= 2) && ((cfg->depth & 1) == 0),
+                "depth must be even");
+  osalDbgAssert(wavp->thread == NULL, "already playing");
+
+  wavp->grp.frequency    = cfg->frequency;
+  wavp->grp.num_channels = cfg->num_channels;
+  wavp->grp.end_cb       = wave_cb;
+  wavp->grp.error_cb     = NULL;
+  wavp->grp.circular     = true;
+  wavp->cfg              = cfg;
+  wavp->dacp             = dacp;
+  wavp->efs              = efs;
+  wavp->pending          = 0;
+  wavp->filling          = 0;
+  wavp->next             = 0;
+  wavp->last             = -1;
+  wavp->underruns        = 0;
+  chSemReset(&wavp->sem, 0);
+
+  wave_fill(wavp);
+  wave_fill(wavp);
+
+  wavp->thread = chThdCreateStatic(cfg->wsp, cfg->wssize, cfg->prio,
+                                   wave_thread, wavp);
+  dacStartConversion(dacp, &wavp->grp, cfg->buffer, cfg->depth);
+}
+
+/**
+ * @brief   Stops playback and waits for worker thread termination.
+ * @note    Can be called after waveform ended by itself too.
+ *
+ * @param[in] wavp      pointer to the @p EepromWave object
+ */
+void EepromWaveStop(EepromWave *wavp) {
+
+  osalDbgCheck(wavp != NULL);
+
+  if (wavp->thread == NULL)
+    return;
+
+  osalSysLock();
+  wavp->pending |= WAVE_STOP;
+  osalSysUnlock();
+  chSemSignal(&wavp->sem);
+  chThdWait(wavp->thread);
+  wavp->thread = NULL;
+}
+
+#endif /* DRIVER_USE_EEPROM && DRIVER_USE_DAC && EEPROM_USE_WAVE */
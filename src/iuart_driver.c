@@ -38,6 +38,8 @@
 
 #include "iuart_driver.h"
 
+#include <string.h>
+
 #if DRIVER_USE_IUART || defined(__DOXYGEN__)
 
 /*===========================================================================*/
@@ -48,6 +50,46 @@
 /* Driver exported variables.                                                */
 /*===========================================================================*/
 
+#if IUART_USE_MODBUS || defined(__DOXYGEN__)
+/**
+ * @brief   CRC-16 table, polynomial 0x8005 reflected.
+ */
+const uint16_t iuart_crc16_table[256] = {
+  0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+  0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+  0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+  0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+  0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+  0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+  0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+  0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+  0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+  0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+  0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+  0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+  0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+  0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+  0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+  0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+  0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+  0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+  0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+  0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+  0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+  0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+  0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+  0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+  0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+  0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+  0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+  0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+  0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+  0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+  0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+  0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+#endif
+
 /*===========================================================================*/
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
@@ -56,6 +98,69 @@
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+#if IUART_USE_CHANNEL || defined(__DOXYGEN__)
+/*
+ * Interface implementation, the reads loop over the ring because a single
+ * iuartRead() returns as soon as some data is available.
+ */
+static size_t _readt(void *ip, uint8_t *bp, size_t n, systime_t time) {
+  size_t done = 0;
+
+  while (done < n) {
+    size_t k = iuartRead((IUARTDriver *)ip, bp + done, n - done, time);
+    if (k == 0)
+      break;
+    done += k;
+  }
+  return done;
+}
+
+static size_t _writet(void *ip, const uint8_t *bp, size_t n, systime_t time) {
+
+  return iuartWriteTimeout((IUARTDriver *)ip, bp, n, time);
+}
+
+static msg_t _gett(void *ip, systime_t time) {
+  uint8_t b;
+
+  if (iuartRead((IUARTDriver *)ip, &b, 1, time) == 1)
+    return (msg_t)b;
+  return ((IUARTDriver *)ip)->state == IUART_READY ? MSG_TIMEOUT : MSG_RESET;
+}
+
+static msg_t _putt(void *ip, uint8_t b, systime_t time) {
+
+  if (iuartWriteTimeout((IUARTDriver *)ip, &b, 1, time) == 1)
+    return MSG_OK;
+  return ((IUARTDriver *)ip)->state == IUART_READY ? MSG_TIMEOUT : MSG_RESET;
+}
+
+static size_t _write(void *ip, const uint8_t *bp, size_t n) {
+
+  return _writet(ip, bp, n, TIME_INFINITE);
+}
+
+static size_t _read(void *ip, uint8_t *bp, size_t n) {
+
+  return _readt(ip, bp, n, TIME_INFINITE);
+}
+
+static msg_t _put(void *ip, uint8_t b) {
+
+  return _putt(ip, b, TIME_INFINITE);
+}
+
+static msg_t _get(void *ip) {
+
+  return _gett(ip, TIME_INFINITE);
+}
+
+static const struct IUARTDriverVMT vmt = {
+  _write, _read, _put, _get,
+  _putt, _gett, _writet, _readt
+};
+#endif /* IUART_USE_CHANNEL */
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -81,10 +186,39 @@ void iuartInit(void) {
  */
 void iuartObjectInit(IUARTDriver *iuartp) {
 
+#if IUART_USE_CHANNEL
+  iuartp->vmt     = &vmt;
+#endif
   iuartp->state   = IUART_STOP;
   iuartp->txstate = IUART_TX_IDLE;
   iuartp->rxstate = IUART_RX_IDLE;
   iuartp->config  = NULL;
+#if IUART_USE_RXRING
+  iuartp->rxhead   = 0;
+  iuartp->rxtail   = 0;
+  iuartp->rxthread = NULL;
+#endif
+#if IUART_USE_TXQUEUE
+  iuartp->txhead   = 0;
+  iuartp->txtail   = 0;
+  iuartp->txthread = NULL;
+#endif
+#if IUART_USE_DEFERRED
+  iuartp->evhead   = 0;
+  iuartp->evtail   = 0;
+  iuartp->evlost   = false;
+  iuartp->evthread = NULL;
+#endif
+#if IUART_USE_STATS
+  memset(&iuartp->stats, 0, sizeof iuartp->stats);
+  iuartp->stats.isrmin = UINT32_MAX;
+#endif
+#if IUART_USE_RXCHAIN
+  iuartp->chhead   = 0;
+  iuartp->chfill   = 0;
+  iuartp->chtail   = 0;
+  iuartp->chthread = NULL;
+#endif
   /* Optional, user-defined initializer.*/
 #if defined(IUART_DRIVER_EXT_INIT_HOOK)
   IUART_DRIVER_EXT_INIT_HOOK(iuartp);
@@ -108,6 +242,40 @@ void iuartStart(IUARTDriver *iuartp, const IUARTConfig *config) {
               "invalid state");
 
   iuartp->config = config;
+#if IUART_USE_RXRING
+  osalDbgAssert((config->rxring == NULL) ||
+                ((config->rxring_size > 0) &&
+                 ((config->rxring_size & (config->rxring_size - 1)) == 0)),
+                "ring size not a power of two");
+  iuartp->rxhead = 0;
+  iuartp->rxtail = 0;
+#endif
+#if IUART_USE_TXQUEUE
+  osalDbgAssert((config->txring == NULL) ||
+                ((config->txring_size > 0) &&
+                 ((config->txring_size & (config->txring_size - 1)) == 0)),
+                "queue size not a power of two");
+  iuartp->txhead = 0;
+  iuartp->txtail = 0;
+#endif
+#if IUART_USE_DEFERRED
+  osalDbgAssert((config->evq == NULL) ||
+                ((config->evq_size > 0) &&
+                 ((config->evq_size & (config->evq_size - 1)) == 0)),
+                "events queue size not a power of two");
+  iuartp->evhead = 0;
+  iuartp->evtail = 0;
+  iuartp->evlost = false;
+#endif
+#if IUART_USE_RXCHAIN
+  osalDbgAssert((config->rxchain == NULL) ||
+                ((config->rxchain_size > 0) &&
+                 ((config->rxchain_size & (config->rxchain_size - 1)) == 0)),
+                "chain size not a power of two");
+  iuartp->chhead = 0;
+  iuartp->chfill = 0;
+  iuartp->chtail = 0;
+#endif
   iuart_lld_start(iuartp);
   iuartp->state = IUART_READY;
   osalSysUnlock();
@@ -132,6 +300,22 @@ void iuartStop(IUARTDriver *iuartp) {
   iuartp->state = IUART_STOP;
   iuartp->txstate = IUART_TX_IDLE;
   iuartp->rxstate = IUART_RX_IDLE;
+#if IUART_USE_RXRING
+  osalThreadResumeI(&iuartp->rxthread, MSG_RESET);
+#endif
+#if IUART_USE_TXQUEUE
+  osalThreadResumeI(&iuartp->txthread, MSG_RESET);
+#endif
+#if IUART_USE_DEFERRED
+  osalThreadResumeI(&iuartp->evthread, MSG_RESET);
+#endif
+#if IUART_USE_RXCHAIN
+  osalThreadResumeI(&iuartp->chthread, MSG_RESET);
+#endif
+#if IUART_USE_RXRING || IUART_USE_TXQUEUE || IUART_USE_DEFERRED ||           \
+    IUART_USE_RXCHAIN
+  osalOsRescheduleS();
+#endif
   osalSysUnlock();
 }
 
@@ -263,6 +447,9 @@ void iuartStartReceive(IUARTDriver *iuartp, size_t n, void *rxbuf) {
               "is active");
   osalDbgAssert(iuartp->rxstate != IUART_RX_ACTIVE,
                "rx active");
+#if IUART_USE_RXCHAIN
+  osalDbgAssert(iuartp->config->rxchain == NULL, "use iuartQueueReceive()");
+#endif
 
   iuart_lld_start_receive(iuartp, n, rxbuf);
   iuartp->rxstate = IUART_RX_ACTIVE;
@@ -289,6 +476,9 @@ void iuartStartReceiveI(IUARTDriver *iuartp, size_t n, void *rxbuf) {
               "is active");
   osalDbgAssert(iuartp->rxstate != IUART_RX_ACTIVE,
               "rx active");
+#if IUART_USE_RXCHAIN
+  osalDbgAssert(iuartp->config->rxchain == NULL, "use iuartQueueReceiveI()");
+#endif
 
   iuart_lld_start_receive(iuartp, n, rxbuf);
   iuartp->rxstate = IUART_RX_ACTIVE;
@@ -318,6 +508,9 @@ size_t iuartStopReceive(IUARTDriver *iuartp) {
   if (iuartp->rxstate == IUART_RX_ACTIVE) {
     n = iuart_lld_stop_receive(iuartp);
     iuartp->rxstate = IUART_RX_IDLE;
+#if IUART_USE_RXCHAIN
+    iuartp->chhead = iuartp->chfill;
+#endif
   }
   else
     n = 0;
@@ -348,11 +541,778 @@ size_t iuartStopReceiveI(IUARTDriver *iuartp) {
   if (iuartp->rxstate == IUART_RX_ACTIVE) {
     size_t n = iuart_lld_stop_receive(iuartp);
     iuartp->rxstate = IUART_RX_IDLE;
+#if IUART_USE_RXCHAIN
+    iuartp->chhead = iuartp->chfill;
+#endif
     return n;
   }
   return 0;
 }
 
+/**
+ * @brief   Returns the bit rate actually set.
+ * @details The divider is an integer number of clock periods, or 1/256 of
+ *          them on the LPUART, so the bit rate differs from @p speed in
+ *          configuration.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[out] errp     deviation from the configured speed in parts per
+ *                      million or @p NULL
+ *
+ * @return              The bit rate.
+ *
+ * @api
+ */
+uint32_t iuartGetBaudRate(IUARTDriver *iuartp, int32_t *errp) {
+
+  osalDbgCheck(iuartp != NULL);
+  osalDbgAssert(iuartp->state == IUART_READY, "not active");
+
+  if (errp != NULL)
+    *errp = (int32_t)(((int64_t)iuartp->baud -
+                       (int64_t)iuartp->config->speed) * 1000000 /
+                      (int64_t)iuartp->config->speed);
+  return iuartp->baud;
+}
+
+#if IUART_USE_RXCHAIN || defined(__DOXYGEN__)
+/**
+ * @brief   Queues a buffer in the receive chain.
+ * @details The buffer is filled after the ones queued before it, with no
+ *          gap between them. If the receiver is idle it starts right away.
+ * @note    The buffers are organized as uint8_t arrays for data sizes below
+ *          or equal to 8 bits else it is organized as uint16_t arrays.
+ * @pre     The driver must be started with a chain in configuration.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] n         number of data frames to receive
+ * @param[out] rxbuf    the pointer to the receive buffer
+ *
+ * @return              The buffer has been queued.
+ * @retval false        The chain is full.
+ *
+ * @api
+ */
+bool iuartQueueReceive(IUARTDriver *iuartp, size_t n, void *rxbuf) {
+  bool ok;
+
+  osalSysLock();
+  ok = iuartQueueReceiveI(iuartp, n, rxbuf);
+  osalSysUnlock();
+
+  return ok;
+}
+
+/**
+ * @brief   Queues a buffer in the receive chain.
+ * @note    This function has to be invoked from a lock zone, it can be
+ *          used from @p rxend_cb.
+ * @pre     The driver must be started with a chain in configuration.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] n         number of data frames to receive
+ * @param[out] rxbuf    the pointer to the receive buffer
+ *
+ * @return              The buffer has been queued.
+ * @retval false        The chain is full.
+ *
+ * @iclass
+ */
+bool iuartQueueReceiveI(IUARTDriver *iuartp, size_t n, void *rxbuf) {
+  const IUARTConfig *cfg;
+  iuartrxdesc_t *dp;
+
+  osalDbgCheckClassI();
+  osalDbgCheck((iuartp != NULL) && (n > 0) && (rxbuf != NULL));
+  osalDbgAssert(iuartp->state == IUART_READY, "not active");
+  osalDbgAssert(iuartp->config->rxchain != NULL, "chain not configured");
+
+  cfg = iuartp->config;
+  if (iuartp->chhead - iuartp->chtail >= cfg->rxchain_size)
+    return false;
+
+  dp      = &cfg->rxchain[iuartp->chhead & (cfg->rxchain_size - 1)];
+  dp->buf = rxbuf;
+  dp->n   = n;
+  iuartp->chhead++;
+
+  /* The chain was drained, this buffer is the one to fill.*/
+  if (iuartp->rxstate != IUART_RX_ACTIVE) {
+    iuart_lld_start_receive(iuartp, n, rxbuf);
+    iuartp->rxstate = IUART_RX_ACTIVE;
+  }
+
+  return true;
+}
+
+/**
+ * @brief   Returns the oldest filled buffer of the receive chain.
+ * @details If no buffer has been filled the calling thread sleeps until
+ *          one is or the timeout expires. A buffer ended early by the
+ *          frame delimiting is returned with the number of data frames
+ *          actually received.
+ * @pre     The driver must be started with a chain in configuration.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[out] bufp     the filled buffer
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of data frames in the buffer.
+ * @retval 0            Timeout or driver stopped.
+ *
+ * @api
+ */
+size_t iuartFetchReceive(IUARTDriver *iuartp, void **bufp,
+                         systime_t timeout) {
+  const IUARTConfig *cfg;
+  iuartrxdesc_t *dp;
+  size_t n = 0;
+
+  osalDbgCheck((iuartp != NULL) && (bufp != NULL));
+
+  osalSysLock();
+  osalDbgAssert(iuartp->state == IUART_READY, "not active");
+  osalDbgAssert(iuartp->config->rxchain != NULL, "chain not configured");
+  osalDbgAssert(iuartp->chthread == NULL, "already waiting");
+
+  if ((iuartp->chtail == iuartp->chfill) && (timeout != TIME_IMMEDIATE))
+    (void) osalThreadSuspendTimeoutS(&iuartp->chthread, timeout);
+  if ((iuartp->state == IUART_READY) && (iuartp->chtail != iuartp->chfill)) {
+    cfg   = iuartp->config;
+    dp    = &cfg->rxchain[iuartp->chtail & (cfg->rxchain_size - 1)];
+    *bufp = dp->buf;
+    n     = dp->n;
+    iuartp->chtail++;
+  }
+  osalSysUnlock();
+
+  return n;
+}
+#endif /* IUART_USE_RXCHAIN */
+
+#if IUART_USE_RXRING || defined(__DOXYGEN__)
+/**
+ * @brief   Reads characters from the receive ring.
+ * @details If the ring is empty the calling thread sleeps until the ring
+ *          fills up to the configured threshold, the line goes idle after
+ *          a burst or the timeout expires. Available characters are then
+ *          returned without waiting for more.
+ * @pre     The driver must be started with a ring buffer in configuration.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         maximum number of characters to read
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of characters read.
+ * @retval 0            Timeout or driver stopped.
+ *
+ * @api
+ */
+size_t iuartRead(IUARTDriver *iuartp, uint8_t *bp, size_t n,
+                 systime_t timeout) {
+  const IUARTConfig *cfg;
+  size_t tail, avail, mask, i;
+
+  osalDbgCheck((iuartp != NULL) && (bp != NULL) && (n > 0));
+
+  osalSysLock();
+  osalDbgAssert(iuartp->state == IUART_READY, "not active");
+  osalDbgAssert(iuartp->config->rxring != NULL, "ring not configured");
+  osalDbgAssert(iuartp->rxthread == NULL, "already waiting");
+
+  iuart_lld_rx_ring_sync(iuartp);
+  if ((iuartp->rxhead == iuartp->rxtail) && (timeout != TIME_IMMEDIATE))
+    (void) osalThreadSuspendTimeoutS(&iuartp->rxthread, timeout);
+  iuart_lld_rx_ring_sync(iuartp);
+  osalSysUnlock();
+
+  /* Copy is done outside the critical zone, the ISR never touches the
+     characters between tail and head.*/
+  cfg   = iuartp->config;
+  mask  = cfg->rxring_size - 1;
+  tail  = iuartp->rxtail;
+  avail = iuartp->rxhead - tail;
+  if (n > avail)
+    n = avail;
+  for (i = 0; i < n; i++)
+    bp[i] = cfg->rxring[(tail + i) & mask];
+
+  /* The lock orders the copy before releasing the space to the ISR.*/
+  osalSysLock();
+  iuartp->rxtail = tail + n;
+  iuart_lld_rx_flow(iuartp);
+  osalSysUnlock();
+
+  return n;
+}
+
+/**
+ * @brief   Returns the number of characters waiting in the receive ring.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @return              The number of characters available to
+ *                      @p iuartRead() without waiting.
+ *
+ * @api
+ */
+size_t iuartReadAvailable(IUARTDriver *iuartp) {
+  size_t n;
+
+  osalDbgCheck(iuartp != NULL);
+
+  osalSysLock();
+  iuart_lld_rx_ring_sync(iuartp);
+  n = iuartp->rxhead - iuartp->rxtail;
+  osalSysUnlock();
+
+  return n;
+}
+#endif /* IUART_USE_RXRING */
+
+#if IUART_USE_TXQUEUE || defined(__DOXYGEN__)
+/**
+ * @brief   Queues data for transmission.
+ * @details The data is copied into the transmit queue and sent as soon
+ *          as the data queued before it, without waiting.
+ * @note    Block transmissions started by @p iuartStartSend() take
+ *          precedence over queued data.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] bp        pointer to the data
+ * @param[in] n         number of bytes to queue
+ *
+ * @return              The number of bytes accepted, less than @p n when
+ *                      the queue is full.
+ *
+ * @api
+ */
+size_t iuartWrite(IUARTDriver *iuartp, const uint8_t *bp, size_t n) {
+
+  osalSysLock();
+  n = iuartWriteI(iuartp, bp, n);
+  osalSysUnlock();
+
+  return n;
+}
+
+/**
+ * @brief   Queues data for transmission.
+ * @note    This function has to be invoked from a lock zone.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] bp        pointer to the data
+ * @param[in] n         number of bytes to queue
+ *
+ * @return              The number of bytes accepted, less than @p n when
+ *                      the queue is full.
+ *
+ * @iclass
+ */
+size_t iuartWriteI(IUARTDriver *iuartp, const uint8_t *bp, size_t n) {
+  const IUARTConfig *cfg;
+  size_t head, space, mask, i;
+
+  osalDbgCheckClassI();
+  osalDbgCheck((iuartp != NULL) && ((bp != NULL) || (n == 0)));
+  osalDbgAssert(iuartp->state == IUART_READY, "not active");
+  osalDbgAssert(iuartp->config->txring != NULL, "queue not configured");
+
+  cfg   = iuartp->config;
+  mask  = cfg->txring_size - 1;
+  head  = iuartp->txhead;
+  space = cfg->txring_size - (head - iuartp->txtail);
+  if (n > space)
+    n = space;
+  if (n == 0)
+    return 0;
+
+  for (i = 0; i < n; i++)
+    cfg->txring[(head + i) & mask] = bp[i];
+  iuartp->txhead = head + n;
+  _iuart_stats_max(iuartp, txhwm, head + n - iuartp->txtail);
+  iuart_lld_start_queue(iuartp);
+
+  return n;
+}
+
+/**
+ * @brief   Returns the free space in the transmit queue.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @return              The number of bytes @p iuartWrite() would accept.
+ *
+ * @api
+ */
+size_t iuartWriteSpace(IUARTDriver *iuartp) {
+
+  osalDbgCheck(iuartp != NULL);
+
+  return iuartp->config->txring_size - (iuartp->txhead - iuartp->txtail);
+}
+
+/**
+ * @brief   Queues data for transmission, waiting for space.
+ * @details The data is copied into the transmit queue as space becomes
+ *          available, in as few chunks as the queue size allows.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] bp        pointer to the data
+ * @param[in] n         number of bytes to queue
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of bytes queued, less than @p n on
+ *                      timeout or if the driver is stopped.
+ *
+ * @api
+ */
+size_t iuartWriteTimeout(IUARTDriver *iuartp, const uint8_t *bp, size_t n,
+                         systime_t timeout) {
+  size_t done = 0;
+
+  osalDbgCheck((iuartp != NULL) && ((bp != NULL) || (n == 0)));
+
+  osalSysLock();
+  while (true) {
+    done += iuartWriteI(iuartp, bp + done, n - done);
+    if (done == n)
+      break;
+    osalDbgAssert(iuartp->txthread == NULL, "already waiting");
+    if (osalThreadSuspendTimeoutS(&iuartp->txthread, timeout) != MSG_OK)
+      break;
+  }
+  osalSysUnlock();
+
+  return done;
+}
+#endif /* IUART_USE_TXQUEUE */
+
+#if IUART_USE_DEFERRED || defined(__DOXYGEN__)
+/**
+ * @brief   Invokes the callbacks deferred by the ISR.
+ * @details Waits for events if the queue is empty, then invokes the
+ *          callbacks of all the queued events in order. A worker thread is
+ *          expected to call this function in a loop.
+ * @note    Callbacks run in the calling thread, so they must use the
+ *          @p api functions instead of the @p iclass ones. The driver
+ *          states have already returned to idle when they run.
+ * @pre     The driver must be started with an events queue in
+ *          configuration.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval MSG_OK       Events dispatched.
+ * @retval MSG_TIMEOUT  No event within the timeout.
+ * @retval MSG_RESET    Driver stopped.
+ *
+ * @api
+ */
+msg_t iuartDispatch(IUARTDriver *iuartp, systime_t timeout) {
+  const IUARTConfig *cfg;
+  iuartevent_t ev;
+  bool lost;
+  msg_t msg = MSG_OK;
+
+  osalDbgCheck(iuartp != NULL);
+
+  osalSysLock();
+  if (iuartp->state != IUART_READY) {
+    osalSysUnlock();
+    return MSG_RESET;
+  }
+  osalDbgAssert(iuartp->config->evq != NULL, "queue not configured");
+  osalDbgAssert(iuartp->evthread == NULL, "already waiting");
+
+  if ((iuartp->evhead == iuartp->evtail) && !iuartp->evlost)
+    msg = osalThreadSuspendTimeoutS(&iuartp->evthread, timeout);
+  osalSysUnlock();
+  if (msg != MSG_OK)
+    return msg;
+
+  cfg = iuartp->config;
+  while (iuartp->evtail != iuartp->evhead) {
+    ev = cfg->evq[iuartp->evtail & (cfg->evq_size - 1)];
+
+    /* The lock orders the copy before releasing the slot to the ISR.*/
+    osalSysLock();
+    iuartp->evtail++;
+    osalSysUnlock();
+
+    switch (ev.type) {
+    case IUART_EV_TXEND1:
+      cfg->txend1_cb(iuartp);
+      break;
+    case IUART_EV_TXEND2:
+      cfg->txend2_cb(iuartp);
+      break;
+    case IUART_EV_RXEND:
+      cfg->rxend_cb(iuartp);
+      break;
+    case IUART_EV_RXCHAR:
+      cfg->rxchar_cb(iuartp, (uint16_t)ev.arg);
+      break;
+    case IUART_EV_RXERR:
+      cfg->rxerr_cb(iuartp, (iuartflags_t)ev.arg);
+      break;
+#if IUART_USE_FRAMING
+    case IUART_EV_RXFRAME:
+      cfg->rxframe_cb(iuartp, (size_t)ev.arg);
+      break;
+#endif
+#if IUART_USE_BRIDGE
+    case IUART_EV_FLOW:
+      cfg->flow_cb(iuartp, ev.arg != 0);
+      break;
+#endif
+#if IUART_USE_TXPRIO
+    case IUART_EV_TXURGENT:
+      cfg->txurgent_cb(iuartp);
+      break;
+#endif
+    default:
+      break;
+    }
+  }
+
+  osalSysLock();
+  lost = iuartp->evlost;
+  iuartp->evlost = false;
+  osalSysUnlock();
+  if (lost && (cfg->rxerr_cb != NULL))
+    cfg->rxerr_cb(iuartp, IUART_EVENT_LOST);
+
+  return MSG_OK;
+}
+#endif /* IUART_USE_DEFERRED */
+
+#if IUART_USE_MODBUS || defined(__DOXYGEN__)
+/**
+ * @brief   Computes the Modbus CRC of a buffer.
+ * @details The CRC goes on the line low byte first after the frame.
+ *
+ * @param[in] bp        pointer to the data
+ * @param[in] n         number of bytes
+ *
+ * @return              The CRC.
+ *
+ * @api
+ */
+uint16_t iuartModbusCRC(const uint8_t *bp, size_t n) {
+  uint16_t crc = IUART_MODBUS_CRC_INIT;
+
+  osalDbgCheck((bp != NULL) || (n == 0));
+
+  while (n-- > 0)
+    crc = IUART_MODBUS_CRC_UPDATE(crc, *bp++);
+  return crc;
+}
+#endif /* IUART_USE_MODBUS */
+
+#if IUART_USE_TIMESTAMP || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the timestamps of the last block receive.
+ * @details The counter is latched by the ISR serving the first and the
+ *          last data frame. Valid from @p rxend_cb or @p rxframe_cb until
+ *          a data frame of the next block receive arrives.
+ * @pre     The port is configured with @p timestamp set.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[out] sp       pointer to the timestamps
+ *
+ * @api
+ */
+void iuartGetRxTimestamp(IUARTDriver *iuartp, iuartstamp_t *sp) {
+
+  osalDbgCheck((iuartp != NULL) && (sp != NULL));
+  osalDbgAssert(iuartp->config->timestamp, "timestamps not enabled");
+
+  *sp = iuartp->rxstamp;
+}
+#endif /* IUART_USE_TIMESTAMP */
+
+#if IUART_USE_TXPRIO || defined(__DOXYGEN__)
+/**
+ * @brief   Starts an urgent transmission on the IUART peripheral.
+ * @details The message preempts the block send in progress at its next
+ *          boundary, set by @p txprio_frames, and the queued data. The
+ *          block then resumes where it was left, its state and callbacks
+ *          are not affected.
+ * @note    The buffers are organized as uint8_t arrays for data sizes below
+ *          or equal to 8 bits else it is organized as uint16_t arrays.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] n         number of data frames to send
+ * @param[in] txbuf     the pointer to the transmit buffer
+ *
+ * @return              The message has been started.
+ * @retval false        An urgent message is already being sent.
+ *
+ * @api
+ */
+bool iuartStartSendUrgent(IUARTDriver *iuartp, size_t n, const void *txbuf) {
+  bool ok;
+
+  osalSysLock();
+  ok = iuartStartSendUrgentI(iuartp, n, txbuf);
+  osalSysUnlock();
+
+  return ok;
+}
+
+/**
+ * @brief   Starts an urgent transmission on the IUART peripheral.
+ * @note    This function has to be invoked from a lock zone, it can be
+ *          used from @p txurgent_cb.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] n         number of data frames to send
+ * @param[in] txbuf     the pointer to the transmit buffer
+ *
+ * @return              The message has been started.
+ * @retval false        An urgent message is already being sent.
+ *
+ * @iclass
+ */
+bool iuartStartSendUrgentI(IUARTDriver *iuartp, size_t n,
+                           const void *txbuf) {
+
+  osalDbgCheckClassI();
+  osalDbgCheck((iuartp != NULL) && (n > 0) && (txbuf != NULL));
+  osalDbgAssert(iuartp->state == IUART_READY, "not active");
+
+  return iuart_lld_start_urgent(iuartp, n, txbuf);
+}
+#endif /* IUART_USE_TXPRIO */
+
+#if IUART_USE_MUTE || defined(__DOXYGEN__)
+/**
+ * @brief   Mutes the receiver until the next wakeup condition.
+ * @details Used to skip the rest of a frame addressed to another node,
+ *          with idle line wakeup this is how the frames are filtered.
+ * @pre     The driver must be started with a mute mode in configuration.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @api
+ */
+void iuartMute(IUARTDriver *iuartp) {
+
+  osalSysLock();
+  iuartMuteI(iuartp);
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Mutes the receiver until the next wakeup condition.
+ * @note    This function has to be invoked from a lock zone, typically
+ *          from @p rxchar_cb after looking at the address.
+ * @pre     The driver must be started with a mute mode in configuration.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @iclass
+ */
+void iuartMuteI(IUARTDriver *iuartp) {
+
+  osalDbgCheckClassI();
+  osalDbgCheck(iuartp != NULL);
+  osalDbgAssert(iuartp->state == IUART_READY, "not active");
+  osalDbgAssert(iuartp->config->mute != IUART_MUTE_OFF, "mute not configured");
+
+  iuart_lld_mute(iuartp);
+}
+#endif /* IUART_USE_MUTE */
+
+#if IUART_USE_CRC || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes a CRC algorithm.
+ * @details The parameters are those of the usual CRC catalogues, with the
+ *          input and output reflection being the same.
+ *
+ * @param[out] cp       pointer to the @p iuartcrc_t object
+ * @param[in] width     CRC width in bits, 8 to 32
+ * @param[in] poly      polynomial, not reflected
+ * @param[in] init      initial value, not reflected
+ * @param[in] xorout    value XORed with the final CRC
+ * @param[in] reflected LSB first algorithm
+ *
+ * @init
+ */
+void iuartCRCObjectInit(iuartcrc_t *cp, uint8_t width, uint32_t poly,
+                        uint32_t init, uint32_t xorout, bool reflected) {
+  uint32_t rpoly = 0, rinit = 0, c;
+  unsigned i, j;
+
+  osalDbgCheck((cp != NULL) && (width >= 8) && (width <= 32));
+
+  cp->width     = width;
+  cp->xorout    = xorout;
+  cp->reflected = reflected;
+  if (reflected) {
+    for (i = 0; i < width; i++) {
+      rpoly = (rpoly << 1) | ((poly >> i) & 1U);
+      rinit = (rinit << 1) | ((init >> i) & 1U);
+    }
+    cp->init = rinit;
+    for (i = 0; i < 256; i++) {
+      c = i;
+      for (j = 0; j < 8; j++)
+        c = (c & 1U) ? (c >> 1) ^ rpoly : c >> 1;
+      cp->table[i] = c;
+    }
+  }
+  else {
+    /* Left aligned register, the width does not matter to the update.*/
+    poly   <<= 32U - width;
+    cp->init = init << (32U - width);
+    for (i = 0; i < 256; i++) {
+      c = (uint32_t)i << 24;
+      for (j = 0; j < 8; j++)
+        c = (c & 0x80000000U) ? (c << 1) ^ poly : c << 1;
+      cp->table[i] = c;
+    }
+  }
+}
+
+/**
+ * @brief   Adds data to a running CRC.
+ * @details Start from the @p init field of the algorithm, the final value
+ *          is returned by @p iuartCRC().
+ *
+ * @param[in] cp        pointer to the @p iuartcrc_t object
+ * @param[in] crc       running CRC
+ * @param[in] bp        pointer to the data
+ * @param[in] n         number of bytes
+ *
+ * @return              The updated running CRC.
+ *
+ * @api
+ */
+uint32_t iuartCRCUpdate(const iuartcrc_t *cp, uint32_t crc,
+                        const uint8_t *bp, size_t n) {
+
+  osalDbgCheck((cp != NULL) && ((bp != NULL) || (n == 0)));
+
+  while (n-- > 0)
+    crc = _iuart_crc_update(cp, crc, *bp++);
+  return crc;
+}
+
+/**
+ * @brief   Computes the CRC of a buffer.
+ *
+ * @param[in] cp        pointer to the @p iuartcrc_t object
+ * @param[in] bp        pointer to the data
+ * @param[in] n         number of bytes
+ *
+ * @return              The CRC.
+ *
+ * @api
+ */
+uint32_t iuartCRC(const iuartcrc_t *cp, const uint8_t *bp, size_t n) {
+
+  return _iuart_crc_final(cp, iuartCRCUpdate(cp, cp->init, bp, n));
+}
+
+/**
+ * @brief   Returns the CRC of the last block receive.
+ * @details Valid from @p rxend_cb or @p rxframe_cb until the next block
+ *          receive is started, for the characters received so far.
+ * @pre     The driver must be started with a CRC in configuration.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @return              The CRC.
+ *
+ * @api
+ */
+uint32_t iuartGetRxCRC(IUARTDriver *iuartp) {
+
+  osalDbgCheck(iuartp != NULL);
+  osalDbgAssert(iuartp->config->crc != NULL, "CRC not configured");
+
+  return _iuart_crc_final(iuartp->config->crc, iuartp->rxcrc);
+}
+
+/**
+ * @brief   Returns the CRC of the last block send.
+ * @details Valid from @p txend1_cb until the next block send is started,
+ *          an appended CRC is not part of it.
+ * @pre     The driver must be started with a CRC in configuration.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @return              The CRC.
+ *
+ * @api
+ */
+uint32_t iuartGetTxCRC(IUARTDriver *iuartp) {
+
+  osalDbgCheck(iuartp != NULL);
+  osalDbgAssert(iuartp->config->crc != NULL, "CRC not configured");
+
+  return _iuart_crc_final(iuartp->config->crc, iuartp->txcrc);
+}
+#endif /* IUART_USE_CRC */
+
+#if IUART_USE_STATS || defined(__DOXYGEN__)
+/**
+ * @brief   Takes a consistent snapshot of the statistics.
+ * @details The mean ISR duration is computed into the snapshot.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ * @param[out] sp       pointer to the snapshot
+ *
+ * @api
+ */
+void iuartGetStats(IUARTDriver *iuartp, iuartstats_t *sp) {
+
+  osalDbgCheck((iuartp != NULL) && (sp != NULL));
+
+  osalSysLock();
+  *sp = iuartp->stats;
+  osalSysUnlock();
+
+  if (sp->isrcount > 0)
+    sp->isrmean = (uint32_t)(sp->isrtotal / sp->isrcount);
+  else
+    sp->isrmin = 0;
+}
+
+/**
+ * @brief   Clears the statistics.
+ *
+ * @param[in] iuartp    pointer to the @p IUARTDriver object
+ *
+ * @api
+ */
+void iuartResetStats(IUARTDriver *iuartp) {
+
+  osalDbgCheck(iuartp != NULL);
+
+  osalSysLock();
+  memset(&iuartp->stats, 0, sizeof iuartp->stats);
+  iuartp->stats.isrmin = UINT32_MAX;
+  osalSysUnlock();
+}
+#endif /* IUART_USE_STATS */
+
 #endif /* DRIVER_USE_IUART */
 
 /** @} */
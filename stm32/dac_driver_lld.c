@@ -88,19 +88,23 @@ DACDriver DACD3;
 static void dac_lld_serve_tx_interrupt(DACDriver *dacp, uint32_t flags) {
 
 #if defined(STM32_DAC_DMA_ERROR_HOOK)
-  (void)dacp;
   if ((flags & (STM32_DMA_ISR_TEIF | STM32_DMA_ISR_DMEIF)) != 0) {
-    /* DMA errors handling.*/
-    //~ _dac_isr_error_code(dacp, flags);
+    /* DMA errors handling, the hook is the fallback for groups without
+       an error callback.*/
+    bool hook = dacp->grpp->error_cb == NULL;
+
+    _dac_isr_error_code(dacp, flags);
+    if (hook)
+      STM32_DAC_DMA_ERROR_HOOK(dacp);
   }
   else {
     if ((flags & STM32_DMA_ISR_HTIF) != 0) {
       /* Half transfer processing.*/
-      //~ _dac_isr_half_code(dacp);
+      _dac_isr_half_code(dacp);
     }
     if ((flags & STM32_DMA_ISR_TCIF) != 0) {
       /* Transfer complete processing.*/
-      //~ _dac_isr_full_code(dacp);
+      _dac_isr_full_code(dacp);
     }
   }
 #else
@@ -420,8 +424,10 @@ void dac_lld_start_conversion(DACDriver *dacp) {
   
   dmaStreamSetMemory0(dacp->dma, dacp->samples);
   dmaStreamSetTransactionSize(dacp->dma, dacp->depth);
+  /* Half transfer interrupt only makes sense with two semi-buffers.*/
   dmaStreamSetMode(dacp->dma, dacp->dmamode | STM32_DMA_CR_EN |
-  STM32_DMA_CR_CIRC);
+                   (dacp->grpp->circular ? STM32_DMA_CR_CIRC : 0) |
+                   ((dacp->depth > 1) ? STM32_DMA_CR_HTIE : 0));
   
   /* Timer start.*/
   dacp->dac->CR |= trgo << regshift; /* Enable timer trigger */
@@ -153,9 +153,11 @@
 
 /**
  * @brief   DAC DMA error hook.
+ * @note    Invoked after the conversion has been stopped and only for
+ *          groups without an error callback.
  */
 #if !defined(STM32_DAC_DMA_ERROR_HOOK) || defined(__DOXYGEN__)
-#define STM32_DAC_DMA_ERROR_HOOK(dacp)      osalSysHalt()
+#define STM32_DAC_DMA_ERROR_HOOK(dacp)      osalSysHalt("DMA failure")
 #endif
 
 /**
@@ -258,8 +260,26 @@ typedef uint16_t dacsample_t;
  *
  * @param[in] dacp      pointer to the @p DACDriver object triggering the
  *                      callback
+ * @param[in] buffer    pointer to the next semi-buffer to be filled
+ * @param[in] n         number of buffer rows available starting from
+ *                      @p buffer
  */
-typedef void (*daccallback_t)(DACDriver *dacp);
+typedef void (*daccallback_t)(DACDriver *dacp, const dacsample_t *buffer,
+                              size_t n);
+
+/**
+ * @brief   DAC errors, the DMA ISR flags of the failed transfer.
+ */
+typedef uint32_t dacerror_t;
+
+/**
+ * @brief   DAC error callback type.
+ *
+ * @param[in] dacp      pointer to the @p DACDriver object triggering the
+ *                      callback
+ * @param[in] err       DMA error flags
+ */
+typedef void (*dacerrorcallback_t)(DACDriver *dacp, dacerror_t err);
 
 typedef enum { 
   DAC_DHRM_12BIT_RIGHT = 0,
@@ -290,9 +310,15 @@ typedef struct {
   daccallback_t             end_cb;
   /**
    * @brief Error handling callback or @p NULL.
+   * @note    Without it DMA errors invoke @p STM32_DAC_DMA_ERROR_HOOK.
+   */
+  dacerrorcallback_t        error_cb;
+  /**
+   * @brief   Enables the circular buffer mode for the group.
+   * @note    Without it the buffer is converted once, then the conversion
+   *          ends and @p dacConvert() returns.
    */
-  daccallback_t             error_cb;
-  
+  bool                      circular;
 } DACConversionGroup;
 
 /**
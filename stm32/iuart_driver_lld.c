@@ -25,13 +25,10 @@
  */
 
 /**
- * Allows selection between DMA (the default) and interrupts for data transfer
- *
- * To enable interrupt handling, add to mcuconf.h:
- * #define STM32_IUART_USE_INTERRUPTS TRUE
- *
- * This enables interrupt handling for all defined IUART channels, releasing DMA
- * channels for other purposes.
+ * Data transfer is interrupt driven unless DMA is enabled for a direction
+ * of a port, see STM32_IUART_USARTx_USE_RX_DMA and
+ * STM32_IUART_USARTx_USE_TX_DMA. A direction whose DMA stream is already
+ * allocated when the driver is started falls back to interrupt transfers.
  */
 #include "hal.h"
 
@@ -43,6 +40,191 @@
 /* Driver local definitions.                                                 */
 /*===========================================================================*/
 
+#if IUART_USE_TXQUEUE
+#define tx_queue_pending(iuartp) ((iuartp)->txhead != (iuartp)->txtail)
+#else
+#define tx_queue_pending(iuartp) false
+#endif
+
+/* Word length bits, 9 bit data frames are stored as uint16_t.*/
+#if defined(USART_CR1_M1)
+#define USART_CR1_MBITS     (USART_CR1_M0 | USART_CR1_M1)
+#define USART_CR1_M9        USART_CR1_M0
+#else
+#define USART_CR1_MBITS     USART_CR1_M
+#define USART_CR1_M9        USART_CR1_M
+#endif
+
+/* Driver enable timing fields of CR1, not defined by all the headers.*/
+#define USART_CR1_DEAT_SHIFT    21
+#define USART_CR1_DEDT_SHIFT    16
+
+/* Physical end interrupt, only needed when there is a callback to invoke.*/
+#define tx_end_irq(iuartp)                                                  \
+  ((iuartp)->config->txend2_cb != NULL ? USART_CR1_TCIE : 0)
+
+#if !IUART_USE_CRC
+#define tx_crc_trailer(iuartp) false
+#endif
+
+#if !IUART_USE_RXCHAIN
+#define rx_chain_next(iuartp, remaining) false
+#endif
+
+#if !IUART_USE_TIMESTAMP
+#define rx_stamp(iuartp)
+#endif
+
+#if IUART_USE_TXPRIO
+#define tx_urgent_pending(iuartp) ((iuartp)->txuCount > 0)
+#else
+#define tx_urgent_pending(iuartp) false
+#define tx_prio_step(iuartp)
+#endif
+
+#if IUART_USE_STATS && STM32_IUART_HAS_CYCCNT
+#define isr_cycles()        DWT->CYCCNT
+#else
+#define isr_cycles()        0U
+#endif
+
+/* DMA data size matching the buffers layout.*/
+#define dma_data_size(iuartp)                                               \
+  ((iuartp)->wide ? (STM32_DMA_CR_PSIZE_HWORD | STM32_DMA_CR_MSIZE_HWORD) : 0)
+
+#if STM32_IUART_USE_TX_DMA && IUART_USE_TXQUEUE
+#define tx_dma_queued(iuartp) ((iuartp)->txdmaq)
+#else
+#define tx_dma_queued(iuartp) 0
+#endif
+
+/* Transmit DMA transfer in flight other than the block one.*/
+#if STM32_IUART_USE_TX_DMA && IUART_USE_TXPRIO
+#define tx_dma_aside(iuartp) (tx_dma_queued(iuartp) + (iuartp)->txdmau)
+#else
+#define tx_dma_aside(iuartp) tx_dma_queued(iuartp)
+#endif
+
+#define USART1_RX_DMA_CHANNEL                                               \
+  STM32_DMA_GETCHANNEL(STM32_IUART_USART1_RX_DMA_STREAM,                    \
+                       STM32_USART1_RX_DMA_CHN)
+
+#define USART1_TX_DMA_CHANNEL                                               \
+  STM32_DMA_GETCHANNEL(STM32_IUART_USART1_TX_DMA_STREAM,                    \
+                       STM32_USART1_TX_DMA_CHN)
+
+#define USART2_RX_DMA_CHANNEL                                               \
+  STM32_DMA_GETCHANNEL(STM32_IUART_USART2_RX_DMA_STREAM,                    \
+                       STM32_USART2_RX_DMA_CHN)
+
+#define USART2_TX_DMA_CHANNEL                                               \
+  STM32_DMA_GETCHANNEL(STM32_IUART_USART2_TX_DMA_STREAM,                    \
+                       STM32_USART2_TX_DMA_CHN)
+
+#define USART3_RX_DMA_CHANNEL                                               \
+  STM32_DMA_GETCHANNEL(STM32_IUART_USART3_RX_DMA_STREAM,                    \
+                       STM32_USART3_RX_DMA_CHN)
+
+#define USART3_TX_DMA_CHANNEL                                               \
+  STM32_DMA_GETCHANNEL(STM32_IUART_USART3_TX_DMA_STREAM,                    \
+                       STM32_USART3_TX_DMA_CHN)
+
+/* Kernel clocks, the HAL defines them where they are selectable.*/
+#if defined(STM32_USART1CLK)
+#define IUART_USART1_CLK  STM32_USART1CLK
+#elif defined(STM32F0XX)
+#define IUART_USART1_CLK  STM32_PCLK
+#else
+#define IUART_USART1_CLK  STM32_PCLK2
+#endif
+#if defined(STM32_USART2CLK)
+#define IUART_USART2_CLK  STM32_USART2CLK
+#elif defined(STM32F0XX)
+#define IUART_USART2_CLK  STM32_PCLK
+#else
+#define IUART_USART2_CLK  STM32_PCLK1
+#endif
+#if defined(STM32_USART3CLK)
+#define IUART_USART3_CLK  STM32_USART3CLK
+#elif defined(STM32F0XX)
+#define IUART_USART3_CLK  STM32_PCLK
+#else
+#define IUART_USART3_CLK  STM32_PCLK1
+#endif
+#if defined(STM32_UART4CLK)
+#define IUART_UART4_CLK   STM32_UART4CLK
+#elif defined(STM32F0XX)
+#define IUART_UART4_CLK   STM32_PCLK
+#else
+#define IUART_UART4_CLK   STM32_PCLK1
+#endif
+#if defined(STM32_UART5CLK)
+#define IUART_UART5_CLK   STM32_UART5CLK
+#elif defined(STM32F0XX)
+#define IUART_UART5_CLK   STM32_PCLK
+#else
+#define IUART_UART5_CLK   STM32_PCLK1
+#endif
+#if defined(STM32_USART6CLK)
+#define IUART_USART6_CLK  STM32_USART6CLK
+#elif defined(STM32F0XX)
+#define IUART_USART6_CLK  STM32_PCLK
+#else
+#define IUART_USART6_CLK  STM32_PCLK2
+#endif
+#if defined(STM32_UART7CLK)
+#define IUART_UART7_CLK   STM32_UART7CLK
+#elif defined(STM32F0XX)
+#define IUART_UART7_CLK   STM32_PCLK
+#else
+#define IUART_UART7_CLK   STM32_PCLK1
+#endif
+#if defined(STM32_UART8CLK)
+#define IUART_UART8_CLK   STM32_UART8CLK
+#elif defined(STM32F0XX)
+#define IUART_UART8_CLK   STM32_PCLK
+#else
+#define IUART_UART8_CLK   STM32_PCLK1
+#endif
+#if defined(STM32_LPUART1CLK)
+#define IUART_LPUART1_CLK STM32_LPUART1CLK
+#else
+#define IUART_LPUART1_CLK STM32_PCLK1
+#endif
+
+/* The APB1 enable register is split in two on the L4, G4, L5 and similar
+   families and in low/high halves on the H7.*/
+#if defined(RCC_APB1ENR1_USART2EN)
+#define IUART_APB1ENR       RCC->APB1ENR1
+#define IUART_APB1EN(p)     RCC_APB1ENR1_##p##EN
+#elif defined(RCC_APB1LENR_USART2EN)
+#define IUART_APB1ENR       RCC->APB1LENR
+#define IUART_APB1EN(p)     RCC_APB1LENR_##p##EN
+#else
+#define IUART_APB1ENR       RCC->APB1ENR
+#define IUART_APB1EN(p)     RCC_APB1ENR_##p##EN
+#endif
+
+/* The LPUART sits in the second APB1 enable register where there is one.*/
+#if defined(RCC_APB1ENR2_LPUART1EN)
+#define IUART_LPUART1_ENR   RCC->APB1ENR2
+#define IUART_LPUART1_EN    RCC_APB1ENR2_LPUART1EN
+#elif defined(RCC_APB4ENR_LPUART1EN)
+#define IUART_LPUART1_ENR   RCC->APB4ENR
+#define IUART_LPUART1_EN    RCC_APB4ENR_LPUART1EN
+#else
+#define IUART_LPUART1_ENR   RCC->APB1ENR
+#define IUART_LPUART1_EN    RCC_APB1ENR_LPUART1EN
+#endif
+
+/* DMA mode bits common to all ports.*/
+#define IUART_RX_DMA_MODE   (STM32_DMA_CR_DIR_P2M | STM32_DMA_CR_MINC |     \
+                             STM32_DMA_CR_TCIE | STM32_DMA_CR_TEIE |        \
+                             STM32_DMA_CR_DMEIE)
+#define IUART_TX_DMA_MODE   (STM32_DMA_CR_DIR_M2P | STM32_DMA_CR_MINC |     \
+                             STM32_DMA_CR_TCIE | STM32_DMA_CR_TEIE |        \
+                             STM32_DMA_CR_DMEIE)
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -62,10 +244,192 @@ IUARTDriver IUARTD2;
 IUARTDriver IUARTD3;
 #endif
 
+/** @brief UART4 IUART driver identifier.*/
+#if STM32_IUART_USE_UART4 || defined(__DOXYGEN__)
+IUARTDriver IUARTD4;
+#endif
+
+/** @brief UART5 IUART driver identifier.*/
+#if STM32_IUART_USE_UART5 || defined(__DOXYGEN__)
+IUARTDriver IUARTD5;
+#endif
+
+/** @brief USART6 IUART driver identifier.*/
+#if STM32_IUART_USE_USART6 || defined(__DOXYGEN__)
+IUARTDriver IUARTD6;
+#endif
+
+/** @brief UART7 IUART driver identifier.*/
+#if STM32_IUART_USE_UART7 || defined(__DOXYGEN__)
+IUARTDriver IUARTD7;
+#endif
+
+/** @brief UART8 IUART driver identifier.*/
+#if STM32_IUART_USE_UART8 || defined(__DOXYGEN__)
+IUARTDriver IUARTD8;
+#endif
+
+/** @brief LPUART1 IUART driver identifier.*/
+#if STM32_IUART_USE_LPUART1 || defined(__DOXYGEN__)
+IUARTDriver LPIUARTD1;
+#endif
+
 /*===========================================================================*/
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Descriptors of the enabled ports.
+ */
+static const stm32_iuart_port_t iuart_ports[] = {
+#if STM32_IUART_USE_USART1
+  {
+    .driver     = &IUARTD1,
+    .usart      = USART1,
+    .irq        = STM32_USART1_NUMBER,
+    .prio       = STM32_IUART_USART1_IRQ_PRIORITY,
+    .clock      = IUART_USART1_CLK,
+    .rccenr     = &RCC->APB2ENR,
+    .rccmask    = RCC_APB2ENR_USART1EN,
+    .lpuart     = false,
+#if STM32_IUART_USART1_USE_RX_DMA
+    .dmarx      = STM32_DMA_STREAM(STM32_IUART_USART1_RX_DMA_STREAM),
+    .rxdmamode  = STM32_DMA_CR_CHSEL(USART1_RX_DMA_CHANNEL) |
+                  STM32_DMA_CR_PL(STM32_IUART_USART1_DMA_PRIORITY) |
+                  IUART_RX_DMA_MODE,
+#endif
+#if STM32_IUART_USART1_USE_TX_DMA
+    .dmatx      = STM32_DMA_STREAM(STM32_IUART_USART1_TX_DMA_STREAM),
+    .txdmamode  = STM32_DMA_CR_CHSEL(USART1_TX_DMA_CHANNEL) |
+                  STM32_DMA_CR_PL(STM32_IUART_USART1_DMA_PRIORITY) |
+                  IUART_TX_DMA_MODE,
+#endif
+  },
+#endif
+#if STM32_IUART_USE_USART2
+  {
+    .driver     = &IUARTD2,
+    .usart      = USART2,
+    .irq        = STM32_USART2_NUMBER,
+    .prio       = STM32_IUART_USART2_IRQ_PRIORITY,
+    .clock      = IUART_USART2_CLK,
+    .rccenr     = &IUART_APB1ENR,
+    .rccmask    = IUART_APB1EN(USART2),
+    .lpuart     = false,
+#if STM32_IUART_USART2_USE_RX_DMA
+    .dmarx      = STM32_DMA_STREAM(STM32_IUART_USART2_RX_DMA_STREAM),
+    .rxdmamode  = STM32_DMA_CR_CHSEL(USART2_RX_DMA_CHANNEL) |
+                  STM32_DMA_CR_PL(STM32_IUART_USART2_DMA_PRIORITY) |
+                  IUART_RX_DMA_MODE,
+#endif
+#if STM32_IUART_USART2_USE_TX_DMA
+    .dmatx      = STM32_DMA_STREAM(STM32_IUART_USART2_TX_DMA_STREAM),
+    .txdmamode  = STM32_DMA_CR_CHSEL(USART2_TX_DMA_CHANNEL) |
+                  STM32_DMA_CR_PL(STM32_IUART_USART2_DMA_PRIORITY) |
+                  IUART_TX_DMA_MODE,
+#endif
+  },
+#endif
+#if STM32_IUART_USE_USART3
+  {
+    .driver     = &IUARTD3,
+    .usart      = USART3,
+    .irq        = STM32_USART3_NUMBER,
+    .prio       = STM32_IUART_USART3_IRQ_PRIORITY,
+    .clock      = IUART_USART3_CLK,
+    .rccenr     = &IUART_APB1ENR,
+    .rccmask    = IUART_APB1EN(USART3),
+    .lpuart     = false,
+#if STM32_IUART_USART3_USE_RX_DMA
+    .dmarx      = STM32_DMA_STREAM(STM32_IUART_USART3_RX_DMA_STREAM),
+    .rxdmamode  = STM32_DMA_CR_CHSEL(USART3_RX_DMA_CHANNEL) |
+                  STM32_DMA_CR_PL(STM32_IUART_USART3_DMA_PRIORITY) |
+                  IUART_RX_DMA_MODE,
+#endif
+#if STM32_IUART_USART3_USE_TX_DMA
+    .dmatx      = STM32_DMA_STREAM(STM32_IUART_USART3_TX_DMA_STREAM),
+    .txdmamode  = STM32_DMA_CR_CHSEL(USART3_TX_DMA_CHANNEL) |
+                  STM32_DMA_CR_PL(STM32_IUART_USART3_DMA_PRIORITY) |
+                  IUART_TX_DMA_MODE,
+#endif
+  },
+#endif
+#if STM32_IUART_USE_UART4
+  {
+    .driver     = &IUARTD4,
+    .usart      = UART4,
+    .irq        = STM32_UART4_NUMBER,
+    .prio       = STM32_IUART_UART4_IRQ_PRIORITY,
+    .clock      = IUART_UART4_CLK,
+    .rccenr     = &IUART_APB1ENR,
+    .rccmask    = IUART_APB1EN(UART4),
+    .lpuart     = false,
+  },
+#endif
+#if STM32_IUART_USE_UART5
+  {
+    .driver     = &IUARTD5,
+    .usart      = UART5,
+    .irq        = STM32_UART5_NUMBER,
+    .prio       = STM32_IUART_UART5_IRQ_PRIORITY,
+    .clock      = IUART_UART5_CLK,
+    .rccenr     = &IUART_APB1ENR,
+    .rccmask    = IUART_APB1EN(UART5),
+    .lpuart     = false,
+  },
+#endif
+#if STM32_IUART_USE_USART6
+  {
+    .driver     = &IUARTD6,
+    .usart      = USART6,
+    .irq        = STM32_USART6_NUMBER,
+    .prio       = STM32_IUART_USART6_IRQ_PRIORITY,
+    .clock      = IUART_USART6_CLK,
+    .rccenr     = &RCC->APB2ENR,
+    .rccmask    = RCC_APB2ENR_USART6EN,
+    .lpuart     = false,
+  },
+#endif
+#if STM32_IUART_USE_UART7
+  {
+    .driver     = &IUARTD7,
+    .usart      = UART7,
+    .irq        = STM32_UART7_NUMBER,
+    .prio       = STM32_IUART_UART7_IRQ_PRIORITY,
+    .clock      = IUART_UART7_CLK,
+    .rccenr     = &IUART_APB1ENR,
+    .rccmask    = IUART_APB1EN(UART7),
+    .lpuart     = false,
+  },
+#endif
+#if STM32_IUART_USE_UART8
+  {
+    .driver     = &IUARTD8,
+    .usart      = UART8,
+    .irq        = STM32_UART8_NUMBER,
+    .prio       = STM32_IUART_UART8_IRQ_PRIORITY,
+    .clock      = IUART_UART8_CLK,
+    .rccenr     = &IUART_APB1ENR,
+    .rccmask    = IUART_APB1EN(UART8),
+    .lpuart     = false,
+  },
+#endif
+#if STM32_IUART_USE_LPUART1
+  {
+    .driver     = &LPIUARTD1,
+    .usart      = LPUART1,
+    .irq        = STM32_LPUART1_NUMBER,
+    .prio       = STM32_IUART_LPUART1_IRQ_PRIORITY,
+    .clock      = IUART_LPUART1_CLK,
+    .rccenr     = &IUART_LPUART1_ENR,
+    .rccmask    = IUART_LPUART1_EN,
+    .lpuart     = true,
+  },
+#endif
+};
+
+#define IUART_NUM_PORTS     (sizeof iuart_ports / sizeof iuart_ports[0])
+
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
@@ -94,6 +458,66 @@ static iuartflags_t translate_errors(uint32_t isr)
   return sts;
 }
 
+#if IUART_USE_STATS || defined(__DOXYGEN__)
+/**
+ * @brief   Counts the receive errors by type.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] e          error flags
+ */
+static void count_errors(IUARTDriver *iuartp, iuartflags_t e) {
+
+  if (e & IUART_PARITY_ERROR)
+    iuartp->stats.parity++;
+  if (e & IUART_FRAMING_ERROR)
+    iuartp->stats.framing++;
+  if (e & IUART_OVERRUN_ERROR)
+    iuartp->stats.overrun++;
+  if (e & IUART_NOISE_ERROR)
+    iuartp->stats.noise++;
+  if (e & IUART_BREAK_DETECTED)
+    iuartp->stats.breaks++;
+}
+
+/**
+ * @brief   Accounts one USART ISR execution.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] t0         cycle counter at ISR entry
+ */
+static void count_isr(IUARTDriver *iuartp, uint32_t t0) {
+  uint32_t dt = isr_cycles() - t0;
+
+  iuartp->stats.isrcount++;
+  iuartp->stats.isrtotal += dt;
+  if (dt < iuartp->stats.isrmin)
+    iuartp->stats.isrmin = dt;
+  if (dt > iuartp->stats.isrmax)
+    iuartp->stats.isrmax = dt;
+}
+#endif /* IUART_USE_STATS */
+
+#if IUART_USE_FRAMING || defined(__DOXYGEN__)
+/**
+ * @brief   Receiver timeout in bit durations, zero when disabled.
+ * @details In Modbus mode this is the t3.5 interval, 3.5 characters of 11
+ *          bits up to 19200 baud and a fixed 1.75 ms above.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static uint32_t rx_timeout(IUARTDriver *iuartp) {
+
+#if IUART_USE_MODBUS
+  if (iuartp->config->modbus) {
+    if (iuartp->config->speed <= 19200)
+      return 39;
+    return (iuartp->config->speed * 7 + 3999) / 4000;
+  }
+#endif
+  return iuartp->config->rto;
+}
+#endif /* IUART_USE_FRAMING */
+
 /**
  * @brief   USART de-initialization.
  * @details This function must be invoked with interrupts disabled.
@@ -109,6 +533,47 @@ static void usart_stop(IUARTDriver *iuartp)
 }
 
 
+/**
+ * @brief   Baud rate divider setting.
+ * @details The divider is rounded to the nearest value. The oversampling
+ *          by 8 is used when set in @p cr1 or when the divider by 16 would
+ *          be below its minimum, its three fractional bits are then right
+ *          aligned in @p BRR.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ *
+ * @return               The oversampling bit to set in @p CR1.
+ */
+static uint32_t usart_speed(IUARTDriver *iuartp) {
+  uint32_t clock = iuartp->port->clock;
+  uint32_t speed = iuartp->config->speed;
+  uint32_t div;
+
+  /* The LPUART divider has 8 fractional bits.*/
+  if (iuartp->port->lpuart) {
+    div = (uint32_t)((((uint64_t)clock << 8) + speed / 2) / speed);
+    osalDbgAssert((div >= 0x300) && (div <= 0xFFFFF), "speed out of range");
+    iuartp->usart->BRR = div;
+    iuartp->baud = (uint32_t)((((uint64_t)clock << 8) + div / 2) / div);
+    return 0;
+  }
+
+  div = (clock + speed / 2) / speed;
+  if (((iuartp->config->cr1 & USART_CR1_OVER8) == 0) && (div >= 16)) {
+    osalDbgAssert(div <= 0xFFFF, "speed out of range");
+    iuartp->usart->BRR = div;
+    iuartp->baud = (clock + div / 2) / div;
+    return 0;
+  }
+
+  /* With the oversampling by 8 BRR[2:0] holds USARTDIV[3:1], USARTDIV[0]
+     is always zero so the divider is still whole clock periods.*/
+  osalDbgAssert((div >= 8) && (div <= 0x7FFF), "speed out of range");
+  iuartp->usart->BRR = ((div << 1) & 0xFFF0) | (div & 7);
+  iuartp->baud = (clock + div / 2) / div;
+  return USART_CR1_OVER8;
+}
+
 /**
  * @brief   USART initialization.
  * @details This function must be invoked with interrupts disabled.
@@ -118,43 +583,667 @@ static void usart_stop(IUARTDriver *iuartp)
 static void usart_start(IUARTDriver *iuartp) 
 {
   USART_TypeDef *u = iuartp->usart;
+  uint32_t over8;
 
   /* Defensive programming, starting from a clean state.*/
   usart_stop(iuartp);
 
   /* Baud rate setting.*/
-#if defined(STM32F0XX)
-  if (iuartp->usart == USART1)
-    u->BRR = STM32_USART1CLK / iuartp->config->speed;
-  else
-    u->BRR = STM32_PCLK / iuartp->config->speed;
-#else /* !defined(STM32F0XX) */
-  if (iuartp->usart == USART1)
-    u->BRR = STM32_PCLK2 / iuartp->config->speed;
-  else
-    u->BRR = STM32_PCLK1 / iuartp->config->speed;
-#endif /* !defined(STM32F0XX) */
+  over8 = usart_speed(iuartp);
 
   /* Resetting eventual pending status flags.*/
   u->ICR = 0xFFFFFFFF;
 
   /* Note that some bits are enforced because required for correct driver
      operations.*/
-  u->CR2 = iuartp->config->cr2 | USART_CR2_LBDIE;
+  u->CR2 = iuartp->config->cr2;
+  if (!iuartp->port->lpuart)
+    u->CR2 |= USART_CR2_LBDIE;        /* No LIN support on the LPUART.*/
+#if IUART_USE_FRAMING
+  /* Delimiter character must be set while the USART is disabled.*/
+  if (rx_timeout(iuartp) > 0) {
+    osalDbgAssert(!iuartp->port->lpuart, "no receiver timeout on LPUART");
+    u->RTOR = rx_timeout(iuartp) & USART_RTOR_RTO;
+    u->CR2 |= USART_CR2_RTOEN;
+  }
+  if (iuartp->config->match != 0)
+    u->CR2 |= ((uint32_t)(iuartp->config->match & 0xFF) << 24) |
+              USART_CR2_ADDM7;
+#endif
+
+#if IUART_USE_MUTE
+  /* The address shares the ADD field with the frame delimiter.*/
+  if (iuartp->config->mute != IUART_MUTE_OFF) {
+#if IUART_USE_FRAMING
+    osalDbgAssert(iuartp->config->match == 0, "ADD used by the delimiter");
+#endif
+    if (iuartp->config->mute == IUART_MUTE_ADDRESS)
+      u->CR2 |= ((uint32_t)iuartp->config->address << 24) |
+                (iuartp->config->address > 15 ? USART_CR2_ADDM7 : 0);
+  }
+#endif
 
   u->CR3 = iuartp->config->cr3 | USART_CR3_EIE;
-  u->CR1 = iuartp->config->cr1 | USART_CR1_UE | USART_CR1_PEIE |
+#if IUART_USE_FLOWCTL
+  if (iuartp->config->flow == IUART_FLOW_RTSCTS)
+    u->CR3 |= USART_CR3_RTSE | USART_CR3_CTSE;
+  else if (iuartp->config->flow == IUART_FLOW_SWRTS)
+    u->CR3 |= USART_CR3_CTSE;
+#endif
+#if IUART_USE_RS485
+  /* DE mode and timings are only writable while the USART is disabled.*/
+  if (iuartp->config->rs485) {
+    osalDbgAssert((iuartp->config->deat < 32) && (iuartp->config->dedt < 32),
+                  "DE time out of range");
+    u->CR3 |= USART_CR3_DEM;
+    u->CR1 = ((uint32_t)iuartp->config->deat << USART_CR1_DEAT_SHIFT) |
+             ((uint32_t)iuartp->config->dedt << USART_CR1_DEDT_SHIFT);
+  }
+#endif
+  u->CR1 |= iuartp->config->cr1 | over8 | USART_CR1_UE | USART_CR1_PEIE |
                             USART_CR1_RXNEIE | USART_CR1_TE |
                             USART_CR1_RE;       // Enable receive interrupts straight away
+#if IUART_USE_RXRING
+  if (iuartp->config->rxring != NULL)
+    u->CR1 |= USART_CR1_IDLEIE;
+#endif
+#if IUART_USE_FRAMING
+  if (rx_timeout(iuartp) > 0)
+    u->CR1 |= USART_CR1_RTOIE;
+  if (iuartp->config->match != 0)
+    u->CR1 |= USART_CR1_CMIE;
+#endif
+#if IUART_USE_MUTE
+  /* Mute mode is entered on request only, the receiver starts muted.*/
+  if (iuartp->config->mute != IUART_MUTE_OFF) {
+    u->CR1 |= USART_CR1_MME |
+              (iuartp->config->mute == IUART_MUTE_ADDRESS ? USART_CR1_WAKE : 0);
+    iuart_lld_mute(iuartp);
+  }
+#endif
+}
+
+
+#if IUART_USE_TIMESTAMP || defined(__DOXYGEN__)
+/**
+ * @brief   Latches the timestamps of a block receive data frame.
+ * @details With receive DMA only the first data frame raises RXNE, the
+ *          end is latched by the end of block interrupt.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static inline void rx_stamp(IUARTDriver *iuartp) {
+  uint32_t t;
+
+  if (!iuartp->config->timestamp)
+    return;
+  t = STM32_IUART_TIMESTAMP();
+  if (iuartp->rxfirst) {
+    iuartp->rxfirst       = false;
+    iuartp->rxstamp.start = t;
+  }
+  iuartp->rxstamp.end = t;
+}
+#endif /* IUART_USE_TIMESTAMP */
+
+/**
+ * @brief   Number of data frames still expected by the block receive.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static size_t rx_block_remaining(IUARTDriver *iuartp) {
+
+#if STM32_IUART_USE_RX_DMA
+  /* DMA keeps the requested size in rxCount, progress is in the stream.*/
+  if (iuartp->rxdma && (iuartp->rxCount > 0))
+    return dmaStreamGetTransactionSize(iuartp->port->dmarx);
+#endif
+  return iuartp->rxCount;
+}
+
+/**
+ * @brief   Ends the block receive, per character reception resumes.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static void rx_block_stop(IUARTDriver *iuartp) {
+
+#if STM32_IUART_USE_RX_DMA
+  if (iuartp->rxdma && (iuartp->rxCount > 0)) {
+    size_t n;
+
+    dmaStreamDisable(iuartp->port->dmarx);
+    n = iuartp->rxCount - dmaStreamGetTransactionSize(iuartp->port->dmarx);
+    _iuart_stats_add(iuartp, rxbytes, n);
+#if IUART_USE_CRC
+    /* No per character ISR, one pass over what the DMA stored.*/
+    if (iuartp->config->crc != NULL)
+      iuartp->rxcrc = iuartCRCUpdate(iuartp->config->crc, iuartp->rxcrc,
+                                     (const uint8_t *)iuartp->rxBuffer, n);
+#endif
+    iuartp->usart->CR3 &= ~USART_CR3_DMAR;
+    iuartp->usart->CR1 |= USART_CR1_RXNEIE;
+  }
+#endif
+  iuartp->rxCount = 0;
+  iuartp->rxBuffer = NULL;
+}
+
+#if IUART_USE_RXCHAIN || defined(__DOXYGEN__)
+/**
+ * @brief   Completes the chained buffer being filled.
+ * @details The next queued buffer, if any, is started right away so no
+ *          character goes elsewhere.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] remaining  data frames not received in the buffer
+ *
+ * @return               The block receive goes on into the next buffer.
+ */
+static bool rx_chain_next(IUARTDriver *iuartp, size_t remaining) {
+  const IUARTConfig *cfg = iuartp->config;
+  iuartrxdesc_t *dp;
+
+  if ((cfg->rxchain == NULL) || (iuartp->chfill == iuartp->chhead))
+    return false;
+
+  cfg->rxchain[iuartp->chfill & (cfg->rxchain_size - 1)].n -= remaining;
+  iuartp->chfill++;
+  _iuart_rx_chain_wakeup_isr(iuartp)
+  if (iuartp->chfill == iuartp->chhead)
+    return false;
+
+  dp = &cfg->rxchain[iuartp->chfill & (cfg->rxchain_size - 1)];
+  iuart_lld_start_receive(iuartp, dp->n, dp->buf);
+  return true;
+}
+#endif /* IUART_USE_RXCHAIN */
+
+#if IUART_USE_MODBUS || defined(__DOXYGEN__)
+/**
+ * @brief   Start of the block receive buffer.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] n          data frames received so far
+ */
+static uint8_t *rx_block_start(IUARTDriver *iuartp, size_t n) {
+
+#if STM32_IUART_USE_RX_DMA
+  /* DMA does not advance the buffer pointer.*/
+  if (iuartp->rxdma)
+    return (uint8_t *)iuartp->rxBuffer;
+#endif
+  return (uint8_t *)iuartp->rxBuffer - n;
+}
+
+/**
+ * @brief   Checks the Modbus frame received so far.
+ * @details The CRC is kept up to date by the ISR, with DMA it is computed
+ *          over the buffer instead.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] n          data frames received
+ */
+static bool rx_modbus_check(IUARTDriver *iuartp, size_t n) {
+  uint16_t crc = iuartp->mbcrc;
+
+#if STM32_IUART_USE_RX_DMA
+  if (iuartp->rxdma)
+    crc = iuartModbusCRC(rx_block_start(iuartp, n), n);
+#endif
+  /* Address, function code and CRC at least.*/
+  return (n >= 4) && (crc == 0);
+}
+#endif /* IUART_USE_MODBUS */
+
+#if IUART_USE_CRC || defined(__DOXYGEN__)
+/**
+ * @brief   Switches the block send to the appended CRC.
+ * @details Reflected CRCs go out low byte first, the others high byte
+ *          first.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ *
+ * @return               The CRC follows, the block is not complete yet.
+ */
+static bool tx_crc_trailer(IUARTDriver *iuartp) {
+  const iuartcrc_t *cp = iuartp->config->crc;
+  uint32_t crc;
+  unsigned i, n;
+
+  if ((cp == NULL) || !iuartp->config->crcappend || iuartp->crctrailer)
+    return false;
+
+  crc = _iuart_crc_final(cp, iuartp->txcrc);
+  n   = (cp->width + 7U) / 8U;
+  for (i = 0; i < n; i++)
+    iuartp->crcbuf[i] = (uint8_t)(crc >> (8U * (cp->reflected ? i :
+                                                n - 1U - i)));
+  iuartp->txBuf      = iuartp->crcbuf;
+  iuartp->txCount    = n;
+  iuartp->crctrailer = true;
+  return true;
+}
+#endif /* IUART_USE_CRC */
+
+#if IUART_USE_BRIDGE || defined(__DOXYGEN__)
+/**
+ * @brief   Forwards a received character to the bridged port.
+ * @details The character goes into the transmit queue of the other port,
+ *          whose transmitter is started if idle.
+ *
+ * @param[in] iuartp     pointer to the receiving @p IUARTDriver object
+ * @param[in] c          received character
+ */
+static void bridge_put(IUARTDriver *iuartp, uint8_t c) {
+  IUARTDriver *dst = iuartp->config->bridge;
+  size_t head, used;
+
+  if (dst->state != IUART_READY) {
+    _iuart_stats_add(iuartp, dropped, 1);
+    return;
+  }
+
+  head = dst->txhead;
+  used = head - dst->txtail;
+  if (used < dst->config->txring_size) {
+    dst->config->txring[head & (dst->config->txring_size - 1)] = c;
+    dst->txhead = head + 1;
+    _iuart_stats_max(dst, txhwm, used + 1);
+    osalSysLockFromISR();
+    iuart_lld_start_queue(dst);
+    osalSysUnlockFromISR();
+    if ((iuartp->config->bridge_hiwat > 0) && !iuartp->bridgestop &&
+        (used + 1 >= iuartp->config->bridge_hiwat)) {
+      iuartp->bridgestop = true;
+      _iuart_notify_isr(iuartp, flow_cb, IUART_EV_FLOW, true, (iuartp, true))
+    }
+  }
+  else {
+    _iuart_stats_add(iuartp, dropped, 1);
+    _iuart_notify_isr(iuartp, rxerr_cb, IUART_EV_RXERR, IUART_RING_FULL,
+                      (iuartp, IUART_RING_FULL))
+  }
+}
+
+/**
+ * @brief   Resumes the port forwarding into the queue, if stopped.
+ *
+ * @param[in] iuartp     pointer to the transmitting @p IUARTDriver object
+ */
+static void bridge_release(IUARTDriver *iuartp) {
+  IUARTDriver *src = iuartp->bridgefrom;
+
+  if ((src != NULL) && src->bridgestop && (src->config->bridge == iuartp) &&
+      (iuartp->txhead - iuartp->txtail <= src->config->bridge_lowat)) {
+    src->bridgestop = false;
+    _iuart_notify_isr(src, flow_cb, IUART_EV_FLOW, false, (src, false))
+  }
+}
+#else
+#define bridge_release(iuartp)
+#endif /* IUART_USE_BRIDGE */
+
+#if IUART_USE_FLOWCTL || defined(__DOXYGEN__)
+/**
+ * @brief   Stops the sender once the receive ring reaches the high
+ *          watermark.
+ * @details With @p IUART_FLOW_RTSCTS the next character is left in RDR,
+ *          the USART then deasserts RTS by itself.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static void rx_flow_stop(IUARTDriver *iuartp) {
+  const IUARTConfig *cfg = iuartp->config;
+
+  if (iuartp->rxstopped || (cfg->flow == IUART_FLOW_NONE) ||
+      (cfg->rx_hiwat == 0) ||
+      (iuartp->rxhead - iuartp->rxtail < cfg->rx_hiwat))
+    return;
+
+  iuartp->rxstopped = true;
+  if (cfg->flow == IUART_FLOW_SWRTS)
+    cfg->rts_cb(iuartp, true);
+#if STM32_IUART_USE_RX_DMA
+  else if (iuartp->rxdma)
+    iuartp->usart->CR3 &= ~USART_CR3_DMAR;
+#endif
+  else
+    iuartp->usart->CR1 &= ~USART_CR1_RXNEIE;
+}
+
+/**
+ * @brief   Releases the sender stopped by the high watermark.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static void rx_flow_release(IUARTDriver *iuartp) {
+
+  if (!iuartp->rxstopped)
+    return;
+
+  iuartp->rxstopped = false;
+  if (iuartp->config->flow == IUART_FLOW_SWRTS)
+    iuartp->config->rts_cb(iuartp, false);
+#if STM32_IUART_USE_RX_DMA
+  else if (iuartp->rxdma)
+    iuartp->usart->CR3 |= USART_CR3_DMAR;
+#endif
+  else
+    iuartp->usart->CR1 |= USART_CR1_RXNEIE;
+}
+#else
+#define rx_flow_stop(iuartp)
+#define rx_flow_release(iuartp)
+#endif /* IUART_USE_FLOWCTL */
+
+#if IUART_USE_TXPRIO || defined(__DOXYGEN__)
+/**
+ * @brief   Accounts a block data frame sent for the urgent lane boundaries.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static inline void tx_prio_step(IUARTDriver *iuartp) {
+
+  if (++iuartp->txseg >= iuartp->config->txprio_frames)
+    iuartp->txseg = 0;
+}
+
+/**
+ * @brief   Sends the next data frame of the urgent message.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] wide       data frames are stored as uint16_t
+ */
+static inline void tx_urgent_put(IUARTDriver *iuartp, const bool wide) {
+
+  if (wide) {
+    iuartp->usart->TDR = *(volatile const uint16_t *)iuartp->txuBuf;
+    iuartp->txuBuf += 2;
+  }
+  else
+    iuartp->usart->TDR = *iuartp->txuBuf++;
+  _iuart_stats_add(iuartp, txbytes, 1);
+  if (--(iuartp->txuCount) == 0) {
+    iuartp->txuBuf = NULL;
+    _iuart_notify_isr(iuartp, txurgent_cb, IUART_EV_TXURGENT, 0, (iuartp))
+  }
+}
+#endif /* IUART_USE_TXPRIO */
+
+#if STM32_IUART_USE_TX_DMA || defined(__DOXYGEN__)
+/**
+ * @brief   Starts the next transmit DMA transfer.
+ * @details The block transfer goes first, then the longest contiguous
+ *          part of the queue. With nothing left the physical end of
+ *          transmission is awaited.
+ * @pre     The transmit DMA stream is idle.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static void tx_dma_next(IUARTDriver *iuartp) {
+  const uint8_t *bp;
+  size_t n;
+  uint32_t size = 0;
+
+#if IUART_USE_TXPRIO
+  /* Each part of the block ends at a boundary.*/
+  if (tx_urgent_pending(iuartp)) {
+    bp   = (const uint8_t *)iuartp->txuBuf;
+    n    = iuartp->txuCount;
+    size = dma_data_size(iuartp);
+    iuartp->txdmau = true;
+  }
+  else
+#endif
+  if (iuartp->txCount > 0) {
+    bp   = (const uint8_t *)iuartp->txBuf;
+    n    = iuartp->txCount;
+    size = dma_data_size(iuartp);
+#if IUART_USE_TXPRIO
+    if ((iuartp->config->txprio_frames > 0) &&
+        (n > iuartp->config->txprio_frames))
+      n = iuartp->config->txprio_frames;
+    iuartp->txdman = (uint16_t)n;
+#endif
+  }
+#if IUART_USE_TXQUEUE
+  else if (tx_queue_pending(iuartp)) {
+    size_t ringsize = iuartp->config->txring_size;
+    size_t off      = iuartp->txtail & (ringsize - 1);
+
+    n = iuartp->txhead - iuartp->txtail;
+    if (n > ringsize - off)
+      n = ringsize - off;
+    bp = iuartp->config->txring + off;
+    iuartp->txdmaq = n;
+  }
+#endif
+  else {
+    iuartp->usart->CR1 |= tx_end_irq(iuartp);
+    return;
+  }
+
+  /* TC may be left over from a previous transfer.*/
+  iuartp->usart->ICR = USART_ISR_TC;
+  _iuart_stats_add(iuartp, txbytes, n);
+  dmaStreamSetMemory0(iuartp->port->dmatx, bp);
+  dmaStreamSetTransactionSize(iuartp->port->dmatx, n);
+  dmaStreamSetMode(iuartp->port->dmatx,
+                   iuartp->port->txdmamode | size | STM32_DMA_CR_EN);
+}
+
+/**
+ * @brief   Transmit DMA ISR service routine.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] flags      pre-shifted content of the ISR register
+ */
+static void serve_tx_dma_irq(IUARTDriver *iuartp, uint32_t flags) {
+
+  if ((flags & (STM32_DMA_ISR_TEIF | STM32_DMA_ISR_DMEIF)) != 0) {
+    STM32_IUART_DMA_ERROR_HOOK(iuartp);
+  }
+  dmaStreamDisable(iuartp->port->dmatx);
+
+#if IUART_USE_TXQUEUE
+  if (iuartp->txdmaq > 0) {
+    iuartp->txtail += iuartp->txdmaq;
+    iuartp->txdmaq = 0;
+    _iuart_tx_queue_wakeup_isr(iuartp)
+    bridge_release(iuartp);
+    tx_dma_next(iuartp);
+    return;
+  }
+#endif
+
+#if IUART_USE_TXPRIO
+  if (iuartp->txdmau) {
+    iuartp->txdmau   = false;
+    iuartp->txuCount = 0;
+    iuartp->txuBuf   = NULL;
+    _iuart_notify_isr(iuartp, txurgent_cb, IUART_EV_TXURGENT, 0, (iuartp))
+    /* The callback could have started another urgent message.*/
+    if (!iuartp->txdmau)
+      tx_dma_next(iuartp);
+    return;
+  }
+  if (iuartp->txCount > iuartp->txdman) {
+    /* Block part done, an urgent message can go before the next one.*/
+    iuartp->txBuf   += iuartp->wide ? 2U * iuartp->txdman : iuartp->txdman;
+    iuartp->txCount -= iuartp->txdman;
+    tx_dma_next(iuartp);
+    return;
+  }
+  iuartp->txdman = 0;
+#endif
+
+  if (tx_crc_trailer(iuartp)) {
+    tx_dma_next(iuartp);
+    return;
+  }
+
+  iuartp->txCount = 0;
+  iuartp->txBuf = NULL;
+  /* A callback is generated, if enabled, after a completed transfer.*/
+  iuartp->txstate = IUART_TX_COMPLETE;
+  _iuart_notify_isr(iuartp, txend1_cb, IUART_EV_TXEND1, 0, (iuartp))
+
+  /* If the callback didn't explicitly change state then the transmitter
+     automatically returns to the idle state.*/
+  if (iuartp->txstate == IUART_TX_COMPLETE)
+    iuartp->txstate = IUART_TX_IDLE;
+
+  /* The callback could have restarted the stream already.*/
+  if ((iuartp->txCount == 0) && (tx_dma_aside(iuartp) == 0))
+    tx_dma_next(iuartp);
+}
+#endif /* STM32_IUART_USE_TX_DMA */
+
+#if STM32_IUART_USE_RX_DMA || defined(__DOXYGEN__)
+/**
+ * @brief   Receive DMA ISR service routine.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] flags      pre-shifted content of the ISR register
+ */
+static void serve_rx_dma_irq(IUARTDriver *iuartp, uint32_t flags) {
+
+  if ((flags & (STM32_DMA_ISR_TEIF | STM32_DMA_ISR_DMEIF)) != 0) {
+    STM32_IUART_DMA_ERROR_HOOK(iuartp);
+  }
+
+#if IUART_USE_RXRING
+  if (iuartp->config->rxring != NULL) {
+    /* Half or whole ring filled by the circular transfer.*/
+    iuart_lld_rx_ring_sync(iuartp);
+    if (iuartp->rxhead != iuartp->rxtail)
+      _iuart_rx_ring_wakeup_isr(iuartp);
+    return;
+  }
+#endif
+
+  /* Receiver in active state, a callback is generated, if enabled, after
+     a completed transfer. A chained buffer keeps the receiver active.*/
+  rx_stamp(iuartp);
+  if (!rx_chain_next(iuartp, 0)) {
+    rx_block_stop(iuartp);
+    iuartp->rxstate = IUART_RX_COMPLETE;
+  }
+  _iuart_notify_isr(iuartp, rxend_cb, IUART_EV_RXEND, 0, (iuartp))
+
+  /* If the callback didn't explicitly change state then the receiver
+     automatically returns to the idle state.*/
+  if (iuartp->rxstate == IUART_RX_COMPLETE)
+    iuartp->rxstate = IUART_RX_IDLE;
+}
+#endif /* STM32_IUART_USE_RX_DMA */
+
+/**
+ * @brief   Allocates the DMA streams of the port.
+ * @details A direction whose stream cannot be allocated is served by
+ *          interrupts.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] prio       DMA interrupt priority
+ */
+static void dma_allocate(IUARTDriver *iuartp, uint32_t prio) {
+
+#if STM32_IUART_USE_RX_DMA
+  iuartp->rxdma = (iuartp->port->dmarx != NULL) &&
+                  !dmaStreamAllocate(iuartp->port->dmarx, prio,
+                                     (stm32_dmaisr_t)serve_rx_dma_irq,
+                                     (void *)iuartp);
+  if (iuartp->rxdma)
+    dmaStreamSetPeripheral(iuartp->port->dmarx, &iuartp->usart->RDR);
+#endif
+#if STM32_IUART_USE_TX_DMA
+  iuartp->txdma = (iuartp->port->dmatx != NULL) &&
+                  !dmaStreamAllocate(iuartp->port->dmatx, prio,
+                                     (stm32_dmaisr_t)serve_tx_dma_irq,
+                                     (void *)iuartp);
+  if (iuartp->txdma)
+    dmaStreamSetPeripheral(iuartp->port->dmatx, &iuartp->usart->TDR);
+#endif
+  (void)iuartp;
+  (void)prio;
+}
+
+/**
+ * @brief   Releases the DMA streams of the port.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static void dma_release(IUARTDriver *iuartp) {
+
+#if STM32_IUART_USE_RX_DMA
+  if (iuartp->rxdma) {
+    dmaStreamDisable(iuartp->port->dmarx);
+    dmaStreamRelease(iuartp->port->dmarx);
+    iuartp->rxdma = false;
+  }
+#endif
+#if STM32_IUART_USE_TX_DMA
+  if (iuartp->txdma) {
+    dmaStreamDisable(iuartp->port->dmatx);
+    dmaStreamRelease(iuartp->port->dmatx);
+    iuartp->txdma = false;
+  }
+#endif
+  (void)iuartp;
 }
 
+/**
+ * @brief   Enables DMA requests after the USART has been (re)configured.
+ * @details The receive ring, if any, is filled by a circular transfer.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static void dma_start(IUARTDriver *iuartp) {
+
+#if STM32_IUART_USE_RX_DMA
+  if (iuartp->rxdma) {
+    dmaStreamDisable(iuartp->port->dmarx);
+#if IUART_USE_RXRING
+    if (iuartp->config->rxring != NULL) {
+#if IUART_USE_FLOWCTL
+      /* Checked at each half ring, a higher level would be noticed only
+         once the ring is full.*/
+      osalDbgAssert((iuartp->config->flow == IUART_FLOW_NONE) ||
+                    (iuartp->config->rx_hiwat <=
+                     iuartp->config->rxring_size / 2),
+                    "watermark above half ring");
+#endif
+      iuartp->usart->CR1 &= ~USART_CR1_RXNEIE;
+      dmaStreamSetMemory0(iuartp->port->dmarx, iuartp->config->rxring);
+      dmaStreamSetTransactionSize(iuartp->port->dmarx,
+                                  iuartp->config->rxring_size);
+      dmaStreamSetMode(iuartp->port->dmarx,
+                       iuartp->port->rxdmamode | STM32_DMA_CR_CIRC |
+                       STM32_DMA_CR_HTIE | STM32_DMA_CR_EN);
+      iuartp->usart->CR3 |= USART_CR3_DMAR;
+    }
+#endif
+  }
+#endif
+#if STM32_IUART_USE_TX_DMA
+  if (iuartp->txdma) {
+    dmaStreamDisable(iuartp->port->dmatx);
+    iuartp->usart->CR3 |= USART_CR3_DMAT;
+  }
+#endif
+  (void)iuartp;
+}
 
 /**
  * @brief   USART common service routine.
+ * @details Instantiated for 8 bit and 16 bit buffers, @p wide is a
+ *          constant so the data path has no per character test.
  *
  * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] wide       buffers are organized as uint16_t arrays
  */
-static void serve_usart_irq(IUARTDriver *iuartp) {
+static inline void serve_usart_irq(IUARTDriver *iuartp, const bool wide) {
 
   uint32_t isr;
   USART_TypeDef *u = iuartp->usart;
@@ -166,27 +1255,61 @@ static void serve_usart_irq(IUARTDriver *iuartp) {
   /* Error condition detection.*/
   if (isr & (USART_ISR_LBDF | USART_ISR_ORE | USART_ISR_NE |
              USART_ISR_FE  | USART_ISR_PE)) {
-    if (iuartp->config->rxerr_cb != NULL)
-      iuartp->config->rxerr_cb(iuartp, translate_errors(isr));        // Receive error callback
+    iuartflags_t e = translate_errors(isr);
+#if IUART_USE_STATS
+    count_errors(iuartp, e);
+#endif
+    _iuart_notify_isr(iuartp, rxerr_cb, IUART_EV_RXERR, e, (iuartp, e))
   }
 
   uint32_t cr1 = u->CR1;
 
-  /* Data available (receive). */
-  if (isr & USART_ISR_RXNE) 
+#if IUART_USE_TIMESTAMP && STM32_IUART_USE_RX_DMA
+  /* First data frame of a DMA block receive, stamped and left in RDR for
+     the DMA that takes over from here.*/
+  if ((cr1 & USART_CR1_RXNEIE) && (isr & USART_ISR_RXNE) &&
+      iuartp->rxdma && (iuartp->rxCount > 0))
+  {
+    rx_stamp(iuartp);
+    cr1 &= ~USART_CR1_RXNEIE;
+    u->CR1 = cr1;
+    u->CR3 |= USART_CR3_DMAR;
+  }
+#endif
+
+  /* Data available (receive), unless DMA is reading the data register. */
+  if ((cr1 & USART_CR1_RXNEIE) && (isr & USART_ISR_RXNE)) 
   {
 	iuartp->rxbuf = (uint16_t)u->RDR;            // Get the character
+	_iuart_stats_add(iuartp, rxbytes, 1);
 	if (iuartp->rxCount > 0)
 	{   // Must be a block receive
-	  *iuartp->rxBuffer++ = iuartp->rxbuf;        // Problem with >8-bit data here - @TODO: needs handling
+	  rx_stamp(iuartp);
+	  if (wide)
+	  {
+	    *(volatile uint16_t *)iuartp->rxBuffer = iuartp->rxbuf;
+	    iuartp->rxBuffer += 2;
+	  }
+	  else
+	    *iuartp->rxBuffer++ = (uint8_t)iuartp->rxbuf;
+#if IUART_USE_CRC
+	  if (iuartp->config->crc != NULL)
+	    iuartp->rxcrc = _iuart_crc_update(iuartp->config->crc, iuartp->rxcrc,
+	                                      iuartp->rxbuf);
+#endif
+#if IUART_USE_MODBUS
+	  if (iuartp->config->modbus)
+	    iuartp->mbcrc = IUART_MODBUS_CRC_UPDATE(iuartp->mbcrc,
+	                                            iuartp->rxbuf);
+#endif
 	  (iuartp->rxCount)--;
 	  if (iuartp->rxCount == 0)
 	  {
 	    /* Receiver in active state, a callback is generated, if enabled, after
-	       a completed transfer.*/
-	    iuartp->rxstate = IUART_RX_COMPLETE;
-	    if (iuartp->config->rxend_cb != NULL)
-	      iuartp->config->rxend_cb(iuartp);
+	       a completed transfer. A chained buffer keeps the receiver active.*/
+	    if (!rx_chain_next(iuartp, 0))
+	      iuartp->rxstate = IUART_RX_COMPLETE;
+	    _iuart_notify_isr(iuartp, rxend_cb, IUART_EV_RXEND, 0, (iuartp))
 
 	    /* If the callback didn't explicitly change state then the receiver
 	       automatically returns to the idle state.*/
@@ -197,41 +1320,195 @@ static void serve_usart_irq(IUARTDriver *iuartp) {
 	}
 	else
 	{   // Receive character while in IUART_RX_IDLE mode
-      if (iuartp->config->rxchar_cb != NULL)
-        iuartp->config->rxchar_cb(iuartp, iuartp->rxbuf);				// Receive character callback
+#if IUART_USE_BRIDGE
+      if (iuartp->config->bridge != NULL)
+        bridge_put(iuartp, (uint8_t)iuartp->rxbuf);
+      else
+#endif
+#if IUART_USE_RXRING
+      if (iuartp->config->rxring != NULL)
+      {
+        _iuart_rx_ring_put_isr(iuartp, iuartp->rxbuf)
+        rx_flow_stop(iuartp);
+      }
+      else
+#endif
+      _iuart_notify_isr(iuartp, rxchar_cb, IUART_EV_RXCHAR, iuartp->rxbuf,
+                        (iuartp, iuartp->rxbuf))
 	}
   }
 
+#if IUART_USE_FRAMING
+  /* End of frame, by receiver timeout or by delimiter character. The
+     delimiter itself has already been stored by the RXNE handling. CMF is
+     raised for any character equal to ADD, so only enabled sources count.*/
+  if (((cr1 & USART_CR1_RTOIE) && (isr & USART_ISR_RTOF)) ||
+      ((cr1 & USART_CR1_CMIE) && (isr & USART_ISR_CMF)))
+  {
+    if (iuartp->rxstate == IUART_RX_ACTIVE)
+    {
+      size_t n = iuartp->rxSize - rx_block_remaining(iuartp);
+#if IUART_USE_TIMESTAMP && STM32_IUART_USE_RX_DMA
+      if (iuartp->rxdma && (n > 0))
+        rx_stamp(iuartp);
+#endif
+#if IUART_USE_MODBUS
+      if ((n > 0) && iuartp->config->modbus && !rx_modbus_check(iuartp, n))
+      {
+        /* Damaged frame, the same buffer waits for the next one.*/
+        iuart_lld_start_receive(iuartp, iuartp->rxSize,
+                                rx_block_start(iuartp, n));
+        _iuart_notify_isr(iuartp, rxerr_cb, IUART_EV_RXERR, IUART_CRC_ERROR,
+                          (iuartp, IUART_CRC_ERROR))
+      }
+      else
+#endif
+      if (n > 0)
+      {
+        if (!rx_chain_next(iuartp, iuartp->rxSize - n))
+        {
+          rx_block_stop(iuartp);
+          iuartp->rxstate = IUART_RX_COMPLETE;
+        }
+#if IUART_USE_MODBUS
+        if (iuartp->config->modbus)
+          n -= 2;                       /* Checked CRC, not delivered.*/
+#endif
+        _iuart_notify_isr(iuartp, rxframe_cb, IUART_EV_RXFRAME, n,
+                          (iuartp, n))
+
+        /* If the callback didn't explicitly change state then the receiver
+           automatically returns to the idle state.*/
+        if (iuartp->rxstate == IUART_RX_COMPLETE)
+          iuartp->rxstate = IUART_RX_IDLE;
+      }
+    }
+#if IUART_USE_RXRING
+    else
+    {
+      iuart_lld_rx_ring_sync(iuartp);
+      if (iuartp->rxhead != iuartp->rxtail)
+        _iuart_rx_ring_wakeup_isr(iuartp);
+    }
+#endif
+  }
+#endif
+
+#if IUART_USE_RXRING
+  /* Line idle, a short burst is handed over to the reader.*/
+  if (isr & USART_ISR_IDLE)
+  {
+    iuart_lld_rx_ring_sync(iuartp);
+    if (iuartp->rxhead != iuartp->rxtail)
+      _iuart_rx_ring_wakeup_isr(iuartp);
+  }
+#endif
+
   /* Transmission buffer empty.*/
   if ((cr1 & USART_CR1_TXEIE) && (isr & USART_ISR_TXE)) 
   {
-    u->TDR = *iuartp->txBuf++;         // Next character to transmit output buffer
-    if (--(iuartp->txCount) == 0)
+#if IUART_USE_TXPRIO
+    if (tx_urgent_pending(iuartp) &&
+        ((iuartp->txCount == 0) || (iuartp->txseg == 0)))
+    {   // Urgent message at a block boundary, the block resumes after it
+      tx_urgent_put(iuartp, wide);
+    }
+    else
+#endif
+#if IUART_USE_TXQUEUE
+    if (iuartp->txCount == 0)
+    {   // No block transfer in progress, next character comes from the queue
+      size_t tail = iuartp->txtail;
+      u->TDR = iuartp->config->txring[tail & (iuartp->config->txring_size - 1)];
+      iuartp->txtail = tail + 1;
+      _iuart_stats_add(iuartp, txbytes, 1);
+      _iuart_tx_queue_wakeup_isr(iuartp)
+      bridge_release(iuartp);
+    }
+    else
+#endif
     {
-      iuartp->txBuf = NULL;
-      /* A callback is generated, if enabled, after a completed transfer.*/
-      iuartp->txstate = IUART_TX_COMPLETE;
-	  if (iuartp->config->txend1_cb != NULL)
-		iuartp->config->txend1_cb(iuartp);            // Signal that Tx buffer finished with
-
-	  /* If the callback didn't explicitly change state then the transmitter
-	     automatically returns to the idle state.*/
-	  if (iuartp->txstate == IUART_TX_COMPLETE)
-	    iuartp->txstate = IUART_TX_IDLE;
-      u->CR1 = (cr1 & ~USART_CR1_TXEIE) | USART_CR1_TCIE;       // Disable transmit data interrupt, enable TxBuffer empty
+      if (wide)
+      {
+        u->TDR = *(volatile const uint16_t *)iuartp->txBuf;
+        iuartp->txBuf += 2;
+      }
+      else
+      {
+        u->TDR = *iuartp->txBuf;         // Next character to transmit output buffer
+#if IUART_USE_CRC
+        if ((iuartp->config->crc != NULL) && !iuartp->crctrailer)
+          iuartp->txcrc = _iuart_crc_update(iuartp->config->crc, iuartp->txcrc,
+                                            *iuartp->txBuf);
+#endif
+        iuartp->txBuf++;
+      }
+      _iuart_stats_add(iuartp, txbytes, 1);
+      tx_prio_step(iuartp);
+      /* An appended CRC is sent before the block counts as complete.*/
+      if ((--(iuartp->txCount) == 0) && !tx_crc_trailer(iuartp))
+      {
+        iuartp->txBuf = NULL;
+        /* A callback is generated, if enabled, after a completed transfer.*/
+        iuartp->txstate = IUART_TX_COMPLETE;
+        _iuart_notify_isr(iuartp, txend1_cb, IUART_EV_TXEND1, 0, (iuartp))
+
+        /* If the callback didn't explicitly change state then the transmitter
+           automatically returns to the idle state.*/
+        if (iuartp->txstate == IUART_TX_COMPLETE)
+          iuartp->txstate = IUART_TX_IDLE;
+      }
     }
+    /* Keeps TXE enabled while there is anything left, a new block started
+       by the callback or queued data follow without idle gap.*/
+    if ((iuartp->txCount == 0) && !tx_queue_pending(iuartp) &&
+        !tx_urgent_pending(iuartp))
+      u->CR1 = (u->CR1 & ~USART_CR1_TXEIE) | tx_end_irq(iuartp);   // Disable transmit data interrupt, enable TxBuffer empty if needed
   }
   /* Physical transmission end.*/
-  if (isr & USART_ISR_TC)
+  if ((cr1 & USART_CR1_TCIE) && (isr & USART_ISR_TC))
   {
-    if (iuartp->config->txend2_cb != NULL)
-      iuartp->config->txend2_cb(iuartp);      // Signal that whole transmit message gone
-    u->CR1 = cr1 & ~USART_CR1_TCIE;         // Disable transmit buffer empty interrupt
+    _iuart_notify_isr(iuartp, txend2_cb, IUART_EV_TXEND2, 0, (iuartp))
+    u->CR1 &= ~USART_CR1_TCIE;              // Disable transmit buffer empty interrupt
   }
 }
 
 
 
+/**
+ * @brief   USART service routine for up to 8 bit data frames.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static void serve_usart_irq8(IUARTDriver *iuartp) {
+#if IUART_USE_STATS
+  uint32_t t0 = isr_cycles();
+
+  serve_usart_irq(iuartp, false);
+  count_isr(iuartp, t0);
+#else
+
+  serve_usart_irq(iuartp, false);
+#endif
+}
+
+/**
+ * @brief   USART service routine for 9 bit data frames.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ */
+static void serve_usart_irq16(IUARTDriver *iuartp) {
+#if IUART_USE_STATS
+  uint32_t t0 = isr_cycles();
+
+  serve_usart_irq(iuartp, true);
+  count_isr(iuartp, t0);
+#else
+
+  serve_usart_irq(iuartp, true);
+#endif
+}
+
 /*===========================================================================*/
 /* Driver interrupt handlers.                                                */
 /*===========================================================================*/
@@ -249,7 +1526,7 @@ CH_IRQ_HANDLER(STM32_USART1_HANDLER) {
 
   CH_IRQ_PROLOGUE();
 
-  serve_usart_irq(&IUARTD1);
+  IUARTD1.serve(&IUARTD1);
 
   CH_IRQ_EPILOGUE();
 }
@@ -268,7 +1545,7 @@ CH_IRQ_HANDLER(STM32_USART2_HANDLER) {
 
   CH_IRQ_PROLOGUE();
 
-  serve_usart_irq(&IUARTD2);
+  IUARTD2.serve(&IUARTD2);
 
   CH_IRQ_EPILOGUE();
 }
@@ -287,12 +1564,126 @@ CH_IRQ_HANDLER(STM32_USART3_HANDLER) {
 
   CH_IRQ_PROLOGUE();
 
-  serve_usart_irq(&IUARTD3);
+  IUARTD3.serve(&IUARTD3);
 
   CH_IRQ_EPILOGUE();
 }
 #endif /* STM32_IUART_USE_USART3 */
 
+#if STM32_IUART_USE_UART4 || defined(__DOXYGEN__)
+#if !defined(STM32_UART4_HANDLER)
+#error "STM32_UART4_HANDLER not defined"
+#endif
+/**
+ * @brief   UART4 IRQ handler.
+ *
+ * @isr
+ */
+CH_IRQ_HANDLER(STM32_UART4_HANDLER) {
+
+  CH_IRQ_PROLOGUE();
+
+  IUARTD4.serve(&IUARTD4);
+
+  CH_IRQ_EPILOGUE();
+}
+#endif /* STM32_IUART_USE_UART4 */
+
+#if STM32_IUART_USE_UART5 || defined(__DOXYGEN__)
+#if !defined(STM32_UART5_HANDLER)
+#error "STM32_UART5_HANDLER not defined"
+#endif
+/**
+ * @brief   UART5 IRQ handler.
+ *
+ * @isr
+ */
+CH_IRQ_HANDLER(STM32_UART5_HANDLER) {
+
+  CH_IRQ_PROLOGUE();
+
+  IUARTD5.serve(&IUARTD5);
+
+  CH_IRQ_EPILOGUE();
+}
+#endif /* STM32_IUART_USE_UART5 */
+
+#if STM32_IUART_USE_USART6 || defined(__DOXYGEN__)
+#if !defined(STM32_USART6_HANDLER)
+#error "STM32_USART6_HANDLER not defined"
+#endif
+/**
+ * @brief   USART6 IRQ handler.
+ *
+ * @isr
+ */
+CH_IRQ_HANDLER(STM32_USART6_HANDLER) {
+
+  CH_IRQ_PROLOGUE();
+
+  IUARTD6.serve(&IUARTD6);
+
+  CH_IRQ_EPILOGUE();
+}
+#endif /* STM32_IUART_USE_USART6 */
+
+#if STM32_IUART_USE_UART7 || defined(__DOXYGEN__)
+#if !defined(STM32_UART7_HANDLER)
+#error "STM32_UART7_HANDLER not defined"
+#endif
+/**
+ * @brief   UART7 IRQ handler.
+ *
+ * @isr
+ */
+CH_IRQ_HANDLER(STM32_UART7_HANDLER) {
+
+  CH_IRQ_PROLOGUE();
+
+  IUARTD7.serve(&IUARTD7);
+
+  CH_IRQ_EPILOGUE();
+}
+#endif /* STM32_IUART_USE_UART7 */
+
+#if STM32_IUART_USE_UART8 || defined(__DOXYGEN__)
+#if !defined(STM32_UART8_HANDLER)
+#error "STM32_UART8_HANDLER not defined"
+#endif
+/**
+ * @brief   UART8 IRQ handler.
+ *
+ * @isr
+ */
+CH_IRQ_HANDLER(STM32_UART8_HANDLER) {
+
+  CH_IRQ_PROLOGUE();
+
+  IUARTD8.serve(&IUARTD8);
+
+  CH_IRQ_EPILOGUE();
+}
+#endif /* STM32_IUART_USE_UART8 */
+
+#if STM32_IUART_USE_LPUART1 || defined(__DOXYGEN__)
+#if !defined(STM32_LPUART1_HANDLER)
+#error "STM32_LPUART1_HANDLER not defined"
+#endif
+/**
+ * @brief   LPUART1 IRQ handler.
+ *
+ * @isr
+ */
+CH_IRQ_HANDLER(STM32_LPUART1_HANDLER) {
+
+  CH_IRQ_PROLOGUE();
+
+  LPIUARTD1.serve(&LPIUARTD1);
+
+  CH_IRQ_EPILOGUE();
+}
+#endif /* STM32_IUART_USE_LPUART1 */
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -303,21 +1694,25 @@ CH_IRQ_HANDLER(STM32_USART3_HANDLER) {
  * @notapi
  */
 void iuart_lld_init(void) {
+  unsigned i;
 
-#if STM32_IUART_USE_USART1
-  iuartObjectInit(&IUARTD1);
-  IUARTD1.usart   = USART1;
+#if (IUART_USE_STATS || IUART_USE_TIMESTAMP) && STM32_IUART_HAS_CYCCNT
+  /* Cycle counter used for the ISR profiling and the timestamps.*/
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 #endif
 
-#if STM32_IUART_USE_USART2
-  iuartObjectInit(&IUARTD2);
-  IUARTD2.usart   = USART2;
-#endif
+  for (i = 0; i < IUART_NUM_PORTS; i++) {
+    IUARTDriver *iuartp = iuart_ports[i].driver;
 
-#if STM32_IUART_USE_USART3
-  iuartObjectInit(&IUARTD3);
-  IUARTD3.usart   = USART3;
+    iuartObjectInit(iuartp);
+    iuartp->port  = &iuart_ports[i];
+    iuartp->usart = iuart_ports[i].usart;
+    iuartp->serve = serve_usart_irq8;
+#if IUART_USE_BRIDGE
+    iuartp->bridgefrom = NULL;
 #endif
+  }
 }
 
 /**
@@ -329,39 +1724,76 @@ void iuart_lld_init(void) {
  */
 void iuart_lld_start(IUARTDriver *iuartp) {
 
-  if (iuartp->state == IUART_STOP) {
-#if STM32_IUART_USE_USART1
-    if (&IUARTD1 == iuartp) 
-	{
-      rccEnableUSART1(FALSE);
-      nvicEnableVector(STM32_USART1_NUMBER, STM32_IUART_USART1_IRQ_PRIORITY);
-    }
+  /* Data frames of 9 bits, parity excluded, need 16 bit buffers.*/
+  iuartp->wide  = (iuartp->config->cr1 & (USART_CR1_MBITS | USART_CR1_PCE)) ==
+                  USART_CR1_M9;
+  iuartp->serve = iuartp->wide ? serve_usart_irq16 : serve_usart_irq8;
+#if IUART_USE_RXRING
+  osalDbgAssert(!iuartp->wide || (iuartp->config->rxring == NULL),
+                "ring needs 8 bit data");
 #endif
-
-#if STM32_IUART_USE_USART2
-    if (&IUARTD2 == iuartp) {
-
-      rccEnableUSART2(FALSE);
-      nvicEnableVector(STM32_USART2_NUMBER, STM32_IUART_USART2_IRQ_PRIORITY);
-    }
+#if IUART_USE_TXQUEUE
+  osalDbgAssert(!iuartp->wide || (iuartp->config->txring == NULL),
+                "queue needs 8 bit data");
 #endif
-
-#if STM32_IUART_USE_USART3
-    if (&IUARTD3 == iuartp) {
-      bool b;
-      rccEnableUSART3(FALSE);
-      nvicEnableVector(STM32_USART3_NUMBER, STM32_IUART_USART3_IRQ_PRIORITY);
-    }
+#if IUART_USE_MODBUS
+  osalDbgAssert(!iuartp->wide || !iuartp->config->modbus,
+                "Modbus needs 8 bit data");
+#endif
+#if IUART_USE_CRC
+  osalDbgAssert(!iuartp->wide || (iuartp->config->crc == NULL),
+                "CRC needs 8 bit data");
+#endif
+#if IUART_USE_BRIDGE
+  if (iuartp->config->bridge != NULL) {
+    osalDbgAssert(!iuartp->wide, "bridge needs 8 bit data");
+    osalDbgAssert(iuartp->config->bridge->port->prio == iuartp->port->prio,
+                  "bridged ports need the same IRQ priority");
+#if IUART_USE_RXRING
+    osalDbgAssert(iuartp->config->rxring == NULL, "bridge replaces the ring");
+#endif
+    iuartp->config->bridge->bridgefrom = iuartp;
+  }
+  iuartp->bridgestop = false;
+#endif
+#if IUART_USE_FLOWCTL
+  osalDbgAssert((iuartp->config->rx_hiwat == 0) ||
+                (iuartp->config->rx_lowat < iuartp->config->rx_hiwat),
+                "invalid watermarks");
+  osalDbgAssert((iuartp->config->flow != IUART_FLOW_SWRTS) ||
+                (iuartp->config->rts_cb != NULL), "no RTS callback");
+  iuartp->rxstopped = false;
+  if (iuartp->config->flow == IUART_FLOW_SWRTS)
+    iuartp->config->rts_cb(iuartp, false);
 #endif
+#if IUART_USE_TXPRIO
+  iuartp->txuCount = 0;
+  iuartp->txuBuf   = NULL;
+#if STM32_IUART_USE_TX_DMA
+  iuartp->txdman   = 0;
+  iuartp->txdmau   = false;
+#endif
+#endif
+
+  if (iuartp->state == IUART_STOP) {
+    const stm32_iuart_port_t *port = iuartp->port;
+
+    *port->rccenr |= port->rccmask;
+    nvicEnableVector(port->irq, port->prio);
+    dma_allocate(iuartp, port->prio);
 
     iuartp->rxbuf = 0;
     iuartp->rxCount = 0;
     iuartp->rxBuffer = NULL;
+    /* A block send stopped with the driver is not resumed.*/
+    iuartp->txCount = 0;
+    iuartp->txBuf = NULL;
   }
 
   iuartp->rxstate = IUART_RX_IDLE;
   iuartp->txstate = IUART_TX_IDLE;
   usart_start(iuartp);
+  dma_start(iuartp);
 }
 
 /**
@@ -374,31 +1806,15 @@ void iuart_lld_start(IUARTDriver *iuartp) {
 void iuart_lld_stop(IUARTDriver *iuartp) {
 
   if (iuartp->state == IUART_READY) {
-    usart_stop(iuartp);
-
-#if STM32_IUART_USE_USART1
-    if (&IUARTD1 == iuartp) {
-      nvicDisableVector(STM32_USART1_NUMBER);
-      rccDisableUSART1(FALSE);
-      return;
-    }
-#endif
-
-#if STM32_IUART_USE_USART2
-    if (&IUARTD2 == iuartp) {
-      nvicDisableVector(STM32_USART2_NUMBER);
-      rccDisableUSART2(FALSE);
-      return;
-    }
-#endif
-
-#if STM32_IUART_USE_USART3
-    if (&IUARTD3 == iuartp) {
-      nvicDisableVector(STM32_USART3_NUMBER);
-      rccDisableUSART3(FALSE);
-      return;
-    }
+#if IUART_USE_BRIDGE
+    if ((iuartp->config->bridge != NULL) &&
+        (iuartp->config->bridge->bridgefrom == iuartp))
+      iuartp->config->bridge->bridgefrom = NULL;
 #endif
+    usart_stop(iuartp);
+    dma_release(iuartp);
+    nvicDisableVector(iuartp->port->irq);
+    *iuartp->port->rccenr &= ~iuartp->port->rccmask;
   }
 }
 
@@ -420,14 +1836,31 @@ void iuart_lld_start_send(IUARTDriver *iuartp, size_t n, const void *txbuf) {
     return;             // Already transmission in progress - not much we can do
   }
   iuartp->txBuf = (uint8_t *)txbuf;
-  if (0)
-  {
-    iuartp->txCount = 2*n;     // 16-bit data  - @TODO: How do we determine this?
-  }
-  else
+#if IUART_USE_TXPRIO
+  iuartp->txseg = 0;
+#endif
+#if IUART_USE_CRC
+  if (iuartp->config->crc != NULL)
+    iuartp->txcrc = iuartp->config->crc->init;
+  iuartp->crctrailer = false;
+#endif
+#if STM32_IUART_USE_TX_DMA
+  if (iuartp->txdma)
   {
-    iuartp->txCount = n;     // 8-bit data
+#if IUART_USE_CRC
+    /* No per character ISR, one pass before the transfer.*/
+    if (iuartp->config->crc != NULL)
+      iuartp->txcrc = iuartCRCUpdate(iuartp->config->crc, iuartp->txcrc,
+                                     (const uint8_t *)txbuf, n);
+#endif
+    iuartp->txCount = n;
+    /* Otherwise it starts when the queued part in flight is done.*/
+    if (tx_dma_aside(iuartp) == 0)
+      tx_dma_next(iuartp);
+    return;
   }
+#endif
+  iuartp->txCount = n;       // Data frames, the ISR steps txBuf by frame size
 
   // Now enable transmit interrupts - just the data interrupt
   iuartp->usart->CR1 |= USART_CR1_TXEIE;
@@ -446,13 +1879,107 @@ void iuart_lld_start_send(IUARTDriver *iuartp, size_t n, const void *txbuf) {
  */
 size_t iuart_lld_stop_send(IUARTDriver *iuartp) {
 
+#if STM32_IUART_USE_TX_DMA
+  if (iuartp->txdma) {
+    size_t rem = iuartp->txCount;
+
+    iuartp->usart->CR1 &= ~USART_CR1_TCIE;
+    if ((rem > 0) && (tx_dma_aside(iuartp) == 0)) {
+      /* Block transfer in flight.*/
+      dmaStreamDisable(iuartp->port->dmatx);
+      rem = dmaStreamGetTransactionSize(iuartp->port->dmatx);
+      _iuart_stats_add(iuartp, txbytes, -(uint32_t)rem);
+#if IUART_USE_TXPRIO
+      rem += iuartp->txCount - iuartp->txdman;    // Parts not started yet
+      iuartp->txdman = 0;
+#endif
+      iuartp->txCount = 0;
+      iuartp->txBuf = NULL;
+      if (tx_queue_pending(iuartp) || tx_urgent_pending(iuartp))
+        tx_dma_next(iuartp);          // Queued data is not affected
+    }
+    else {
+      iuartp->txCount = 0;
+      iuartp->txBuf = NULL;
+    }
+    return rem;
+  }
+#endif
+
   size_t rem = iuartp->txCount;
   iuartp->usart->CR1 &= ~(USART_CR1_TXEIE | USART_CR1_TCIE);
   iuartp->txCount = 0;        // Clear character count and buffer reference
   iuartp->txBuf = NULL;
+  if (tx_queue_pending(iuartp) || tx_urgent_pending(iuartp))
+    iuartp->usart->CR1 |= USART_CR1_TXEIE;  // Queued data is not affected
   return rem;
 }
 
+#if IUART_USE_TXQUEUE || defined(__DOXYGEN__)
+/**
+ * @brief   Makes sure the transmitter is draining the queue.
+ * @note    A pending physical end notification is postponed after the
+ *          newly queued data.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ *
+ * @notapi
+ */
+void iuart_lld_start_queue(IUARTDriver *iuartp) {
+
+#if STM32_IUART_USE_TX_DMA
+  if (iuartp->txdma) {
+    /* A transfer in flight continues with the queue when done.*/
+    if ((iuartp->txCount == 0) && (tx_dma_aside(iuartp) == 0)) {
+      iuartp->usart->CR1 &= ~USART_CR1_TCIE;
+      tx_dma_next(iuartp);
+    }
+    return;
+  }
+#endif
+  iuartp->usart->CR1 = (iuartp->usart->CR1 & ~USART_CR1_TCIE) |
+                       USART_CR1_TXEIE;
+}
+#endif /* IUART_USE_TXQUEUE */
+
+#if IUART_USE_TXPRIO || defined(__DOXYGEN__)
+/**
+ * @brief   Starts an urgent transmission on the IUART peripheral.
+ * @details The message goes out at the next boundary of the block send in
+ *          progress, before the queued data.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] n         number of data frames to send
+ * @param[in] txbuf     the pointer to the transmit buffer
+ *
+ * @return              The message has been started.
+ * @retval false        An urgent message is already being sent.
+ *
+ * @notapi
+ */
+bool iuart_lld_start_urgent(IUARTDriver *iuartp, size_t n,
+                            const void *txbuf) {
+
+  if (iuartp->txuCount > 0)
+    return false;
+  iuartp->txuBuf   = (uint8_t *)txbuf;
+  iuartp->txuCount = (uint16_t)n;
+#if STM32_IUART_USE_TX_DMA
+  if (iuartp->txdma) {
+    /* Otherwise it starts when the transfer in flight is done.*/
+    if ((iuartp->txCount == 0) && (tx_dma_aside(iuartp) == 0)) {
+      iuartp->usart->CR1 &= ~USART_CR1_TCIE;
+      tx_dma_next(iuartp);
+    }
+    return true;
+  }
+#endif
+  iuartp->usart->CR1 = (iuartp->usart->CR1 & ~USART_CR1_TCIE) |
+                       USART_CR1_TXEIE;
+  return true;
+}
+#endif /* IUART_USE_TXPRIO */
+
 /**
  * @brief   Starts a receive operation on the IUART peripheral.
  * @note    The buffers are organized as uint8_t arrays for data sizes below
@@ -466,13 +1993,50 @@ size_t iuart_lld_stop_send(IUARTDriver *iuartp) {
  */
 void iuart_lld_start_receive(IUARTDriver *iuartp, size_t n, void *rxbuf) {
 
-
-  /* Just copy across new info - abandon any previous receive in progress */
-  osalSysLock();
+  /* Just copy across new info - abandon any previous receive in progress.
+     Called from a lock zone by the high level driver.*/
+  rx_block_stop(iuartp);
+  rx_flow_release(iuartp);            // The block takes what RDR holds
   iuartp->rxBuffer = rxbuf;
   iuartp->rxCount = n;
+#if IUART_USE_FRAMING
+  iuartp->rxSize = n;
+#endif
+#if IUART_USE_MODBUS
+  iuartp->mbcrc = IUART_MODBUS_CRC_INIT;
+#endif
+#if IUART_USE_CRC
+  if (iuartp->config->crc != NULL)
+    iuartp->rxcrc = iuartp->config->crc->init;
+#endif
+#if IUART_USE_TIMESTAMP
+  iuartp->rxfirst = true;
+#endif
   iuartp->rxstate = IUART_RX_ACTIVE;
-  osalSysUnlock();
+
+#if STM32_IUART_USE_RX_DMA
+  if (iuartp->rxdma)
+  {
+#if IUART_USE_RXRING
+    osalDbgAssert(iuartp->config->rxring == NULL, "DMA owned by ring");
+#endif
+    dmaStreamSetMemory0(iuartp->port->dmarx, rxbuf);
+    dmaStreamSetTransactionSize(iuartp->port->dmarx, n);
+    dmaStreamSetMode(iuartp->port->dmarx, iuartp->port->rxdmamode |
+                     dma_data_size(iuartp) | STM32_DMA_CR_EN);
+#if IUART_USE_TIMESTAMP
+    /* RXNE stays enabled, the first data frame interrupt latches the start
+       timestamp and then hands the data register over to the DMA.*/
+    if (iuartp->config->timestamp) {
+      iuartp->usart->CR3 &= ~USART_CR3_DMAR;
+      iuartp->usart->CR1 |= USART_CR1_RXNEIE;
+      return;
+    }
+#endif
+    iuartp->usart->CR1 &= ~USART_CR1_RXNEIE;
+    iuartp->usart->CR3 |= USART_CR3_DMAR;
+  }
+#endif
 }
 
 /**
@@ -489,16 +2053,59 @@ void iuart_lld_start_receive(IUARTDriver *iuartp, size_t n, void *rxbuf) {
 size_t iuart_lld_stop_receive(IUARTDriver *iuartp) {
   size_t n;
 
-  osalSysLock();
-  iuartp->rxBuffer = NULL;
-  n = iuartp->rxCount;
-  iuartp->rxCount = 0;
+  /* Called from a lock zone by the high level driver.*/
+  n = rx_block_remaining(iuartp);
+  rx_block_stop(iuartp);
   iuartp->rxstate = IUART_RX_IDLE;
-  osalSysUnlock();
 
   return n;
 }
 
+#if (IUART_USE_RXRING && STM32_IUART_USE_RX_DMA) || defined(__DOXYGEN__)
+/**
+ * @brief   Brings the receive ring write index up to date.
+ * @details The circular DMA transfer position is turned into the free
+ *          running write index of the ring.
+ * @note    The DMA overwrites unread data if the reader falls behind by
+ *          more than the ring size, this is not detected.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ *
+ * @notapi
+ */
+void iuart_lld_rx_ring_sync(IUARTDriver *iuartp) {
+
+  if (iuartp->rxdma && (iuartp->config->rxring != NULL)) {
+    size_t size = iuartp->config->rxring_size;
+    size_t pos  = size - dmaStreamGetTransactionSize(iuartp->port->dmarx);
+    size_t head = iuartp->rxhead;
+    size_t n    = (pos - head) & (size - 1);
+
+    iuartp->rxhead = head + n;
+    _iuart_stats_add(iuartp, rxbytes, n);
+    _iuart_stats_max(iuartp, rxhwm, head + n - iuartp->rxtail);
+    rx_flow_stop(iuartp);
+  }
+}
+#endif
+
+#if IUART_USE_FLOWCTL || defined(__DOXYGEN__)
+/**
+ * @brief   Releases the sender once the receive ring is drained enough.
+ * @details Invoked after the reader has moved the ring read index.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ *
+ * @notapi
+ */
+void iuart_lld_rx_flow(IUARTDriver *iuartp) {
+
+  if (iuartp->rxstopped &&
+      (iuartp->rxhead - iuartp->rxtail <= iuartp->config->rx_lowat))
+    rx_flow_release(iuartp);
+}
+#endif
+
 #endif /* DRIVER_USE_IUART */
 
 /** @} */
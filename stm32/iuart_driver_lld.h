@@ -14,9 +14,9 @@
     limitations under the License.
 	
 	
-	IUART Driver modified to use interrupts throughout, as an option; just define:
-		STM32_IUART_USE_INTERRUPTS	TRUE
-	or	STM32_IUART_USE_DMA			TRUE
+	IUART Driver modified to use interrupts throughout, with optional DMA
+	per port and direction, see STM32_IUART_USARTx_USE_RX_DMA and
+	STM32_IUART_USARTx_USE_TX_DMA below.
 */
 
 /**
@@ -27,13 +27,13 @@
  * @{
  */
 /**
- * Allows selection between DMA (the default) and interrupts for data transfer
+ * Data transfer is interrupt driven unless DMA is enabled for a direction
+ * of a port, for example in mcuconf.h:
+ * #define STM32_IUART_USART1_USE_RX_DMA TRUE
+ * #define STM32_IUART_USART1_USE_TX_DMA TRUE
  *
- * To enable interrupt handling, add to mcuconf.h:
- * #define STM32_IUART_USE_INTERRUPTS TRUE
- *
- * This enables interrupt handling for all defined IUART channels, releasing DMA
- * channels for other purposes.
+ * A direction whose DMA stream is already allocated when the driver is
+ * started falls back to interrupt transfers.
  */
 
 #ifndef _IUART_LLD_H_
@@ -80,6 +80,60 @@
 #define STM32_IUART_USE_USART3               FALSE
 #endif
 
+/**
+ * @brief   IUART driver on UART4 enable switch.
+ * @details If set to @p TRUE the support for UART4 is included.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USE_UART4) || defined(__DOXYGEN__)
+#define STM32_IUART_USE_UART4                 FALSE
+#endif
+
+/**
+ * @brief   IUART driver on UART5 enable switch.
+ * @details If set to @p TRUE the support for UART5 is included.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USE_UART5) || defined(__DOXYGEN__)
+#define STM32_IUART_USE_UART5                 FALSE
+#endif
+
+/**
+ * @brief   IUART driver on USART6 enable switch.
+ * @details If set to @p TRUE the support for USART6 is included.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USE_USART6) || defined(__DOXYGEN__)
+#define STM32_IUART_USE_USART6                FALSE
+#endif
+
+/**
+ * @brief   IUART driver on UART7 enable switch.
+ * @details If set to @p TRUE the support for UART7 is included.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USE_UART7) || defined(__DOXYGEN__)
+#define STM32_IUART_USE_UART7                 FALSE
+#endif
+
+/**
+ * @brief   IUART driver on UART8 enable switch.
+ * @details If set to @p TRUE the support for UART8 is included.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USE_UART8) || defined(__DOXYGEN__)
+#define STM32_IUART_USE_UART8                 FALSE
+#endif
+
+/**
+ * @brief   IUART driver on LPUART1 enable switch.
+ * @details If set to @p TRUE the support for LPUART1 is included.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USE_LPUART1) || defined(__DOXYGEN__)
+#define STM32_IUART_USE_LPUART1               FALSE
+#endif
+
 /**
  * @brief   USART1 interrupt priority level setting.
  */
@@ -101,6 +155,190 @@
 #define STM32_IUART_USART3_IRQ_PRIORITY      12
 #endif
 
+/**
+ * @brief   UART4 interrupt priority level setting.
+ */
+#if !defined(STM32_IUART_UART4_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_IUART_UART4_IRQ_PRIORITY          12
+#endif
+
+/**
+ * @brief   UART5 interrupt priority level setting.
+ */
+#if !defined(STM32_IUART_UART5_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_IUART_UART5_IRQ_PRIORITY          12
+#endif
+
+/**
+ * @brief   USART6 interrupt priority level setting.
+ */
+#if !defined(STM32_IUART_USART6_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_IUART_USART6_IRQ_PRIORITY         12
+#endif
+
+/**
+ * @brief   UART7 interrupt priority level setting.
+ */
+#if !defined(STM32_IUART_UART7_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_IUART_UART7_IRQ_PRIORITY          12
+#endif
+
+/**
+ * @brief   UART8 interrupt priority level setting.
+ */
+#if !defined(STM32_IUART_UART8_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_IUART_UART8_IRQ_PRIORITY          12
+#endif
+
+/**
+ * @brief   LPUART1 interrupt priority level setting.
+ */
+#if !defined(STM32_IUART_LPUART1_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_IUART_LPUART1_IRQ_PRIORITY        12
+#endif
+
+/**
+ * @brief   USART1 receive DMA enable switch.
+ * @details If set to @p TRUE block and ring receive use DMA.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USART1_USE_RX_DMA) || defined(__DOXYGEN__)
+#define STM32_IUART_USART1_USE_RX_DMA        FALSE
+#endif
+
+/**
+ * @brief   USART1 transmit DMA enable switch.
+ * @details If set to @p TRUE block and queued transmit use DMA.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USART1_USE_TX_DMA) || defined(__DOXYGEN__)
+#define STM32_IUART_USART1_USE_TX_DMA        FALSE
+#endif
+
+/**
+ * @brief   USART2 receive DMA enable switch.
+ * @details If set to @p TRUE block and ring receive use DMA.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USART2_USE_RX_DMA) || defined(__DOXYGEN__)
+#define STM32_IUART_USART2_USE_RX_DMA        FALSE
+#endif
+
+/**
+ * @brief   USART2 transmit DMA enable switch.
+ * @details If set to @p TRUE block and queued transmit use DMA.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USART2_USE_TX_DMA) || defined(__DOXYGEN__)
+#define STM32_IUART_USART2_USE_TX_DMA        FALSE
+#endif
+
+/**
+ * @brief   USART3 receive DMA enable switch.
+ * @details If set to @p TRUE block and ring receive use DMA.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USART3_USE_RX_DMA) || defined(__DOXYGEN__)
+#define STM32_IUART_USART3_USE_RX_DMA        FALSE
+#endif
+
+/**
+ * @brief   USART3 transmit DMA enable switch.
+ * @details If set to @p TRUE block and queued transmit use DMA.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(STM32_IUART_USART3_USE_TX_DMA) || defined(__DOXYGEN__)
+#define STM32_IUART_USART3_USE_TX_DMA        FALSE
+#endif
+
+/**
+ * @brief   USART1 DMA priority (0..3|lowest..highest).
+ */
+#if !defined(STM32_IUART_USART1_DMA_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_IUART_USART1_DMA_PRIORITY      0
+#endif
+
+/**
+ * @brief   USART2 DMA priority (0..3|lowest..highest).
+ */
+#if !defined(STM32_IUART_USART2_DMA_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_IUART_USART2_DMA_PRIORITY      0
+#endif
+
+/**
+ * @brief   USART3 DMA priority (0..3|lowest..highest).
+ */
+#if !defined(STM32_IUART_USART3_DMA_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_IUART_USART3_DMA_PRIORITY      0
+#endif
+
+/**
+ * @brief   Free running counter latched by the receive timestamps.
+ * @details The DWT cycle counter by default, a timer counter register can
+ *          be read instead, for example @p STM32_TIM2->CNT. Cores without
+ *          the cycle counter, Cortex-M0 and M0+, must define it.
+ */
+#if (!defined(STM32_IUART_TIMESTAMP) &&                                     \
+     defined(DWT_CTRL_CYCCNTENA_Msk)) || defined(__DOXYGEN__)
+#define STM32_IUART_TIMESTAMP()              DWT->CYCCNT
+#endif
+
+/**
+ * @brief   IUART DMA error hook.
+ */
+#if !defined(STM32_IUART_DMA_ERROR_HOOK) || defined(__DOXYGEN__)
+#define STM32_IUART_DMA_ERROR_HOOK(iuartp)   osalSysHalt("DMA failure")
+#endif
+
+/**
+ * @brief   DMA stream used for USART1 RX operations.
+ * @note    This option is only available on platforms with enhanced DMA.
+ */
+#if !defined(STM32_IUART_USART1_RX_DMA_STREAM) || defined(__DOXYGEN__)
+#define STM32_IUART_USART1_RX_DMA_STREAM     STM32_DMA_STREAM_ID(1, 5)
+#endif
+
+/**
+ * @brief   DMA stream used for USART1 TX operations.
+ * @note    This option is only available on platforms with enhanced DMA.
+ */
+#if !defined(STM32_IUART_USART1_TX_DMA_STREAM) || defined(__DOXYGEN__)
+#define STM32_IUART_USART1_TX_DMA_STREAM     STM32_DMA_STREAM_ID(1, 4)
+#endif
+
+/**
+ * @brief   DMA stream used for USART2 RX operations.
+ * @note    This option is only available on platforms with enhanced DMA.
+ */
+#if !defined(STM32_IUART_USART2_RX_DMA_STREAM) || defined(__DOXYGEN__)
+#define STM32_IUART_USART2_RX_DMA_STREAM     STM32_DMA_STREAM_ID(1, 6)
+#endif
+
+/**
+ * @brief   DMA stream used for USART2 TX operations.
+ * @note    This option is only available on platforms with enhanced DMA.
+ */
+#if !defined(STM32_IUART_USART2_TX_DMA_STREAM) || defined(__DOXYGEN__)
+#define STM32_IUART_USART2_TX_DMA_STREAM     STM32_DMA_STREAM_ID(1, 7)
+#endif
+
+/**
+ * @brief   DMA stream used for USART3 RX operations.
+ * @note    This option is only available on platforms with enhanced DMA.
+ */
+#if !defined(STM32_IUART_USART3_RX_DMA_STREAM) || defined(__DOXYGEN__)
+#define STM32_IUART_USART3_RX_DMA_STREAM     STM32_DMA_STREAM_ID(1, 3)
+#endif
+
+/**
+ * @brief   DMA stream used for USART3 TX operations.
+ * @note    This option is only available on platforms with enhanced DMA.
+ */
+#if !defined(STM32_IUART_USART3_TX_DMA_STREAM) || defined(__DOXYGEN__)
+#define STM32_IUART_USART3_TX_DMA_STREAM     STM32_DMA_STREAM_ID(1, 2)
+#endif
+/** @} */
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -117,8 +355,35 @@
 #error "USART3 not present in the selected device"
 #endif
 
+#if STM32_IUART_USE_UART4 && !STM32_HAS_UART4
+#error "UART4 not present in the selected device"
+#endif
+
+#if STM32_IUART_USE_UART5 && !STM32_HAS_UART5
+#error "UART5 not present in the selected device"
+#endif
+
+#if STM32_IUART_USE_USART6 && !STM32_HAS_USART6
+#error "USART6 not present in the selected device"
+#endif
+
+#if STM32_IUART_USE_UART7 && !STM32_HAS_UART7
+#error "UART7 not present in the selected device"
+#endif
+
+#if STM32_IUART_USE_UART8 && !STM32_HAS_UART8
+#error "UART8 not present in the selected device"
+#endif
+
+#if STM32_IUART_USE_LPUART1 && !STM32_HAS_LPUART1
+#error "LPUART1 not present in the selected device"
+#endif
+
 #if !STM32_IUART_USE_USART1 && !STM32_IUART_USE_USART2 &&                     \
-    !STM32_IUART_USE_USART3
+    !STM32_IUART_USE_USART3 && !STM32_IUART_USE_UART4 &&                      \
+    !STM32_IUART_USE_UART5 && !STM32_IUART_USE_USART6 &&                      \
+    !STM32_IUART_USE_UART7 && !STM32_IUART_USE_UART8 &&                       \
+    !STM32_IUART_USE_LPUART1
 #error "IUART driver activated but no USART/IUART peripheral assigned"
 #endif
 
@@ -137,6 +402,124 @@
 #error "Invalid IRQ priority assigned to USART3"
 #endif
 
+#if STM32_IUART_USE_UART4 &&                                                    \
+    !CORTEX_IS_VALID_KERNEL_PRIORITY(STM32_IUART_UART4_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to UART4"
+#endif
+
+#if STM32_IUART_USE_UART5 &&                                                    \
+    !CORTEX_IS_VALID_KERNEL_PRIORITY(STM32_IUART_UART5_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to UART5"
+#endif
+
+#if STM32_IUART_USE_USART6 &&                                                   \
+    !CORTEX_IS_VALID_KERNEL_PRIORITY(STM32_IUART_USART6_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to USART6"
+#endif
+
+#if STM32_IUART_USE_UART7 &&                                                    \
+    !CORTEX_IS_VALID_KERNEL_PRIORITY(STM32_IUART_UART7_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to UART7"
+#endif
+
+#if STM32_IUART_USE_UART8 &&                                                    \
+    !CORTEX_IS_VALID_KERNEL_PRIORITY(STM32_IUART_UART8_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to UART8"
+#endif
+
+#if STM32_IUART_USE_LPUART1 &&                                                  \
+    !CORTEX_IS_VALID_KERNEL_PRIORITY(STM32_IUART_LPUART1_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to LPUART1"
+#endif
+
+/**
+ * @brief   At least one port receives through DMA.
+ */
+#define STM32_IUART_USE_RX_DMA                                              \
+  ((STM32_IUART_USE_USART1 && STM32_IUART_USART1_USE_RX_DMA) ||             \
+   (STM32_IUART_USE_USART2 && STM32_IUART_USART2_USE_RX_DMA) ||             \
+   (STM32_IUART_USE_USART3 && STM32_IUART_USART3_USE_RX_DMA))
+
+/**
+ * @brief   At least one port transmits through DMA.
+ */
+#define STM32_IUART_USE_TX_DMA                                              \
+  ((STM32_IUART_USE_USART1 && STM32_IUART_USART1_USE_TX_DMA) ||             \
+   (STM32_IUART_USE_USART2 && STM32_IUART_USART2_USE_TX_DMA) ||             \
+   (STM32_IUART_USE_USART3 && STM32_IUART_USART3_USE_TX_DMA))
+
+#if STM32_IUART_USE_RX_DMA || STM32_IUART_USE_TX_DMA
+/* The following checks are only required when there is a DMA able to
+   reassign streams to different channels.*/
+#if STM32_ADVANCED_DMA
+/* Check on the validity of the assigned DMA channels.*/
+#if STM32_IUART_USE_USART1 && STM32_IUART_USART1_USE_RX_DMA &&               \
+    !STM32_DMA_IS_VALID_ID(STM32_IUART_USART1_RX_DMA_STREAM,                 \
+                           STM32_USART1_RX_DMA_MSK)
+#error "invalid DMA stream associated to USART1 RX"
+#endif
+
+#if STM32_IUART_USE_USART1 && STM32_IUART_USART1_USE_TX_DMA &&               \
+    !STM32_DMA_IS_VALID_ID(STM32_IUART_USART1_TX_DMA_STREAM,                 \
+                           STM32_USART1_TX_DMA_MSK)
+#error "invalid DMA stream associated to USART1 TX"
+#endif
+
+#if STM32_IUART_USE_USART2 && STM32_IUART_USART2_USE_RX_DMA &&               \
+    !STM32_DMA_IS_VALID_ID(STM32_IUART_USART2_RX_DMA_STREAM,                 \
+                           STM32_USART2_RX_DMA_MSK)
+#error "invalid DMA stream associated to USART2 RX"
+#endif
+
+#if STM32_IUART_USE_USART2 && STM32_IUART_USART2_USE_TX_DMA &&               \
+    !STM32_DMA_IS_VALID_ID(STM32_IUART_USART2_TX_DMA_STREAM,                 \
+                           STM32_USART2_TX_DMA_MSK)
+#error "invalid DMA stream associated to USART2 TX"
+#endif
+
+#if STM32_IUART_USE_USART3 && STM32_IUART_USART3_USE_RX_DMA &&               \
+    !STM32_DMA_IS_VALID_ID(STM32_IUART_USART3_RX_DMA_STREAM,                 \
+                           STM32_USART3_RX_DMA_MSK)
+#error "invalid DMA stream associated to USART3 RX"
+#endif
+
+#if STM32_IUART_USE_USART3 && STM32_IUART_USART3_USE_TX_DMA &&               \
+    !STM32_DMA_IS_VALID_ID(STM32_IUART_USART3_TX_DMA_STREAM,                 \
+                           STM32_USART3_TX_DMA_MSK)
+#error "invalid DMA stream associated to USART3 TX"
+#endif
+#endif /* STM32_ADVANCED_DMA */
+
+#if !defined(STM32_DMA_REQUIRED)
+#define STM32_DMA_REQUIRED
+#endif
+#endif /* STM32_IUART_USE_RX_DMA || STM32_IUART_USE_TX_DMA */
+
+#if IUART_USE_FRAMING && !defined(USART_CR2_RTOEN)
+#error "receiver timeout not supported by the selected device"
+#endif
+
+#if IUART_USE_RS485 && !defined(USART_CR3_DEM)
+#error "driver enable not supported by the selected device"
+#endif
+
+#if IUART_USE_MUTE && !defined(USART_RQR_MMRQ)
+#error "mute mode requests not supported by the selected device"
+#endif
+
+/**
+ * @brief   The core has a DWT cycle counter for ISR profiling.
+ */
+#if defined(DWT_CTRL_CYCCNTENA_Msk) || defined(__DOXYGEN__)
+#define STM32_IUART_HAS_CYCCNT      TRUE
+#else
+#define STM32_IUART_HAS_CYCCNT      FALSE
+#endif
+
+#if IUART_USE_TIMESTAMP && !defined(STM32_IUART_TIMESTAMP)
+#error "STM32_IUART_TIMESTAMP not defined and no cycle counter in the core"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -151,6 +534,66 @@ typedef uint32_t iuartflags_t;
  */
 typedef struct IUARTDriver IUARTDriver;
 
+/**
+ * @brief   IUART port descriptor.
+ * @details Constant description of a USART instance, the lifecycle
+ *          functions find everything port specific here.
+ */
+typedef struct {
+  /**
+   * @brief Driver object of the port.
+   */
+  IUARTDriver               *driver;
+  /**
+   * @brief Pointer to the USART registers block.
+   */
+  USART_TypeDef             *usart;
+  /**
+   * @brief Interrupt vector number.
+   */
+  uint32_t                  irq;
+  /**
+   * @brief Interrupt priority.
+   */
+  uint32_t                  prio;
+  /**
+   * @brief Kernel clock frequency in Hz.
+   */
+  uint32_t                  clock;
+  /**
+   * @brief RCC clock enable register.
+   */
+  volatile uint32_t         *rccenr;
+  /**
+   * @brief Clock enable bit in @p rccenr.
+   */
+  uint32_t                  rccmask;
+  /**
+   * @brief Low power UART, different baud rate formula and features.
+   */
+  bool                      lpuart;
+#if STM32_IUART_USE_RX_DMA || defined(__DOXYGEN__)
+  /**
+   * @brief Receive DMA stream or @p NULL.
+   */
+  const stm32_dma_stream_t  *dmarx;
+  /**
+   * @brief RX DMA mode bit mask.
+   */
+  uint32_t                  rxdmamode;
+#endif
+#if STM32_IUART_USE_TX_DMA || defined(__DOXYGEN__)
+  /**
+   * @brief Transmit DMA stream or @p NULL.
+   */
+  const stm32_dma_stream_t  *dmatx;
+  /**
+   * @brief TX DMA mode bit mask.
+   */
+  uint32_t                  txdmamode;
+#endif
+} stm32_iuart_port_t;
+
 /**
  * @brief   Generic IUART notification callback type.
  *
@@ -174,6 +617,22 @@ typedef void (*iuartccb_t)(IUARTDriver *iuartp, uint16_t c);
  */
 typedef void (*iuartecb_t)(IUARTDriver *iuartp, iuartflags_t e);
 
+/**
+ * @brief   Frame received IUART notification callback type.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] n         number of data frames received
+ */
+typedef void (*iuartfcb_t)(IUARTDriver *iuartp, size_t n);
+
+/**
+ * @brief   Flow control IUART notification callback type.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ * @param[in] stop      the sender should pause, else it may resume
+ */
+typedef void (*iuartflowcb_t)(IUARTDriver *iuartp, bool stop);
+
 /**
  * @brief   Driver configuration structure.
  * @note    It could be empty on some architectures.
@@ -202,6 +661,9 @@ typedef struct {
   /* End of the mandatory fields.*/
   /**
    * @brief Bit rate.
+   * @note  The divider is rounded to the nearest value, speeds above
+   *        the kernel clock divided by 16 select the oversampling by 8
+   *        that can also be forced with @p USART_CR1_OVER8 in @p cr1.
    */
   uint32_t                  speed;
   /**
@@ -216,12 +678,205 @@ typedef struct {
    * @brief Initialization value for the CR3 register.
    */
   uint32_t                  cr3;
+#if IUART_USE_RXRING || defined(__DOXYGEN__)
+  /**
+   * @brief Receive ring buffer or @p NULL to keep @p rxchar_cb delivery.
+   */
+  uint8_t                   *rxring;
+  /**
+   * @brief Receive ring size, must be a power of two.
+   */
+  size_t                    rxring_size;
+  /**
+   * @brief Number of buffered characters waking up the reader before the
+   *        line goes idle.
+   * @note  With receive DMA the reader is woken at half and full ring
+   *        instead.
+   */
+  size_t                    rxthreshold;
+#endif
+#if IUART_USE_TXQUEUE || defined(__DOXYGEN__)
+  /**
+   * @brief Transmit queue buffer or @p NULL.
+   */
+  uint8_t                   *txring;
+  /**
+   * @brief Transmit queue size, must be a power of two.
+   */
+  size_t                    txring_size;
+#endif
+#if IUART_USE_FRAMING || defined(__DOXYGEN__)
+  /**
+   * @brief Receiver timeout in bit durations, zero disables it.
+   */
+  uint32_t                  rto;
+  /**
+   * @brief Frame delimiter set with @p IUART_MATCH(), zero disables it.
+   */
+  uint16_t                  match;
+  /**
+   * @brief Block receive ended by timeout or delimiter callback.
+   */
+  iuartfcb_t                rxframe_cb;
+#endif
+#if IUART_USE_DEFERRED || defined(__DOXYGEN__)
+  /**
+   * @brief Deferred events queue or @p NULL to invoke the callbacks from
+   *        the ISR.
+   */
+  iuartevent_t              *evq;
+  /**
+   * @brief Events queue size, must be a power of two.
+   */
+  size_t                    evq_size;
+#endif
+#if IUART_USE_RS485 || defined(__DOXYGEN__)
+  /**
+   * @brief Drive the DE pin from the USART, its polarity is set by
+   *        @p USART_CR3_DEP in @p cr3.
+   */
+  bool                      rs485;
+  /**
+   * @brief DE assertion time before the start bit, in sample time units
+   *        (1/16 or 1/8 bit), up to 31.
+   */
+  uint8_t                   deat;
+  /**
+   * @brief DE deassertion time after the last stop bit, in sample time
+   *        units, up to 31.
+   */
+  uint8_t                   dedt;
+#endif
+#if IUART_USE_MODBUS || defined(__DOXYGEN__)
+  /**
+   * @brief Modbus RTU framing, the receiver timeout is derived from
+   *        @p speed and @p rto is ignored.
+   * @note  Block receives then end at the t3.5 interval, @p rxframe_cb
+   *        gets the frame length without the CRC and frames failing the
+   *        check are reported as @p IUART_CRC_ERROR, the block receive
+   *        restarting on the same buffer.
+   */
+  bool                      modbus;
+#endif
+#if IUART_USE_CRC || defined(__DOXYGEN__)
+  /**
+   * @brief CRC of the block transfers or @p NULL.
+   * @note  Needs 8 bit data frames.
+   */
+  const iuartcrc_t          *crc;
+  /**
+   * @brief Sends the CRC after the data of each block send, in the bit
+   *        order of the algorithm, before @p txend1_cb is invoked.
+   */
+  bool                      crcappend;
+#endif
+#if IUART_USE_BRIDGE || defined(__DOXYGEN__)
+  /**
+   * @brief Port forwarding the received characters through its transmit
+   *        queue, or @p NULL.
+   * @note  Both ports must have the same IRQ priority, a bidirectional
+   *        bridge has each configuration pointing to the other port.
+   */
+  IUARTDriver               *bridge;
+  /**
+   * @brief Destination queue level invoking @p flow_cb to stop the
+   *        sender, zero disables the flow control.
+   */
+  size_t                    bridge_hiwat;
+  /**
+   * @brief Destination queue level invoking @p flow_cb to resume the
+   *        sender.
+   */
+  size_t                    bridge_lowat;
+  /**
+   * @brief Bridge flow control callback.
+   */
+  iuartflowcb_t             flow_cb;
+#endif
+#if IUART_USE_MUTE || defined(__DOXYGEN__)
+  /**
+   * @brief Mute mode wakeup method, the receiver starts muted.
+   */
+  uint8_t                   mute;
+  /**
+   * @brief Node address for @p IUART_MUTE_ADDRESS, addresses above 15
+   *        use the 7 bit comparison.
+   * @note  The address mark is the MSB of the data frame, the matching
+   *        address frame is received as data.
+   */
+  uint8_t                   address;
+#endif
+#if IUART_USE_RXCHAIN || defined(__DOXYGEN__)
+  /**
+   * @brief Chained receive buffers descriptors or @p NULL.
+   * @note  With a chain the block receives are started by
+   *        @p iuartQueueReceive() only.
+   */
+  iuartrxdesc_t             *rxchain;
+  /**
+   * @brief Number of descriptors, must be a power of two.
+   */
+  size_t                    rxchain_size;
+#endif
+#if IUART_USE_TXPRIO || defined(__DOXYGEN__)
+  /**
+   * @brief Block send data frames between the points where an urgent
+   *        message can be inserted, zero for any data frame.
+   * @note  With transmit DMA the block is transferred in parts of this
+   *        size, zero sends it in one transfer and the urgent message
+   *        waits for its end.
+   */
+  size_t                    txprio_frames;
+  /**
+   * @brief Urgent message sent callback.
+   */
+  iuartcb_t                 txurgent_cb;
+#endif
+#if IUART_USE_FLOWCTL || defined(__DOXYGEN__)
+  /**
+   * @brief Flow control mode, CTS is handled by the USART in both modes.
+   */
+  uint8_t                   flow;
+  /**
+   * @brief Receive ring level stopping the sender, zero leaves RTS to the
+   *        USART alone.
+   * @note  With receive DMA the level is checked at each half ring and
+   *        idle line, the watermark must leave room for half a ring.
+   */
+  size_t                    rx_hiwat;
+  /**
+   * @brief Receive ring level releasing the sender.
+   */
+  size_t                    rx_lowat;
+  /**
+   * @brief Software RTS callback for @p IUART_FLOW_SWRTS, invoked from the
+   *        ISR and, in a lock zone, from @p iuartStart() and
+   *        @p iuartRead().
+   */
+  iuartflowcb_t             rts_cb;
+#endif
+#if IUART_USE_TIMESTAMP || defined(__DOXYGEN__)
+  /**
+   * @brief Latches the block receive timestamps of this port.
+   * @note  With receive DMA the first data frame of each block is then
+   *        taken by the RXNE interrupt, which hands the receiver over to
+   *        the DMA. That interrupt must be served within a frame time.
+   */
+  bool                      timestamp;
+#endif
 } IUARTConfig;
 
 /**
  * @brief   Structure representing an IUART driver.
  */
 struct IUARTDriver {
+#if IUART_USE_CHANNEL || defined(__DOXYGEN__)
+  /**
+   * @brief Virtual Methods Table.
+   */
+  const struct IUARTDriverVMT *vmt;
+  _base_channel_data
+#endif
   /**
    * @brief Driver state.
    */
@@ -238,14 +893,115 @@ struct IUARTDriver {
    * @brief Current configuration data.
    */
   const IUARTConfig          *config;
+#if IUART_USE_RXRING || defined(__DOXYGEN__)
+  /**
+   * @brief Receive ring write index, advanced by the ISR only.
+   */
+  volatile size_t           rxhead;
+  /**
+   * @brief Receive ring read index, advanced by the reader only.
+   */
+  volatile size_t           rxtail;
+  /**
+   * @brief Thread waiting for ring data.
+   */
+  thread_reference_t        rxthread;
+#endif
+#if IUART_USE_TXQUEUE || defined(__DOXYGEN__)
+  /**
+   * @brief Transmit queue write index, advanced by producers.
+   */
+  volatile size_t           txhead;
+  /**
+   * @brief Transmit queue read index, advanced by the ISR only.
+   */
+  volatile size_t           txtail;
+  /**
+   * @brief Thread waiting for queue space.
+   */
+  thread_reference_t        txthread;
+#endif
+#if IUART_USE_DEFERRED || defined(__DOXYGEN__)
+  /**
+   * @brief Events queue write index, advanced by the ISR only.
+   */
+  volatile size_t           evhead;
+  /**
+   * @brief Events queue read index, advanced by the dispatcher only.
+   */
+  volatile size_t           evtail;
+  /**
+   * @brief Events dropped on a full queue.
+   */
+  volatile bool             evlost;
+  /**
+   * @brief Thread waiting in @p iuartDispatch().
+   */
+  thread_reference_t        evthread;
+#endif
+#if IUART_USE_STATS || defined(__DOXYGEN__)
+  /**
+   * @brief Statistics, read with @p iuartGetStats().
+   */
+  iuartstats_t              stats;
+#endif
+#if IUART_USE_RXCHAIN || defined(__DOXYGEN__)
+  /**
+   * @brief Chain index of the next buffer queued by the application.
+   */
+  volatile size_t           chhead;
+  /**
+   * @brief Chain index of the buffer being filled, advanced by the ISR
+   *        only.
+   */
+  volatile size_t           chfill;
+  /**
+   * @brief Chain index of the next filled buffer to be fetched.
+   */
+  volatile size_t           chtail;
+  /**
+   * @brief Thread waiting for a filled buffer.
+   */
+  thread_reference_t        chthread;
+#endif
+#if STM32_IUART_USE_RX_DMA || defined(__DOXYGEN__)
+  /**
+   * @brief Receive DMA stream allocated, else interrupts are used.
+   */
+  bool                      rxdma;
+#endif
+#if STM32_IUART_USE_TX_DMA || defined(__DOXYGEN__)
+  /**
+   * @brief Transmit DMA stream allocated, else interrupts are used.
+   */
+  bool                      txdma;
+#if IUART_USE_TXQUEUE
+  /**
+   * @brief Queued bytes being transferred by DMA.
+   */
+  size_t                    txdmaq;
+#endif
+#endif
 #if defined(IUART_DRIVER_EXT_FIELDS)
   IUART_DRIVER_EXT_FIELDS
 #endif
   /* End of the mandatory fields.*/
+  /**
+   * @brief Port descriptor.
+   */
+  const stm32_iuart_port_t  *port;
   /**
    * @brief Pointer to the USART registers block.
    */
   USART_TypeDef             *usart;
+  /**
+   * @brief Service routine matching the data frame size.
+   */
+  iuartcb_t                 serve;
+  /**
+   * @brief Buffers are organized as uint16_t arrays.
+   */
+  bool                      wide;
 
   /**
    * @brief Default receive buffer while into @p IUART_RX_IDLE state.
@@ -256,12 +1012,80 @@ struct IUARTDriver {
   volatile uint8_t  *txBuf;          // Pointer to current transmit buffer
   volatile uint16_t rxCount;          // Number of bytes for 'active' receive
   volatile uint8_t  *rxBuffer;        // Pointer to receive buffer if block receive active
+  uint32_t          baud;             // Speed resulting from the divider
+#if IUART_USE_FRAMING
+  size_t            rxSize;           // Size of the block receive in progress
+#endif
+#if IUART_USE_MODBUS
+  uint16_t          mbcrc;            // Running CRC of the Modbus frame
+#endif
+#if IUART_USE_CRC
+  uint32_t          rxcrc;            // Running CRC of the block receive
+  uint32_t          txcrc;            // Running CRC of the block send
+  uint8_t           crcbuf[4];        // Appended CRC being sent
+  bool              crctrailer;       // Sending crcbuf
+#endif
+#if IUART_USE_BRIDGE
+  IUARTDriver       *bridgefrom;      // Port forwarding into the queue
+  bool              bridgestop;       // Stop notified to the sender
+#endif
+#if IUART_USE_TXPRIO
+  volatile uint16_t txuCount;         // Data frames left of the urgent message
+  volatile uint8_t  *txuBuf;          // Pointer to the urgent message
+  uint16_t          txseg;            // Block frames sent since the last boundary
+#if STM32_IUART_USE_TX_DMA
+  uint16_t          txdman;           // Block frames being transferred by DMA
+  bool              txdmau;           // Urgent message being transferred by DMA
+#endif
+#endif
+#if IUART_USE_FLOWCTL
+  bool              rxstopped;        // Sender stopped by the ring watermark
+#endif
+#if IUART_USE_TIMESTAMP
+  iuartstamp_t      rxstamp;          // Timestamps of the block receive
+  bool              rxfirst;          // Next data frame starts a block
+#endif
 };
 
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
 
+#if !(IUART_USE_RXRING && STM32_IUART_USE_RX_DMA) || defined(__DOXYGEN__)
+/**
+ * @brief   Brings the receive ring write index up to date.
+ * @details Only needed when the ring is filled by DMA, the interrupt path
+ *          updates the index for each character.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ *
+ * @notapi
+ */
+#define iuart_lld_rx_ring_sync(iuartp)
+#endif
+
+#if !IUART_USE_FLOWCTL || defined(__DOXYGEN__)
+/**
+ * @brief   Releases the sender once the receive ring is drained enough.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ *
+ * @notapi
+ */
+#define iuart_lld_rx_flow(iuartp)
+#endif
+
+#if IUART_USE_MUTE || defined(__DOXYGEN__)
+/**
+ * @brief   Puts the receiver in mute mode.
+ *
+ * @param[in] iuartp     pointer to the @p IUARTDriver object
+ *
+ * @notapi
+ */
+#define iuart_lld_mute(iuartp) ((iuartp)->usart->RQR = USART_RQR_MMRQ)
+#endif
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -278,6 +1102,30 @@ extern IUARTDriver IUARTD2;
 extern IUARTDriver IUARTD3;
 #endif
 
+#if STM32_IUART_USE_UART4 && !defined(__DOXYGEN__)
+extern IUARTDriver IUARTD4;
+#endif
+
+#if STM32_IUART_USE_UART5 && !defined(__DOXYGEN__)
+extern IUARTDriver IUARTD5;
+#endif
+
+#if STM32_IUART_USE_USART6 && !defined(__DOXYGEN__)
+extern IUARTDriver IUARTD6;
+#endif
+
+#if STM32_IUART_USE_UART7 && !defined(__DOXYGEN__)
+extern IUARTDriver IUARTD7;
+#endif
+
+#if STM32_IUART_USE_UART8 && !defined(__DOXYGEN__)
+extern IUARTDriver IUARTD8;
+#endif
+
+#if STM32_IUART_USE_LPUART1 && !defined(__DOXYGEN__)
+extern IUARTDriver LPIUARTD1;
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -286,8 +1134,21 @@ extern "C" {
   void iuart_lld_stop(IUARTDriver *iuartp);
   void iuart_lld_start_send(IUARTDriver *iuartp, size_t n, const void *txbuf);
   size_t iuart_lld_stop_send(IUARTDriver *iuartp);
+#if IUART_USE_TXQUEUE
+  void iuart_lld_start_queue(IUARTDriver *iuartp);
+#endif
+#if IUART_USE_TXPRIO
+  bool iuart_lld_start_urgent(IUARTDriver *iuartp, size_t n,
+                              const void *txbuf);
+#endif
   void iuart_lld_start_receive(IUARTDriver *iuartp, size_t n, void *rxbuf);
   size_t iuart_lld_stop_receive(IUARTDriver *iuartp);
+#if IUART_USE_RXRING && STM32_IUART_USE_RX_DMA
+  void iuart_lld_rx_ring_sync(IUARTDriver *iuartp);
+#endif
+#if IUART_USE_FLOWCTL
+  void iuart_lld_rx_flow(IUARTDriver *iuartp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,96 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/ch.h
+ * @brief   Host replacement of the kernel header, the OSAL subset used by
+ *          the drivers is in @p hal.h. Only the thread delays of the EEPROM
+ *          transfer engine, the static threads and the semaphores of the
+ *          waveform player are provided, see @p host_osal.c.
+ *
+ * @addtogroup IUART_HOST
+ * @{
+ */
+
+#ifndef _CH_H_
+#define _CH_H_
+
+#include "hal.h"
+
+#define MS2ST(msec)                 ((systime_t)(msec))
+
+typedef uint32_t tprio_t;
+typedef int32_t cnt_t;
+typedef uint64_t stkalign_t;
+typedef void (*tfunc_t)(void *p);
+
+#define NORMALPRIO                  128U
+
+/**
+ * @brief   Host stack added to every working area, the target sizes do not
+ *          fit the host ABI and libc.
+ */
+#define HOST_THD_STACK              65536U
+
+#define THD_WORKING_AREA_SIZE(n)                                            \
+  ((((n) + HOST_THD_STACK) + sizeof(stkalign_t) - 1U) &                     \
+   ~(sizeof(stkalign_t) - 1U))
+#define THD_WORKING_AREA(s, n)                                              \
+  stkalign_t s[THD_WORKING_AREA_SIZE(n) / sizeof(stkalign_t)]               \
+  __attribute__((aligned(16)))
+#define THD_FUNCTION(tname, arg)    void tname(void *arg)
+
+#define chRegSetThreadName(p)       ((void)(p))
+
+/**
+ * @brief   Counting semaphore.
+ */
+typedef struct {
+  cnt_t                     cnt;
+} semaphore_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  systime_t chVTGetSystemTimeX(void);
+  void chThdSleep(systime_t time);
+  void chThdYield(void);
+  thread_t *chThdCreateStatic(void *wsp, size_t size, tprio_t prio,
+                              tfunc_t pf, void *arg);
+  msg_t chThdWait(thread_t *tp);
+  void chSemObjectInit(semaphore_t *sp, cnt_t n);
+  void chSemReset(semaphore_t *sp, cnt_t n);
+  msg_t chSemWait(semaphore_t *sp);
+  void chSemSignal(semaphore_t *sp);
+  void chSemSignalI(semaphore_t *sp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CH_H_ */
+
+/** @} */
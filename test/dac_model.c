@@ -0,0 +1,155 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/dac_model.c
+ * @brief   Host model of the STM32 DAC channel 1 and its basic timer.
+ * @details The model joins the simulation clock of @p usart_model.c, one
+ *          bit time is one timer clock.
+ *
+ * @addtogroup DAC_HOST
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "dac_model.h"
+
+/*===========================================================================*/
+/* Model local definitions.                                                  */
+/*===========================================================================*/
+
+#define TRIGGER_MASK            (DAC_CR_EN1 | DAC_CR_TEN1 | DAC_CR_TSEL1)
+
+/* Channel enabled with the TIM6 trigger.*/
+#define TRIGGER_TIM6            (DAC_CR_EN1 | DAC_CR_TEN1)
+
+/*===========================================================================*/
+/* Model exported variables.                                                 */
+/*===========================================================================*/
+
+DAC_TypeDef host_dac;
+stm32_tim_t host_tim6, host_tim7;
+
+/*===========================================================================*/
+/* Model local functions.                                                    */
+/*===========================================================================*/
+
+/**
+ * @brief   Conversion on the timer trigger.
+ */
+static void trigger(dac_model_t *mp) {
+  DAC_TypeDef *dac = mp->dac;
+
+  if ((dac->CR & TRIGGER_MASK) != TRIGGER_TIM6)
+    return;
+  dac->DOR1 = dac->DHR12R1 & 0xFFFU;
+  mp->log[mp->loghead++ & (DMODEL_LOG_SIZE - 1)] = (uint16_t)dac->DOR1;
+  mp->conversions++;
+  if (dac->CR & DAC_CR_DMAEN1)
+    mp->dmareq = true;
+}
+
+static void clock_dac(sim_device_t *dp) {
+  dac_model_t *mp = (dac_model_t *)dp;
+  stm32_tim_t *tim = mp->tim;
+
+  if (tim->EGR & TIM_EGR_UG) {
+    tim->EGR = 0;
+    tim->CNT = 0;
+    mp->prescaler = 0;
+  }
+  if (!(RCC->APB1ENR & mp->clken) || !(tim->CR1 & TIM_CR1_CEN))
+    return;
+  if (mp->prescaler++ < tim->PSC)
+    return;
+  mp->prescaler = 0;
+  if (tim->CNT++ < tim->ARR)
+    return;
+  tim->CNT = 0;
+  tim->SR |= TIM_SR_UIF;
+  if ((tim->CR2 & TIM_CR2_MMS) == TIM_CR2_MMS_1)
+    trigger(mp);
+}
+
+static bool dma_request(sim_device_t *dp, DMA_Stream_TypeDef *st) {
+  dac_model_t *mp = (dac_model_t *)dp;
+
+  if ((st->PAR != &mp->dac->DHR12R1) || !mp->dmareq)
+    return false;
+  mp->dmareq = false;
+  return true;
+}
+
+/*===========================================================================*/
+/* Model exported functions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a DAC model in its reset state and adds it to the
+ *          simulation.
+ *
+ * @param[out] mp       pointer to the model
+ * @param[in] dac       register block
+ * @param[in] tim       trigger timer, TIM6
+ * @param[in] clken     timer clock enable in @p APB1ENR
+ */
+void dacModelInit(dac_model_t *mp, DAC_TypeDef *dac, stm32_tim_t *tim,
+                  uint32_t clken) {
+
+  memset(dac, 0, sizeof *dac);
+  memset(tim, 0, sizeof *tim);
+  mp->dev.clock       = clock_dac;
+  mp->dev.dma_request = dma_request;
+  mp->dac         = dac;
+  mp->tim         = tim;
+  mp->clken       = clken;
+  mp->prescaler   = 0;
+  mp->dmareq      = false;
+  mp->loghead     = mp->logtail = 0;
+  mp->conversions = 0;
+  simAddDevice(&mp->dev);
+}
+
+/**
+ * @brief   Fetches the samples converted since the last call.
+ *
+ * @param[in] mp        pointer to the model
+ * @param[out] bp       samples buffer
+ * @param[in] n         buffer size
+ * @return              The number of samples fetched.
+ */
+size_t dacModelGetOutput(dac_model_t *mp, uint16_t *bp, size_t n) {
+  size_t i;
+
+  for (i = 0; (i < n) && (mp->logtail != mp->loghead); i++)
+    bp[i] = mp->log[mp->logtail++ & (DMODEL_LOG_SIZE - 1)];
+  return i;
+}
+
+/** @} */
@@ -0,0 +1,112 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/dac_model.h
+ * @brief   Host model of the STM32 DAC channel 1 and its basic timer.
+ *
+ * @addtogroup DAC_HOST
+ * @{
+ */
+
+#ifndef _DAC_MODEL_H_
+#define _DAC_MODEL_H_
+
+#include "stm32_tim.h"
+#include "usart_model.h"
+
+/*===========================================================================*/
+/* Model constants.                                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Converted samples log size, must be a power of two.
+ */
+#define DMODEL_LOG_SIZE             4096U
+
+/*===========================================================================*/
+/* Model data structures and types.                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Structure representing a simulated DAC channel.
+ * @details The timer counts one clock per bit time once enabled in the RCC
+ *          and by @p CEN, @p UG restarts the counter and the prescaler.
+ *          Each update event with @p MMS set to update triggers the
+ *          channel, when enabled with the timer trigger:
+ *          - The content of @p DHR12R1 is moved to @p DOR1 and logged,
+ *            the other holding registers are not modelled.
+ *          - With @p DMAEN1 a DMA request is raised, served by the stream
+ *            addressing @p DHR12R1. As on the device the DMA runs one
+ *            sample ahead of the output.
+ *          .
+ */
+typedef struct {
+  /**
+   * @brief Simulation hooks, must be the first member.
+   */
+  sim_device_t              dev;
+  /**
+   * @brief Simulated register block.
+   */
+  DAC_TypeDef               *dac;
+  /**
+   * @brief Trigger timer.
+   */
+  stm32_tim_t               *tim;
+  /**
+   * @brief Timer clock enable in @p APB1ENR.
+   */
+  uint32_t                  clken;
+  /* Timer and channel state.*/
+  uint32_t                  prescaler;
+  bool                      dmareq;
+  /* Converted samples.*/
+  uint16_t                  log[DMODEL_LOG_SIZE];
+  size_t                    loghead;
+  size_t                    logtail;
+  /* Counters.*/
+  unsigned long             conversions;
+} dac_model_t;
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void dacModelInit(dac_model_t *mp, DAC_TypeDef *dac, stm32_tim_t *tim,
+                    uint32_t clken);
+  size_t dacModelGetOutput(dac_model_t *mp, uint16_t *bp, size_t n);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DAC_MODEL_H_ */
+
+/** @} */
@@ -0,0 +1,314 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/dac_test.c
+ * @brief   DAC driver and EEPROM waveform playback tests on the DAC and
+ *          25XX models.
+ * @details The exit status is the number of failures.
+ *
+ * @addtogroup DAC_HOST
+ * @{
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "dac_driver.h"
+#include "eeprom_wave.h"
+#include "eeprom_model.h"
+#include "dac_model.h"
+
+/*===========================================================================*/
+/* Local definitions.                                                        */
+/*===========================================================================*/
+
+#define CHECK(c) do {                                                       \
+  if (!(c)) {                                                               \
+    printf("  %s:%d: %s\n", __FILE__, __LINE__, #c);                        \
+    return false;                                                           \
+  }                                                                         \
+} while (0)
+
+#define DEVICE_SIZE             4096U
+#define DEVICE_PAGE             32U
+#define DEVICE_CYCLE            30UL
+
+/* Sample period of 104 bit times, prescaler 4 and reload 25.*/
+#define FREQUENCY               10000U
+#define PERIOD                  104UL
+
+#define DEPTH                   8U
+#define IDLE                    0x800U
+
+/*===========================================================================*/
+/* Local variables and types.                                                */
+/*===========================================================================*/
+
+static dac_model_t md;
+
+static uint8_t mem[DEVICE_SIZE];
+static eeprom_model_t m25;
+static const SPIConfig spicfg = {0};
+static SPIDriver SPID1 = {NULL, &m25};
+static SPIEepromFileConfig cfg25 = {
+  .barrier_low = 0,
+  .barrier_hi  = DEVICE_SIZE,
+  .size        = DEVICE_SIZE,
+  .pagesize    = DEVICE_PAGE,
+  .write_time  = 5,
+  .spip        = &SPID1,
+  .spicfg      = &spicfg,
+};
+static EepromFileStream file;
+
+static const DACConfig daccfg = {DAC_DHRM_12BIT_RIGHT, 0};
+
+static THD_WORKING_AREA(wavewa, 256);
+static dacsample_t wavebuf[DEPTH];
+static EepromWave wave;
+static unsigned ended;
+
+static dacerror_t dacerr;
+static unsigned dacerrors;
+
+/*===========================================================================*/
+/* Callbacks.                                                                */
+/*===========================================================================*/
+
+static void wave_end(EepromWave *wavp) {
+
+  (void)wavp;
+  ended++;
+}
+
+static void dac_error(DACDriver *dacp, dacerror_t err) {
+
+  (void)dacp;
+  dacerr = err;
+  dacerrors++;
+}
+
+/*===========================================================================*/
+/* Helpers.                                                                  */
+/*===========================================================================*/
+
+static dacsample_t sample(size_t i) {
+
+  return (dacsample_t)(0x100 + i * 0x10);
+}
+
+/* DAC ready, erased device and no player callbacks seen.*/
+static void setup(void) {
+
+  dacModelInit(&md, DAC, STM32_TIM6, RCC_APB1ENR_TIM6EN);
+  eepromModelInit(&m25, mem, DEVICE_SIZE, DEVICE_PAGE, DEVICE_CYCLE);
+  dacStart(&DACD1, &daccfg);
+  EepromWaveObjectInit(&wave);
+  ended     = 0;
+  dacerrors = 0;
+}
+
+/* Stores n samples in a file of their size, rewound.*/
+static EepromFileStream *store(size_t n) {
+  dacsample_t tx[64];
+  EepromFileStream *efs;
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    tx[i] = sample(i);
+  cfg25.barrier_hi = n * sizeof(dacsample_t);
+  file.vmt = NULL;
+  efs = EepromFileOpen(&file, (EepromFileConfig *)&cfg25,
+                       EepromFindDevice("25XX"));
+  if (EepromFileWrite(efs, (uint8_t *)tx, n * sizeof tx[0]) !=
+      n * sizeof tx[0])
+    return NULL;
+  eepfs_lseek(efs, 0);
+  return efs;
+}
+
+static void play(EepromFileStream *efs, bool loop) {
+  static EepromWaveConfig cfg = {
+    FREQUENCY, 1, wavebuf, DEPTH, false, IDLE,
+    wavewa, sizeof wavewa, NORMALPRIO + 1, wave_end
+  };
+
+  cfg.loop = loop;
+  EepromWaveStart(&wave, &DACD1, efs, &cfg);
+}
+
+/* Waits for the end of playback, in samples.*/
+static bool wait_end(size_t samples) {
+
+  while ((ended == 0) && (samples-- > 0))
+    chThdSleep(PERIOD / HOST_BITS_PER_TICK);
+  return ended != 0;
+}
+
+/*===========================================================================*/
+/* Tests.                                                                    */
+/*===========================================================================*/
+
+/* A DMA error is reported to the error callback, the error hook halts
+   otherwise.*/
+static bool test_error(void) {
+  static const DACConversionGroup grp = {FREQUENCY, 1, NULL, dac_error, true};
+  static const dacsample_t buf[4] = {1, 2, 3, 4};
+
+  dacStartConversion(&DACD1, &grp, buf, 4);
+  chThdSleep(10 * PERIOD / HOST_BITS_PER_TICK);
+  CHECK(md.conversions >= 9);
+  simDmaFail(DACD1.dma);
+  chThdSleep(1);
+  CHECK((dacerrors == 1) && (dacerr & STM32_DMA_ISR_TEIF));
+  CHECK((DACD1.state == DAC_READY) && (DACD1.grpp == NULL));
+
+  /* The stream has been released, the next conversion gets it again.*/
+  dacStartConversion(&DACD1, &grp, buf, 4);
+  chThdSleep(5 * PERIOD / HOST_BITS_PER_TICK);
+  dacStopConversion(&DACD1);
+  CHECK(dacerrors == 1);
+  return true;
+}
+
+/* The tail of the file is padded with the idle value, the player stops
+   after the last sample has been output and calls end_cb.*/
+static bool test_pad(void) {
+  /* Last half partly filled, last half full.*/
+  static const size_t lengths[] = {10, DEPTH};
+  uint16_t out[64];
+  size_t i, j, n;
+
+  for (i = 0; i < sizeof lengths / sizeof lengths[0]; i++) {
+    EepromFileStream *efs = store(lengths[i]);
+    unsigned long conversions;
+
+    CHECK(efs != NULL);
+    ended = 0;
+    (void)dacModelGetOutput(&md, out, sizeof out / sizeof out[0]);
+    play(efs, false);
+    CHECK(wait_end(4 * DEPTH));
+    CHECK(ended == 1);
+    CHECK((DACD1.state == DAC_READY) && (md.dac->DOR1 == IDLE));
+
+    /* The first conversion outputs the holding register before the
+       first DMA transfer.*/
+    n = dacModelGetOutput(&md, out, sizeof out / sizeof out[0]);
+    CHECK(n > lengths[i] + 1);
+    for (j = 0; j < lengths[i]; j++)
+      CHECK(out[j + 1] == sample(j));
+    for (j = lengths[i] + 1; j < n; j++)
+      CHECK(out[j] == IDLE);
+
+    conversions = md.conversions;
+    chThdSleep(DEPTH * PERIOD / HOST_BITS_PER_TICK);
+    CHECK(md.conversions == conversions);
+    EepromWaveStop(&wave);
+    CHECK((ended == 1) && (wave.thread == NULL) && (wave.underruns == 0));
+  }
+  return true;
+}
+
+/* Looping playback repeats the file until stopped.*/
+static bool test_loop(void) {
+  EepromFileStream *efs = store(6);
+  uint16_t out[64];
+  unsigned long conversions;
+  size_t i, n;
+
+  CHECK(efs != NULL);
+  play(efs, true);
+  chThdSleep(40 * PERIOD / HOST_BITS_PER_TICK);
+  CHECK(ended == 0);
+  EepromWaveStop(&wave);
+  CHECK((ended == 1) && (wave.thread == NULL) && (wave.underruns == 0));
+  CHECK(DACD1.state == DAC_READY);
+
+  n = dacModelGetOutput(&md, out, sizeof out / sizeof out[0]);
+  CHECK(n >= 39);
+  for (i = 1; i < n; i++)
+    CHECK(out[i] == sample((i - 1) % 6));
+  conversions = md.conversions;
+  chThdSleep(DEPTH * PERIOD / HOST_BITS_PER_TICK);
+  CHECK(md.conversions == conversions);
+  return true;
+}
+
+/* Halves played again before the worker refilled them are counted.*/
+static bool test_underrun(void) {
+  EepromFileStream *efs = store(6);
+
+  CHECK(efs != NULL);
+  play(efs, true);
+  chThdSleep(DEPTH * PERIOD / HOST_BITS_PER_TICK);
+  CHECK(wave.underruns == 0);
+
+  /* The raw clock does not schedule the worker, as if a thread above it
+     kept the CPU for a whole buffer.*/
+  simRun(2 * DEPTH * PERIOD);
+  CHECK(wave.underruns >= 2);
+  EepromWaveStop(&wave);
+  CHECK((ended == 1) && (DACD1.state == DAC_READY));
+  return true;
+}
+
+static const struct {
+  const char    *name;
+  bool          (*fn)(void);
+} tests[] = {
+  {"error",          test_error},
+  {"pad",            test_pad},
+  {"loop",           test_loop},
+  {"underrun",       test_underrun},
+};
+
+/*===========================================================================*/
+/* Entry point.                                                              */
+/*===========================================================================*/
+
+int main(void) {
+  int failures = 0;
+  size_t i;
+
+  dacInit();
+  for (i = 0; i < sizeof tests / sizeof tests[0]; i++) {
+    bool ok;
+
+    setup();
+    ok = tests[i].fn();
+    printf("%s %s\n", ok ? "PASS" : "FAIL", tests[i].name);
+    if (!ok)
+      failures++;
+  }
+  printf("%d of %zu tests failed\n", failures, sizeof tests / sizeof tests[0]);
+  return failures;
+}
+
+/** @} */
@@ -0,0 +1,61 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/drivers_conf.h
+ * @brief   Drivers configuration of the host test build.
+ * @details The optional IUART features are selected by the Makefile.
+ *
+ * @addtogroup IUART_HOST
+ * @{
+ */
+
+#ifndef _DRIVERS_CONF_H_
+#define _DRIVERS_CONF_H_
+
+#define DRIVER_USE_IUART                    TRUE
+
+/*
+ * IUART driver system settings.
+ */
+#define STM32_IUART_USE_USART1              TRUE
+#define STM32_IUART_USE_USART2              TRUE
+#define STM32_IUART_USART1_IRQ_PRIORITY     3
+#define STM32_IUART_USART2_IRQ_PRIORITY     3
+
+/* Receive timestamps in bit times of the virtual line clock.*/
+#define STM32_IUART_TIMESTAMP()             ((uint32_t)simNow())
+
+/*
+ * DAC driver system settings, DRIVER_USE_DAC is selected by the Makefile.
+ */
+#define STM32_DAC_USE_CHN1                  TRUE
+#define DAC_USE_MUTUAL_EXCLUSION            FALSE
+
+#endif /* _DRIVERS_CONF_H_ */
+
+/** @} */
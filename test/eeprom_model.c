@@ -0,0 +1,228 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+/**
+ * @file    test/eeprom_model.c
+ * @brief   Host model of the 24XX and 25XX EEPROM devices.
+ * @details The I2C and SPI drivers of the host HAL forward the transfers
+ *          to the device model attached to the driver. Write cycles run on
+ *          the simulation clock of @p usart_model.c.
+ *
+ * @addtogroup EEPROM_HOST
+ * @{
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "eeprom_model.h"
+#include "usart_model.h"
+
+/*===========================================================================*/
+/* Model local definitions.                                                  */
+/*===========================================================================*/
+
+/* 25XX commands and status.*/
+#define CMD_WRITE               0x02
+#define CMD_READ                0x03
+#define CMD_WRDI                0x04
+#define CMD_RDSR                0x05
+#define CMD_WREN                0x06
+#define STAT_WEL                0x02
+#define STAT_WIP                0x01
+
+/*===========================================================================*/
+/* Model local functions.                                                    */
+/*===========================================================================*/
+
+static bool busy(eeprom_model_t *mp) {
+
+  return mp->failed || (simNow() < mp->busyend);
+}
+
+/**
+ * @brief   Programs a page, wrapping around at the page end.
+ */
+static bool page_write(eeprom_model_t *mp, uint32_t addr,
+                       const uint8_t *bp, size_t n) {
+  uint32_t start = addr - (addr % mp->pagesize);
+  size_t i;
+
+  if (mp->failafter == 0) {
+    mp->failed = true;
+    return false;
+  }
+  if (mp->failafter > 0)
+    mp->failafter--;
+  if ((addr % mp->pagesize) + n > mp->pagesize)
+    mp->wraps++;
+  for (i = 0; i < n; i++)
+    mp->mem[start + (addr + i - start) % mp->pagesize] = bp[i];
+  mp->writes++;
+  mp->busyend = simNow() + mp->cycle;
+  return true;
+}
+
+/**
+ * @brief   Address bytes of the 25XX commands, as the density requires.
+ */
+static unsigned addr_bytes(eeprom_model_t *mp) {
+
+  return (mp->size > 0xFFFFU) ? 3 : (mp->size > 0xFFU) ? 2 : 1;
+}
+
+/*===========================================================================*/
+/* Model exported functions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a model, the memory array is erased.
+ *
+ * @param[out] mp       pointer to the model
+ * @param[in] mem       memory array
+ * @param[in] size      size of the memory array
+ * @param[in] pagesize  page size
+ * @param[in] cycle     write cycle in bit times
+ */
+void eepromModelInit(eeprom_model_t *mp, uint8_t *mem, uint32_t size,
+                     uint16_t pagesize, unsigned long cycle) {
+
+  memset(mp, 0, sizeof *mp);
+  memset(mem, 0xFF, size);
+  mp->mem       = mem;
+  mp->size      = size;
+  mp->pagesize  = pagesize;
+  mp->cycle     = cycle;
+  mp->failafter = -1;
+}
+
+/**
+ * @brief   24XX transfer, a write of the address then a read or the data.
+ */
+msg_t i2cMasterTransmitTimeout(I2CDriver *i2cp, i2caddr_t addr,
+                               const uint8_t *txbuf, size_t txbytes,
+                               uint8_t *rxbuf, size_t rxbytes,
+                               systime_t timeout) {
+  eeprom_model_t *mp = i2cp->dev;
+  uint32_t a;
+  size_t i;
+
+  (void)addr;
+  (void)timeout;
+  if (busy(mp)) {
+    mp->violations += !mp->failed;
+    return MSG_RESET;
+  }
+  if ((txbytes < 2) || (mp->noshort && (rxbytes == 1))) {
+    mp->violations++;
+    return MSG_RESET;
+  }
+
+  a = (((uint32_t)txbuf[0] << 8) | txbuf[1]) % mp->size;
+  if (rxbytes > 0) {
+    for (i = 0; i < rxbytes; i++)
+      rxbuf[i] = mp->mem[(a + i) % mp->size];
+    return MSG_OK;
+  }
+  if ((txbytes > 2) && !page_write(mp, a, &txbuf[2], txbytes - 2))
+    return MSG_RESET;
+  return MSG_OK;
+}
+
+void spiStart(SPIDriver *spip, const SPIConfig *config) {
+
+  spip->config = config;
+}
+
+void spiSelect(SPIDriver *spip) {
+  eeprom_model_t *mp = spip->dev;
+
+  mp->nbytes = 0;
+  mp->npage  = 0;
+  mp->addr   = 0;
+}
+
+/**
+ * @brief   25XX command, address and data bytes.
+ */
+void spiSend(SPIDriver *spip, size_t n, const void *txbuf) {
+  eeprom_model_t *mp = spip->dev;
+  const uint8_t *bp = txbuf;
+
+  while (n-- > 0) {
+    uint8_t b = *bp++;
+
+    if (mp->nbytes++ == 0) {
+      mp->cmd = b;
+      if ((b != CMD_RDSR) && busy(mp))
+        mp->violations += !mp->failed;
+      else if (b == CMD_WREN)
+        mp->wel = true;
+      else if (b == CMD_WRDI)
+        mp->wel = false;
+    }
+    else if (mp->nbytes <= 1 + addr_bytes(mp))
+      mp->addr = (mp->addr << 8) | b;
+    else if ((mp->cmd == CMD_WRITE) && (mp->npage < mp->pagesize))
+      mp->page[mp->npage++] = b;
+    else
+      mp->violations++;
+  }
+}
+
+void spiReceive(SPIDriver *spip, size_t n, void *rxbuf) {
+  eeprom_model_t *mp = spip->dev;
+  uint8_t *bp = rxbuf;
+
+  while (n-- > 0) {
+    if (mp->cmd == CMD_RDSR)
+      *bp++ = (busy(mp) ? STAT_WIP : 0) | (mp->wel ? STAT_WEL : 0);
+    else if ((mp->cmd == CMD_READ) && !busy(mp))
+      *bp++ = mp->mem[mp->addr++ % mp->size];
+    else {
+      mp->violations++;
+      *bp++ = 0xFF;
+    }
+  }
+}
+
+/**
+ * @brief   End of the 25XX command, a page write starts here.
+ */
+void spiUnselect(SPIDriver *spip) {
+  eeprom_model_t *mp = spip->dev;
+
+  if ((mp->cmd != CMD_WRITE) || (mp->npage == 0) || busy(mp))
+    return;
+  if (!mp->wel) {
+    mp->violations++;
+    return;
+  }
+  mp->wel = false;
+  (void)page_write(mp, mp->addr % mp->size, mp->page, mp->npage);
+}
+
+/** @} */
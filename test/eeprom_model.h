@@ -0,0 +1,122 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+/**
+ * @file    test/eeprom_model.h
+ * @brief   Host model of the 24XX and 25XX EEPROM devices.
+ *
+ * @addtogroup EEPROM_HOST
+ * @{
+ */
+
+#ifndef _EEPROM_MODEL_H_
+#define _EEPROM_MODEL_H_
+
+/*===========================================================================*/
+/* Model constants.                                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Largest page size of the modelled devices.
+ */
+#define EMODEL_MAX_PAGE             64U
+
+/*===========================================================================*/
+/* Model data structures and types.                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Structure representing a simulated EEPROM device.
+ * @details The same model answers the 24XX protocol on I2C and the 25XX
+ *          protocol on SPI. As the real devices:
+ *          - A page write that runs past the page end wraps around to the
+ *            start of the same page.
+ *          - The write cycle lasts @p cycle bit times of the simulation
+ *            clock, the device does not answer meanwhile, the 25XX status
+ *            register shows WIP.
+ *          - A 25XX page write needs a previous WREN.
+ *          .
+ *          Every access the engine should never make is counted in
+ *          @p violations.
+ */
+typedef struct {
+  /**
+   * @brief Memory array.
+   */
+  uint8_t                   *mem;
+  /**
+   * @brief Size of the memory array.
+   */
+  uint32_t                  size;
+  /**
+   * @brief Page size.
+   */
+  uint16_t                  pagesize;
+  /**
+   * @brief Write cycle in bit times.
+   */
+  unsigned long             cycle;
+  /**
+   * @brief Single byte reads refused, as by the STM32F1 I2C cell.
+   */
+  bool                      noshort;
+  /**
+   * @brief Page writes before the device fails, negative for never.
+   * @details A failed 24XX does not acknowledge, a failed 25XX stays busy.
+   */
+  long                      failafter;
+  /* Device state.*/
+  bool                      failed;
+  unsigned long             busyend;
+  bool                      wel;
+  /* SPI transaction state.*/
+  uint8_t                   cmd;
+  unsigned                  nbytes;
+  uint32_t                  addr;
+  uint8_t                   page[EMODEL_MAX_PAGE];
+  unsigned                  npage;
+  /* Counters.*/
+  unsigned long             writes;
+  unsigned long             wraps;
+  unsigned long             violations;
+} eeprom_model_t;
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void eepromModelInit(eeprom_model_t *mp, uint8_t *mem, uint32_t size,
+                       uint16_t pagesize, unsigned long cycle);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EEPROM_MODEL_H_ */
+
+/** @} */
@@ -0,0 +1,433 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+/**
+ * @file    test/eeprom_test.c
+ * @brief   EEPROM file tests on the 24XX and 25XX device models.
+ * @details The enabled devices are selected by the Makefile, every test
+ *          runs on each of them. The exit status is the number of
+ *          failures.
+ *
+ * @addtogroup EEPROM_HOST
+ * @{
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "eeprom_driver.h"
+#include "eeprom_lz.h"
+#include "eeprom_counter.h"
+#include "eeprom_model.h"
+
+/*===========================================================================*/
+/* Local definitions.                                                        */
+/*===========================================================================*/
+
+#define CHECK(c) do {                                                       \
+  if (!(c)) {                                                               \
+    printf("  %s:%d: %s\n", __FILE__, __LINE__, #c);                        \
+    return false;                                                           \
+  }                                                                         \
+} while (0)
+
+#define DEVICE_SIZE             4096U
+#define DEVICE_PAGE             32U
+
+/* Write cycle of the models in bit times, below the configured one.*/
+#define DEVICE_CYCLE            30UL
+#define WRITE_TIME              5U
+
+/*===========================================================================*/
+/* Local variables and types.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Device under test.
+ */
+typedef struct {
+  const char                *name;
+  eeprom_model_t            *model;
+  uint8_t                   *mem;
+  /* Common part of the device specific file configuration.*/
+  EepromFileConfig          *cfg;
+} dut_t;
+
+static EepromFileStream file;
+
+#if EEPROM_DRV_USE_24XX
+static uint8_t mem24[DEVICE_SIZE];
+static eeprom_model_t m24;
+static uint8_t wbuf24[EMODEL_MAX_PAGE + 2];
+static const I2CConfig i2ccfg = {400000};
+static I2CDriver I2CD1 = {&i2ccfg, &m24};
+static I2CEepromFileConfig cfg24 = {
+  .size       = DEVICE_SIZE,
+  .write_time = WRITE_TIME,
+  .i2cp       = &I2CD1,
+  .addr       = 0x50,
+  .write_buf  = wbuf24,
+};
+#endif
+
+#if EEPROM_DRV_USE_25XX
+static uint8_t mem25[DEVICE_SIZE];
+static eeprom_model_t m25;
+static const SPIConfig spicfg = {0};
+static SPIDriver SPID1 = {NULL, &m25};
+static SPIEepromFileConfig cfg25 = {
+  .size       = DEVICE_SIZE,
+  .write_time = WRITE_TIME,
+  .spip       = &SPID1,
+  .spicfg     = &spicfg,
+};
+#endif
+
+static const dut_t duts[] = {
+#if EEPROM_DRV_USE_24XX
+  {"24XX", &m24, mem24, (EepromFileConfig *)&cfg24},
+#endif
+#if EEPROM_DRV_USE_25XX
+  {"25XX", &m25, mem25, (EepromFileConfig *)&cfg25},
+#endif
+};
+
+#define NDUTS                   (sizeof duts / sizeof duts[0])
+
+/*===========================================================================*/
+/* Helpers.                                                                  */
+/*===========================================================================*/
+
+static void fill(uint8_t *bp, size_t n, unsigned seed) {
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    bp[i] = (uint8_t)(seed + i * 7);
+}
+
+/* Erased devices with the default geometry.*/
+static void setup(void) {
+  size_t i;
+
+  for (i = 0; i < NDUTS; i++)
+    eepromModelInit(duts[i].model, duts[i].mem, DEVICE_SIZE, DEVICE_PAGE,
+                    DEVICE_CYCLE);
+}
+
+/* Opens a file on the device, the page size is the device one.*/
+static EepromFileStream *open_file(const dut_t *dp, uint32_t low,
+                                   uint32_t hi) {
+
+  dp->cfg->barrier_low = low;
+  dp->cfg->barrier_hi  = hi;
+  dp->cfg->pagesize    = dp->model->pagesize;
+  file.vmt = NULL;
+  return EepromFileOpen(&file, dp->cfg, EepromFindDevice(dp->name));
+}
+
+/*===========================================================================*/
+/* Tests.                                                                    */
+/*===========================================================================*/
+
+/* Unaligned transfers are split on the page boundaries of the device.*/
+static bool test_split(void) {
+  /* Page sizes and page writes for 100 bytes from device address 8.*/
+  static const uint16_t pages[] = {DEVICE_PAGE, 24};
+  static const unsigned writes[] = {4, 5};
+  uint8_t tx[100], rx[100];
+  EepromFileStream *efs;
+  size_t i, p;
+
+  fill(tx, sizeof tx, 3);
+  for (i = 0; i < NDUTS; i++) {
+    const dut_t *dp = &duts[i];
+
+    for (p = 0; p < sizeof pages / sizeof pages[0]; p++) {
+      eepromModelInit(dp->model, dp->mem, DEVICE_SIZE, pages[p],
+                      DEVICE_CYCLE);
+      efs = open_file(dp, 5, 305);
+      eepfs_lseek(efs, 3);
+      CHECK(EepromFileWrite(efs, tx, sizeof tx) == sizeof tx);
+      CHECK(eepfs_getposition(efs) == 103);
+      CHECK(memcmp(&dp->mem[8], tx, sizeof tx) == 0);
+      CHECK((dp->mem[7] == 0xFF) && (dp->mem[108] == 0xFF));
+      CHECK(dp->model->writes == writes[p]);
+      eepfs_lseek(efs, 3);
+      CHECK(EepromFileRead(efs, rx, sizeof rx) == sizeof rx);
+      CHECK(memcmp(rx, tx, sizeof tx) == 0);
+
+      /* Clamped at the upper barrier.*/
+      eepfs_lseek(efs, 290);
+      CHECK(EepromFileWrite(efs, tx, 20) == 10);
+      CHECK(EepromFileRead(efs, rx, 1) == 0);
+      CHECK(eepfs_geterror(efs) == FILE_OK);
+      CHECK((dp->model->wraps == 0) && (dp->model->violations == 0));
+    }
+  }
+  return true;
+}
+
+/* A failed page stops the transfer, the position counts written bytes.*/
+static bool test_fail(void) {
+  uint8_t tx[100];
+  EepromFileStream *efs;
+  size_t i;
+
+  fill(tx, sizeof tx, 5);
+  for (i = 0; i < NDUTS; i++) {
+    const dut_t *dp = &duts[i];
+
+    efs = open_file(dp, 0, 256);
+    dp->model->failafter = 2;
+    CHECK(EepromFileWrite(efs, tx, sizeof tx) == 2 * DEVICE_PAGE);
+    CHECK(eepfs_getposition(efs) == 2 * DEVICE_PAGE);
+    CHECK(efs->errors == FILE_ERROR);
+    CHECK(dp->model->violations == 0);
+  }
+  return true;
+}
+
+static unsigned spied;
+
+static size_t spy_write(void *ip, const uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  (void)n;
+  spied++;
+  return 0;
+}
+
+static size_t spy_read(void *ip, uint8_t *bp, size_t n) {
+
+  (void)ip;
+  (void)bp;
+  (void)n;
+  spied++;
+  return 0;
+}
+
+/* Files are served by the device found by name, or by the only device
+   without going through the methods table with the static binding.*/
+static bool test_binding(void) {
+  static const struct EepromFileStreamVMT spyvmt = {
+    spy_write, spy_read, eepfs_put, eepfs_get
+  };
+  uint8_t tx[8], rx[8];
+  EepromFileStream *efs;
+  size_t i;
+
+  fill(tx, sizeof tx, 7);
+  for (i = 0; i < NDUTS; i++) {
+    const dut_t *dp = &duts[i];
+
+    efs = open_file(dp, 64, 128);
+    CHECK(efs->vmt == EepromFindDevice(dp->name)->efsvmt);
+    efs->vmt = &spyvmt;
+    spied = 0;
+#if EEPROM_USE_STATIC_BINDING
+    CHECK(EepromFindDevice("none") == &EEPROM_STATIC_DEVICE);
+    CHECK(EepromFileWrite(efs, tx, sizeof tx) == sizeof tx);
+    eepfs_lseek(efs, 0);
+    CHECK(EepromFileRead(efs, rx, sizeof rx) == sizeof rx);
+    CHECK((spied == 0) && (memcmp(rx, tx, sizeof tx) == 0));
+    CHECK(memcmp(&dp->mem[64], tx, sizeof tx) == 0);
+#else
+    CHECK(EepromFindDevice("none") == NULL);
+    CHECK(EepromFileWrite(efs, tx, sizeof tx) == 0);
+    CHECK(EepromFileRead(efs, rx, sizeof rx) == 0);
+    CHECK((spied == 2) && (dp->mem[64] == 0xFF));
+#endif
+  }
+  return true;
+}
+
+#if EEPROM_DRV_USE_24XX && defined(STM32F1XX_I2C)
+/* Single bytes are read in pairs, the dummy one stays inside the device.*/
+static bool test_f1byte(void) {
+  EepromFileStream *efs;
+
+  m24.noshort = true;
+  mem24[0] = 0x11;
+  mem24[1] = 0x22;
+  mem24[DEVICE_SIZE - 2] = 0x44;
+  mem24[DEVICE_SIZE - 1] = 0x33;
+  efs = open_file(&duts[0], 0, 16);
+  CHECK(EepromReadByte(efs) == 0x11);
+  CHECK(EepromReadByte(efs) == 0x22);
+  efs = open_file(&duts[0], DEVICE_SIZE - 1, DEVICE_SIZE);
+  CHECK(EepromReadByte(efs) == 0x33);
+  CHECK(eepfs_getposition(efs) == 1);
+  CHECK((eepfs_geterror(efs) == FILE_OK) && (m24.violations == 0));
+  return true;
+}
+#endif
+
+/* Reading stops at the end of the last stream written, stale blocks of a
+   longer one are not read back.*/
+static bool test_lz(void) {
+  static uint8_t rawbuf[64], packbuf[EEPROM_LZ_PACKBUF_SIZE(64)];
+  static const EepromLzConfig lzcfg = {rawbuf, packbuf, sizeof rawbuf};
+  static EepromLzStream lzs;
+  uint8_t tx[400], rx[400];
+  EepromFileStream *efs;
+  size_t i;
+
+  for (i = 0; i < NDUTS; i++) {
+    const dut_t *dp = &duts[i];
+
+    efs = open_file(dp, 0, 1024);
+    fill(tx, sizeof tx, 1);
+    EepromLzOpenWrite(&lzs, efs, &lzcfg);
+    CHECK(chSequentialStreamWrite(&lzs, tx, sizeof tx) == sizeof tx);
+    CHECK(EepromLzClose(&lzs) == MSG_OK);
+
+    /* Shorter stream over it, in two records.*/
+    fill(tx, sizeof tx, 9);
+    eepfs_lseek(efs, 0);
+    EepromLzOpenWrite(&lzs, efs, &lzcfg);
+    CHECK(chSequentialStreamWrite(&lzs, tx, 30) == 30);
+    CHECK(EepromLzFlush(&lzs) == MSG_OK);
+    CHECK(chSequentialStreamWrite(&lzs, tx + 30, 20) == 20);
+    CHECK(EepromLzClose(&lzs) == MSG_OK);
+
+    eepfs_lseek(efs, 0);
+    EepromLzOpenRead(&lzs, efs, &lzcfg);
+    CHECK(chSequentialStreamRead(&lzs, rx, sizeof rx) == 50);
+    CHECK(memcmp(rx, tx, 50) == 0);
+    CHECK(EepromLzClose(&lzs) == MSG_OK);
+    CHECK(dp->model->violations == 0);
+  }
+  return true;
+}
+
+/* Redundant data, runs and repeated records spanning several blocks, is
+   stored compressed in fewer pages than the same amount of raw data.*/
+static bool test_lzpack(void) {
+  static uint8_t rawbuf[64], packbuf[EEPROM_LZ_PACKBUF_SIZE(64)];
+  static const EepromLzConfig lzcfg = {rawbuf, packbuf, sizeof rawbuf};
+  static EepromLzStream lzs;
+  uint8_t tx[400], rx[400];
+  unsigned long writes, rawwrites;
+  EepromFileStream *efs;
+  size_t i, n;
+
+  for (i = 0; i < NDUTS; i++) {
+    const dut_t *dp = &duts[i];
+
+    efs = open_file(dp, 0, 1024);
+    fill(tx, sizeof tx, 1);
+    writes = dp->model->writes;
+    EepromLzOpenWrite(&lzs, efs, &lzcfg);
+    CHECK(chSequentialStreamWrite(&lzs, tx, sizeof tx) == sizeof tx);
+    CHECK(EepromLzClose(&lzs) == MSG_OK);
+    rawwrites = dp->model->writes - writes;
+
+    /* 16 byte records differing in the sequence byte, then a run.*/
+    for (n = 0; n < 320; n++)
+      tx[n] = (n % 16 == 0) ? (uint8_t)(n / 16) : (uint8_t)(0x40 + n % 16);
+    memset(tx + 320, 0xA5, sizeof tx - 320);
+    efs = open_file(dp, 0, 1024);
+    writes = dp->model->writes;
+    EepromLzOpenWrite(&lzs, efs, &lzcfg);
+    CHECK(chSequentialStreamWrite(&lzs, tx, sizeof tx) == sizeof tx);
+    CHECK(EepromLzClose(&lzs) == MSG_OK);
+    CHECK(dp->model->writes - writes < rawwrites);
+
+    eepfs_lseek(efs, 0);
+    EepromLzOpenRead(&lzs, efs, &lzcfg);
+    CHECK(chSequentialStreamRead(&lzs, rx, sizeof rx) == sizeof rx);
+    CHECK(memcmp(rx, tx, sizeof tx) == 0);
+    CHECK(EepromLzClose(&lzs) == MSG_OK);
+    CHECK(dp->model->violations == 0);
+  }
+  return true;
+}
+
+/* Counter survives reopening across the laps, one byte per increment.*/
+static bool test_counter(void) {
+  static EepromCounterConfig cntcfg = {NULL, 40, 8};
+  EepromCounter cnt;
+  unsigned long writes;
+  size_t i, n;
+
+  for (i = 0; i < NDUTS; i++) {
+    const dut_t *dp = &duts[i];
+
+    cntcfg.efs = open_file(dp, 0, 256);
+    (void)EepromCounterOpen(&cnt, &cntcfg);
+    CHECK(EepromCounterSet(&cnt, 1000) == MSG_OK);
+    for (n = 1; n <= 20; n++) {
+      writes = dp->model->writes;
+      CHECK(EepromCounterIncrement(&cnt) == MSG_OK);
+      CHECK(dp->model->writes == writes + 1);
+      CHECK(EepromCounterOpen(&cnt, &cntcfg) == MSG_OK);
+      CHECK(EepromCounterGet(&cnt) == 1000 + n);
+    }
+    CHECK(dp->model->violations == 0);
+  }
+  return true;
+}
+
+static const struct {
+  const char    *name;
+  bool          (*fn)(void);
+} tests[] = {
+  {"split",          test_split},
+  {"fail",           test_fail},
+  {"binding",        test_binding},
+  {"lz",             test_lz},
+  {"lzpack",         test_lzpack},
+  {"counter",        test_counter},
+#if EEPROM_DRV_USE_24XX && defined(STM32F1XX_I2C)
+  {"f1byte",         test_f1byte},
+#endif
+};
+
+/*===========================================================================*/
+/* Entry point.                                                              */
+/*===========================================================================*/
+
+int main(void) {
+  int failures = 0;
+  size_t i;
+
+  for (i = 0; i < sizeof tests / sizeof tests[0]; i++) {
+    bool ok;
+
+    setup();
+    ok = tests[i].fn();
+    printf("%s %s\n", ok ? "PASS" : "FAIL", tests[i].name);
+    if (!ok)
+      failures++;
+  }
+  printf("%d of %zu tests failed\n", failures, sizeof tests / sizeof tests[0]);
+  return failures;
+}
+
+/** @} */
@@ -0,0 +1,509 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/hal.h
+ * @brief   Host replacement of the ChibiOS HAL for the IUART driver.
+ * @details Provides the OSAL subset, the interrupt macros, the RCC, NVIC
+ *          and DMA stream stand-ins and the USARTv2 register layout and
+ *          bits used by the driver, so that it can be compiled and run on
+ *          Linux against the USART and DMA models in @p usart_model.c. The I2C and SPI
+ *          drivers used by the EEPROM backends are served by the device
+ *          models in @p eeprom_model.c, the DAC and basic timer registers
+ *          by the model in @p dac_model.c.
+ *
+ * @addtogroup IUART_HOST
+ * @{
+ */
+
+#ifndef _HAL_H_
+#define _HAL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "drivers_conf.h"
+
+/*===========================================================================*/
+/* OSAL subset.                                                              */
+/*===========================================================================*/
+
+#if !defined(FALSE)
+#define FALSE                       0
+#endif
+#if !defined(TRUE)
+#define TRUE                        (!FALSE)
+#endif
+
+typedef int32_t msg_t;
+typedef uint32_t systime_t;
+
+#define MSG_OK                      ((msg_t)0)
+#define MSG_TIMEOUT                 ((msg_t)-1)
+#define MSG_RESET                   ((msg_t)-2)
+
+#define TIME_IMMEDIATE              ((systime_t)0)
+#define TIME_INFINITE               ((systime_t)-1)
+
+/**
+ * @brief   Bit times of the virtual line clock per system tick.
+ */
+#define HOST_BITS_PER_TICK          10U
+
+typedef struct thread thread_t;
+typedef thread_t *thread_reference_t;
+
+/**
+ * @brief   Host thread, the main one or one created by the test.
+ */
+struct thread {
+  msg_t                     msg;      /**< @brief Wakeup message.         */
+};
+
+#define osalDbgCheck(c)             host_check((c) ? 1 : 0, #c,             \
+                                               __func__, __LINE__)
+#define osalDbgAssert(c, remark)    host_check((c) ? 1 : 0, remark,         \
+                                               __func__, __LINE__)
+#define osalSysHalt(reason)         host_check(0, reason, __func__, __LINE__)
+#define osalThreadSuspendS(trp)     osalThreadSuspendTimeoutS(trp, TIME_INFINITE)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void host_check(int c, const char *what, const char *func, int line);
+  bool host_locked(void);
+  void osalDbgCheckClassI(void);
+  void osalSysLock(void);
+  void osalSysUnlock(void);
+  void osalSysLockFromISR(void);
+  void osalSysUnlockFromISR(void);
+  msg_t osalThreadSuspendTimeoutS(thread_reference_t *trp, systime_t timeout);
+  void osalThreadResumeI(thread_reference_t *trp, msg_t msg);
+  void osalThreadResumeS(thread_reference_t *trp, msg_t msg);
+  void osalOsRescheduleS(void);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Channels.                                                                 */
+/*===========================================================================*/
+
+#define _base_sequential_stream_methods                                     \
+  size_t (*write)(void *instance, const uint8_t *bp, size_t n);             \
+  size_t (*read)(void *instance, uint8_t *bp, size_t n);                    \
+  msg_t (*put)(void *instance, uint8_t b);                                  \
+  msg_t (*get)(void *instance);
+
+#define _base_sequential_stream_data
+
+#define _base_channel_methods                                               \
+  _base_sequential_stream_methods                                           \
+  msg_t (*putt)(void *instance, uint8_t b, systime_t time);                 \
+  msg_t (*gett)(void *instance, systime_t time);                            \
+  size_t (*writet)(void *instance, const uint8_t *bp, size_t n,             \
+                   systime_t time);                                         \
+  size_t (*readt)(void *instance, uint8_t *bp, size_t n, systime_t time);
+
+#define _base_channel_data          _base_sequential_stream_data
+
+#define chSequentialStreamWrite(ip, bp, n) ((ip)->vmt->write(ip, bp, n))
+#define chSequentialStreamRead(ip, bp, n)  ((ip)->vmt->read(ip, bp, n))
+
+/*===========================================================================*/
+/* I2C and SPI.                                                              */
+/*===========================================================================*/
+
+#define HAL_USE_I2C                 TRUE
+#define HAL_USE_SPI                 TRUE
+#define I2C_USE_MUTUAL_EXCLUSION    FALSE
+#define SPI_USE_MUTUAL_EXCLUSION    FALSE
+
+typedef uint16_t i2caddr_t;
+
+typedef struct {
+  uint32_t                  clock_speed;
+} I2CConfig;
+
+/**
+ * @brief   I2C driver, the device model answers all the addresses.
+ */
+typedef struct {
+  const I2CConfig           *config;
+  void                      *dev;     /**< @brief Device model.           */
+} I2CDriver;
+
+typedef struct {
+  uint32_t                  cr1;
+} SPIConfig;
+
+/**
+ * @brief   SPI driver, a single device model on the chip select.
+ */
+typedef struct {
+  const SPIConfig           *config;
+  void                      *dev;     /**< @brief Device model.           */
+} SPIDriver;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  msg_t i2cMasterTransmitTimeout(I2CDriver *i2cp, i2caddr_t addr,
+                                 const uint8_t *txbuf, size_t txbytes,
+                                 uint8_t *rxbuf, size_t rxbytes,
+                                 systime_t timeout);
+  void spiStart(SPIDriver *spip, const SPIConfig *config);
+  void spiSelect(SPIDriver *spip);
+  void spiUnselect(SPIDriver *spip);
+  void spiSend(SPIDriver *spip, size_t n, const void *txbuf);
+  void spiReceive(SPIDriver *spip, size_t n, void *rxbuf);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Core and interrupts.                                                      */
+/*===========================================================================*/
+
+#define CORTEX_IS_VALID_KERNEL_PRIORITY(prio) (((prio) >= 2) && ((prio) < 16))
+
+#define CH_IRQ_HANDLER(id)          void id(void)
+#define CH_IRQ_PROLOGUE()
+#define CH_IRQ_EPILOGUE()
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  unsigned long simNow(void);
+  void nvicEnableVector(uint32_t n, uint32_t prio);
+  void nvicDisableVector(uint32_t n);
+  bool host_nvic_enabled(uint32_t n);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* DMA.                                                                      */
+/*===========================================================================*/
+
+#define STM32_ADVANCED_DMA          TRUE
+
+/**
+ * @brief   Number of DMA streams, two controllers of eight.
+ */
+#define STM32_DMA_STREAMS           16U
+
+/**
+ * @brief   DMA stream registers.
+ * @note    The addresses are host pointers instead of 32 bit registers.
+ */
+typedef struct {
+  volatile uint32_t         CR;
+  volatile uint32_t         NDTR;
+  volatile void             *PAR;
+  void                      *M0AR;
+} DMA_Stream_TypeDef;
+
+/**
+ * @brief   DMA stream ISR, @p flags are the pre-shifted ISR bits.
+ */
+typedef void (*stm32_dmaisr_t)(void *p, uint32_t flags);
+
+/**
+ * @brief   DMA stream descriptor.
+ */
+typedef struct {
+  DMA_Stream_TypeDef        *stream;
+  uint8_t                   selfindex;
+} stm32_dma_stream_t;
+
+extern const stm32_dma_stream_t _stm32_dma_streams[STM32_DMA_STREAMS];
+
+#define STM32_DMA_STREAM_ID(dma, stream) ((((dma) - 1U) * 8U) + (stream))
+#define STM32_DMA_STREAM_ID_MSK(dma, stream)                                \
+  (1U << STM32_DMA_STREAM_ID(dma, stream))
+#define STM32_DMA_IS_VALID_ID(id, mask) (((1U << (id)) & (mask)))
+#define STM32_DMA_STREAM(id)        (&_stm32_dma_streams[id])
+#define STM32_DMA_GETCHANNEL(id, c) (((c) >> (((id) & 7U) * 4U)) & 15U)
+
+/* CR.*/
+#define STM32_DMA_CR_EN             (1U << 0)
+#define STM32_DMA_CR_DMEIE          (1U << 1)
+#define STM32_DMA_CR_TEIE           (1U << 2)
+#define STM32_DMA_CR_HTIE           (1U << 3)
+#define STM32_DMA_CR_TCIE           (1U << 4)
+#define STM32_DMA_CR_DIR_MASK       (3U << 6)
+#define STM32_DMA_CR_DIR_P2M        (0U << 6)
+#define STM32_DMA_CR_DIR_M2P        (1U << 6)
+#define STM32_DMA_CR_CIRC           (1U << 8)
+#define STM32_DMA_CR_MINC           (1U << 10)
+#define STM32_DMA_CR_PSIZE_BYTE     (0U << 11)
+#define STM32_DMA_CR_PSIZE_HWORD    (1U << 11)
+#define STM32_DMA_CR_MSIZE_BYTE     (0U << 13)
+#define STM32_DMA_CR_MSIZE_HWORD    (1U << 13)
+#define STM32_DMA_CR_SIZE_MASK      (15U << 11)
+#define STM32_DMA_CR_PL(n)          ((n) << 16)
+#define STM32_DMA_CR_CHSEL(n)       ((n) << 25)
+
+/* Pre-shifted ISR.*/
+#define STM32_DMA_ISR_DMEIF         (1U << 2)
+#define STM32_DMA_ISR_TEIF          (1U << 3)
+#define STM32_DMA_ISR_HTIF          (1U << 4)
+#define STM32_DMA_ISR_TCIF          (1U << 5)
+
+#define dmaStreamSetPeripheral(dmastp, addr)                                \
+  ((dmastp)->stream->PAR = (addr))
+#define dmaStreamSetMemory0(dmastp, addr)                                   \
+  ((dmastp)->stream->M0AR = (void *)(addr))
+#define dmaStreamSetTransactionSize(dmastp, size)                           \
+  ((dmastp)->stream->NDTR = (uint32_t)(size))
+#define dmaStreamGetTransactionSize(dmastp)                                 \
+  ((size_t)(dmastp)->stream->NDTR)
+#define dmaStreamSetMode(dmastp, mode)                                      \
+  ((dmastp)->stream->CR = (uint32_t)(mode))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  bool dmaStreamAllocate(const stm32_dma_stream_t *dmastp, uint32_t priority,
+                         stm32_dmaisr_t func, void *param);
+  void dmaStreamRelease(const stm32_dma_stream_t *dmastp);
+  void dmaStreamDisable(const stm32_dma_stream_t *dmastp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Device.                                                                   */
+/*===========================================================================*/
+
+#define STM32_PCLK1                 36000000U
+#define STM32_PCLK2                 72000000U
+
+/* The basic timers count one clock per bit time.*/
+#define STM32_TIMCLK1               1000000U
+
+#define STM32_HAS_USART1            TRUE
+#define STM32_HAS_USART2            TRUE
+#define STM32_HAS_USART3            TRUE
+#define STM32_HAS_UART4             FALSE
+#define STM32_HAS_UART5             FALSE
+#define STM32_HAS_USART6            FALSE
+#define STM32_HAS_UART7             FALSE
+#define STM32_HAS_UART8             FALSE
+#define STM32_HAS_LPUART1           FALSE
+
+#define STM32_USART1_NUMBER         37
+#define STM32_USART2_NUMBER         38
+#define STM32_USART3_NUMBER         39
+
+#define STM32_USART1_HANDLER        Vector_USART1
+#define STM32_USART2_HANDLER        Vector_USART2
+#define STM32_USART3_HANDLER        Vector_USART3
+
+/* Any stream serves any USART, on channel 4.*/
+#define STM32_USART1_RX_DMA_MSK     0xFFFFU
+#define STM32_USART1_RX_DMA_CHN     0x44444444U
+#define STM32_USART1_TX_DMA_MSK     0xFFFFU
+#define STM32_USART1_TX_DMA_CHN     0x44444444U
+#define STM32_USART2_RX_DMA_MSK     0xFFFFU
+#define STM32_USART2_RX_DMA_CHN     0x44444444U
+#define STM32_USART2_TX_DMA_MSK     0xFFFFU
+#define STM32_USART2_TX_DMA_CHN     0x44444444U
+#define STM32_USART3_RX_DMA_MSK     0xFFFFU
+#define STM32_USART3_RX_DMA_CHN     0x44444444U
+#define STM32_USART3_TX_DMA_MSK     0xFFFFU
+#define STM32_USART3_TX_DMA_CHN     0x44444444U
+
+typedef struct {
+  volatile uint32_t         APB1ENR;
+  volatile uint32_t         APB2ENR;
+  volatile uint32_t         APB1RSTR;
+} RCC_TypeDef;
+
+#define RCC_APB1ENR_TIM6EN          (1U << 4)
+#define RCC_APB1ENR_TIM7EN          (1U << 5)
+#define RCC_APB1ENR_USART2EN        (1U << 17)
+#define RCC_APB1ENR_USART3EN        (1U << 18)
+#define RCC_APB1ENR_DACEN           (1U << 29)
+#define RCC_APB2ENR_USART1EN        (1U << 14)
+#define RCC_APB1RSTR_TIM6RST        (1U << 4)
+#define RCC_APB1RSTR_TIM7RST        (1U << 5)
+#define RCC_APB1RSTR_DACRST         (1U << 29)
+
+typedef struct {
+  volatile uint32_t         CR1;
+  volatile uint32_t         CR2;
+  volatile uint32_t         CR3;
+  volatile uint32_t         BRR;
+  volatile uint32_t         GTPR;
+  volatile uint32_t         RTOR;
+  volatile uint32_t         RQR;
+  volatile uint32_t         ISR;
+  volatile uint32_t         ICR;
+  volatile uint32_t         RDR;
+  volatile uint32_t         TDR;
+} USART_TypeDef;
+
+extern RCC_TypeDef host_rcc;
+extern USART_TypeDef host_usart1, host_usart2, host_usart3;
+
+#define RCC                         (&host_rcc)
+#define USART1                      (&host_usart1)
+#define USART2                      (&host_usart2)
+#define USART3                      (&host_usart3)
+
+/* CR1.*/
+#define USART_CR1_UE                (1U << 0)
+#define USART_CR1_UESM              (1U << 1)
+#define USART_CR1_RE                (1U << 2)
+#define USART_CR1_TE                (1U << 3)
+#define USART_CR1_IDLEIE            (1U << 4)
+#define USART_CR1_RXNEIE            (1U << 5)
+#define USART_CR1_TCIE              (1U << 6)
+#define USART_CR1_TXEIE             (1U << 7)
+#define USART_CR1_PEIE              (1U << 8)
+#define USART_CR1_PS                (1U << 9)
+#define USART_CR1_PCE               (1U << 10)
+#define USART_CR1_WAKE              (1U << 11)
+#define USART_CR1_M0                (1U << 12)
+#define USART_CR1_MME               (1U << 13)
+#define USART_CR1_CMIE              (1U << 14)
+#define USART_CR1_OVER8             (1U << 15)
+#define USART_CR1_DEDT              (0x1FU << 16)
+#define USART_CR1_DEAT              (0x1FU << 21)
+#define USART_CR1_RTOIE             (1U << 26)
+#define USART_CR1_EOBIE             (1U << 27)
+#define USART_CR1_M1                (1U << 28)
+#define USART_CR1_M                 (USART_CR1_M0 | USART_CR1_M1)
+
+/* CR2.*/
+#define USART_CR2_ADDM7             (1U << 4)
+#define USART_CR2_LBDL              (1U << 5)
+#define USART_CR2_LBDIE             (1U << 6)
+#define USART_CR2_STOP              (3U << 12)
+#define USART_CR2_STOP_1            (2U << 12)
+#define USART_CR2_RTOEN             (1U << 23)
+#define USART_CR2_ADD               (0xFFU << 24)
+
+/* CR3.*/
+#define USART_CR3_EIE               (1U << 0)
+#define USART_CR3_HDSEL             (1U << 3)
+#define USART_CR3_DMAR              (1U << 6)
+#define USART_CR3_DMAT              (1U << 7)
+#define USART_CR3_RTSE              (1U << 8)
+#define USART_CR3_CTSE              (1U << 9)
+#define USART_CR3_CTSIE             (1U << 10)
+#define USART_CR3_OVRDIS            (1U << 12)
+#define USART_CR3_DEM               (1U << 14)
+#define USART_CR3_DEP               (1U << 15)
+
+/* RTOR.*/
+#define USART_RTOR_RTO              0x00FFFFFFU
+
+/* RQR.*/
+#define USART_RQR_MMRQ              (1U << 2)
+#define USART_RQR_RXFRQ             (1U << 3)
+
+/* ISR and ICR, the clear bits share the flag positions.*/
+#define USART_ISR_PE                (1U << 0)
+#define USART_ISR_FE                (1U << 1)
+#define USART_ISR_NE                (1U << 2)
+#define USART_ISR_ORE               (1U << 3)
+#define USART_ISR_IDLE              (1U << 4)
+#define USART_ISR_RXNE              (1U << 5)
+#define USART_ISR_TC                (1U << 6)
+#define USART_ISR_TXE               (1U << 7)
+#define USART_ISR_LBDF              (1U << 8)
+#define USART_ISR_CTSIF             (1U << 9)
+#define USART_ISR_CTS               (1U << 10)
+#define USART_ISR_RTOF              (1U << 11)
+#define USART_ISR_CMF               (1U << 17)
+#define USART_ISR_RWU               (1U << 19)
+
+/*===========================================================================*/
+/* DAC and basic timers.                                                     */
+/*===========================================================================*/
+
+typedef struct {
+  volatile uint32_t         CR;
+  volatile uint32_t         SWTRIGR;
+  volatile uint32_t         DHR12R1;
+  volatile uint32_t         DHR12L1;
+  volatile uint32_t         DHR8R1;
+  volatile uint32_t         DHR12R2;
+  volatile uint32_t         DHR12L2;
+  volatile uint32_t         DHR8R2;
+  volatile uint32_t         DHR12RD;
+  volatile uint32_t         DHR12LD;
+  volatile uint32_t         DHR8RD;
+  volatile uint32_t         DOR1;
+  volatile uint32_t         DOR2;
+  volatile uint32_t         SR;
+} DAC_TypeDef;
+
+extern DAC_TypeDef host_dac;
+
+#define DAC                         (&host_dac)
+
+/* CR, channel 1 bits, channel 2 ones are 16 bits higher.*/
+#define DAC_CR_EN1                  (1U << 0)
+#define DAC_CR_BOFF1                (1U << 1)
+#define DAC_CR_TEN1                 (1U << 2)
+#define DAC_CR_TSEL1                (7U << 3)
+#define DAC_CR_TSEL1_0              (1U << 3)
+#define DAC_CR_TSEL1_1              (2U << 3)
+#define DAC_CR_TSEL1_2              (4U << 3)
+#define DAC_CR_WAVE1_0              (1U << 6)
+#define DAC_CR_WAVE1_1              (2U << 6)
+#define DAC_CR_MAMP1_0              (1U << 8)
+#define DAC_CR_MAMP1_1              (2U << 8)
+#define DAC_CR_MAMP1_2              (4U << 8)
+#define DAC_CR_MAMP1_3              (8U << 8)
+#define DAC_CR_DMAEN1               (1U << 12)
+
+/* SWTRIGR.*/
+#define DAC_SWTRIGR_SWTRIG1         (1U << 0)
+#define DAC_SWTRIGR_SWTRIG2         (1U << 1)
+
+/* CR1.*/
+#define TIM_CR1_CEN                 (1U << 0)
+
+/* CR2.*/
+#define TIM_CR2_MMS                 (7U << 4)
+#define TIM_CR2_MMS_1               (2U << 4)
+
+/* SR.*/
+#define TIM_SR_UIF                  (1U << 0)
+
+/* EGR.*/
+#define TIM_EGR_UG                  (1U << 0)
+
+#endif /* _HAL_H_ */
+
+/** @} */
@@ -0,0 +1,385 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/host_osal.c
+ * @brief   Host OSAL for the IUART driver, EEPROM and DAC tests.
+ * @details A thread that suspends runs the simulation clock until it is
+ *          resumed or its timeout expires, so blocking driver calls work as
+ *          on the target. The lock rules of the kernel are checked, a
+ *          violation fails the test run. The thread delays of the EEPROM
+ *          engine run the clock too.
+ *
+ *          The threads created by the test are coroutines with priority
+ *          over the main thread. One that becomes ready runs after the bit
+ *          time in which the main thread readied it or waited, until it
+ *          waits on a semaphore or ends. While it runs the main thread is
+ *          preempted and its own waits run the clock.
+ *
+ * @addtogroup IUART_HOST
+ * @{
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+#include "ch.h"
+#include "usart_model.h"
+
+/*===========================================================================*/
+/* Local definitions.                                                        */
+/*===========================================================================*/
+
+/* Longest wait of an infinite suspend before a deadlock is reported.*/
+#define DEADLOCK_BITS           10000000UL
+
+#define NVIC_VECTORS            128
+
+#define HOST_THREADS            4
+
+/*===========================================================================*/
+/* Local variables and types.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Host thread state, at the start of the working area of the
+ *          created threads.
+ */
+typedef struct {
+  thread_t                  thd;
+  ucontext_t                ctx;
+  tfunc_t                   pf;
+  void                      *arg;
+  /* Semaphore waited on or NULL.*/
+  semaphore_t               *wsem;
+  bool                      final;
+} host_thread_t;
+
+static bool locked;
+static bool isrlocked;
+static host_thread_t mainthd;
+static host_thread_t *current = &mainthd;
+static host_thread_t *threads[HOST_THREADS];
+static bool nvic[NVIC_VECTORS];
+
+/*===========================================================================*/
+/* Local functions.                                                          */
+/*===========================================================================*/
+
+static void switch_to(host_thread_t *tp) {
+  host_thread_t *prev = current;
+
+  current = tp;
+  swapcontext(&prev->ctx, &tp->ctx);
+}
+
+/**
+ * @brief   Runs the created threads that are ready, from the main thread.
+ */
+static void reschedule(void) {
+  unsigned i;
+
+  if ((current != &mainthd) || locked || simInISR())
+    return;
+  for (i = 0; i < HOST_THREADS; i++) {
+    host_thread_t *tp = threads[i];
+
+    if ((tp == NULL) || tp->final)
+      continue;
+    if (tp->wsem != NULL) {
+      if (tp->wsem->cnt <= 0)
+        continue;
+      tp->wsem->cnt--;
+      tp->wsem = NULL;
+    }
+    switch_to(tp);
+  }
+}
+
+/**
+ * @brief   One bit time of the clock, the ready threads run after it.
+ */
+static void tick(void) {
+
+  simTick();
+  reschedule();
+}
+
+static void thread_entry(void) {
+  host_thread_t *tp = current;
+
+  tp->pf(tp->arg);
+  tp->final = true;
+  switch_to(&mainthd);
+}
+
+/*===========================================================================*/
+/* Exported functions.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   Debug check, a failure ends the run.
+ */
+void host_check(int c, const char *what, const char *func, int line) {
+
+  if (!c) {
+    fprintf(stderr, "check failed: %s, %s():%d\n", what, func, line);
+    abort();
+  }
+}
+
+/**
+ * @brief   The thread is in a critical zone.
+ */
+bool host_locked(void) {
+
+  return locked;
+}
+
+void osalDbgCheckClassI(void) {
+
+  host_check(locked || isrlocked || simInISR(), "not I-class context",
+             __func__, __LINE__);
+}
+
+void osalSysLock(void) {
+
+  host_check(!simInISR(), "lock from ISR", __func__, __LINE__);
+  host_check(!locked, "nested lock", __func__, __LINE__);
+  locked = true;
+}
+
+void osalSysUnlock(void) {
+
+  host_check(locked, "not locked", __func__, __LINE__);
+  locked = false;
+}
+
+void osalSysLockFromISR(void) {
+
+  host_check(simInISR(), "ISR lock from thread", __func__, __LINE__);
+  host_check(!isrlocked, "nested ISR lock", __func__, __LINE__);
+  isrlocked = true;
+}
+
+void osalSysUnlockFromISR(void) {
+
+  host_check(isrlocked, "ISR not locked", __func__, __LINE__);
+  isrlocked = false;
+}
+
+/**
+ * @brief   Suspends the thread, the simulation runs meanwhile.
+ */
+msg_t osalThreadSuspendTimeoutS(thread_reference_t *trp, systime_t timeout) {
+  unsigned long bits;
+
+  host_check(locked && !simInISR(), "not S-class context", __func__, __LINE__);
+  host_check(*trp == NULL, "reference in use", __func__, __LINE__);
+  if (timeout == TIME_IMMEDIATE)
+    return MSG_TIMEOUT;
+
+  bits = (timeout == TIME_INFINITE) ? DEADLOCK_BITS :
+                                      (unsigned long)timeout * HOST_BITS_PER_TICK;
+  current->thd.msg = MSG_TIMEOUT;
+  *trp = &current->thd;
+  locked = false;
+  while (*trp != NULL) {
+    if (bits-- == 0) {
+      host_check(timeout != TIME_INFINITE, "deadlock", __func__, __LINE__);
+      *trp = NULL;
+      break;
+    }
+    tick();
+  }
+  locked = true;
+  return current->thd.msg;
+}
+
+void osalThreadResumeI(thread_reference_t *trp, msg_t msg) {
+
+  osalDbgCheckClassI();
+  if (*trp != NULL) {
+    (*trp)->msg = msg;
+    *trp = NULL;
+  }
+}
+
+void osalThreadResumeS(thread_reference_t *trp, msg_t msg) {
+
+  host_check(locked, "not S-class context", __func__, __LINE__);
+  osalThreadResumeI(trp, msg);
+}
+
+void osalOsRescheduleS(void) {
+
+  host_check(locked, "not S-class context", __func__, __LINE__);
+}
+
+systime_t chVTGetSystemTimeX(void) {
+
+  return (systime_t)(simNow() / HOST_BITS_PER_TICK);
+}
+
+void chThdSleep(systime_t time) {
+
+  unsigned long bits = (unsigned long)time * HOST_BITS_PER_TICK;
+
+  host_check(!locked && !simInISR(), "not thread context", __func__, __LINE__);
+  while (bits-- > 0)
+    tick();
+}
+
+/**
+ * @brief   Other threads run for one bit time.
+ */
+void chThdYield(void) {
+
+  host_check(!locked && !simInISR(), "not thread context", __func__, __LINE__);
+  tick();
+}
+
+/**
+ * @brief   Creates a thread in a working area of @p THD_WORKING_AREA().
+ * @note    The priority is not modelled, see the file description.
+ */
+thread_t *chThdCreateStatic(void *wsp, size_t size, tprio_t prio,
+                            tfunc_t pf, void *arg) {
+  host_thread_t *tp = wsp;
+  unsigned i;
+
+  (void)prio;
+  host_check(!locked && !simInISR(), "not thread context", __func__, __LINE__);
+  host_check(size >= sizeof *tp + HOST_THD_STACK / 2, "working area",
+             __func__, __LINE__);
+  for (i = 0; (i < HOST_THREADS) && (threads[i] != NULL) &&
+              !threads[i]->final; i++)
+    ;
+  host_check(i < HOST_THREADS, "too many threads", __func__, __LINE__);
+
+  getcontext(&tp->ctx);
+  tp->ctx.uc_stack.ss_sp   = (uint8_t *)wsp + sizeof *tp;
+  tp->ctx.uc_stack.ss_size = size - sizeof *tp;
+  tp->ctx.uc_link          = NULL;
+  makecontext(&tp->ctx, thread_entry, 0);
+  tp->pf    = pf;
+  tp->arg   = arg;
+  tp->wsem  = NULL;
+  tp->final = false;
+  threads[i] = tp;
+  reschedule();
+  return &tp->thd;
+}
+
+/**
+ * @brief   Waits for the end of a thread, from the main thread.
+ */
+msg_t chThdWait(thread_t *tp) {
+  host_thread_t *htp = (host_thread_t *)tp;
+  unsigned long bits = DEADLOCK_BITS;
+
+  host_check((current == &mainthd) && !locked && !simInISR(),
+             "not main thread", __func__, __LINE__);
+  reschedule();
+  while (!htp->final) {
+    host_check(bits-- > 0, "deadlock", __func__, __LINE__);
+    tick();
+  }
+  return MSG_OK;
+}
+
+void chSemObjectInit(semaphore_t *sp, cnt_t n) {
+
+  sp->cnt = n;
+}
+
+void chSemReset(semaphore_t *sp, cnt_t n) {
+
+  host_check(!locked && !simInISR(), "not thread context", __func__, __LINE__);
+  sp->cnt = n;
+}
+
+/**
+ * @brief   Waits on a semaphore, a created thread gives the CPU back.
+ */
+msg_t chSemWait(semaphore_t *sp) {
+  unsigned long bits = DEADLOCK_BITS;
+
+  host_check(!locked && !simInISR(), "not thread context", __func__, __LINE__);
+  if (sp->cnt > 0) {
+    sp->cnt--;
+    return MSG_OK;
+  }
+  if (current != &mainthd) {
+    current->wsem = sp;
+    switch_to(&mainthd);
+    return MSG_OK;
+  }
+  while (sp->cnt <= 0) {
+    host_check(bits-- > 0, "deadlock", __func__, __LINE__);
+    tick();
+  }
+  sp->cnt--;
+  return MSG_OK;
+}
+
+void chSemSignal(semaphore_t *sp) {
+
+  host_check(!locked && !simInISR(), "not thread context", __func__, __LINE__);
+  sp->cnt++;
+  reschedule();
+}
+
+void chSemSignalI(semaphore_t *sp) {
+
+  osalDbgCheckClassI();
+  sp->cnt++;
+}
+
+void nvicEnableVector(uint32_t n, uint32_t prio) {
+
+  (void)prio;
+  host_check(n < NVIC_VECTORS, "vector number", __func__, __LINE__);
+  nvic[n] = true;
+}
+
+void nvicDisableVector(uint32_t n) {
+
+  host_check(n < NVIC_VECTORS, "vector number", __func__, __LINE__);
+  nvic[n] = false;
+}
+
+/**
+ * @brief   The vector is enabled.
+ */
+bool host_nvic_enabled(uint32_t n) {
+
+  return (n < NVIC_VECTORS) && nvic[n];
+}
+
+/** @} */
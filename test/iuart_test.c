@@ -0,0 +1,1174 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/iuart_test.c
+ * @brief   IUART driver tests and benchmark on the USART model.
+ * @details Without arguments the tests are run, the exit status is the
+ *          number of failures. With @p -b the ISR cost per byte is
+ *          measured, in instructions when the kernel allows hardware
+ *          counters, else in nanoseconds.
+ *
+ * @addtogroup IUART_HOST
+ * @{
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+/* Output delay names of termios, clashing with the register names.*/
+#undef CR1
+#undef CR2
+#undef CR3
+
+#include "ch.h"
+#include "hal.h"
+#include "iuart_driver.h"
+#include "usart_model.h"
+
+/*===========================================================================*/
+/* Local definitions.                                                        */
+/*===========================================================================*/
+
+#define CHECK(c) do {                                                       \
+  if (!(c)) {                                                               \
+    printf("  %s:%d: %s\n", __FILE__, __LINE__, #c);                        \
+    return false;                                                           \
+  }                                                                         \
+} while (0)
+
+/* Bit times per frame of the default 8N1 format.*/
+#define FRAME                   10UL
+
+/* Transfers of USART1 go through the DMA model.*/
+#define RX_DMA                  STM32_IUART_USART1_USE_RX_DMA
+#define TX_DMA                  STM32_IUART_USART1_USE_TX_DMA
+
+void Vector_USART1(void);
+void Vector_USART2(void);
+
+/*===========================================================================*/
+/* Local variables and types.                                                */
+/*===========================================================================*/
+
+static usart_model_t m1, m2;
+
+/* Callbacks trace, one letter per callback.*/
+static char trace[512];
+static size_t tracelen;
+static uint16_t rxchars[256];
+static size_t nrxchars;
+static iuartflags_t rxerrors;
+static size_t framelen;
+
+/*===========================================================================*/
+/* Callbacks.                                                                */
+/*===========================================================================*/
+
+static void note(char c) {
+
+  if (tracelen < sizeof trace - 1)
+    trace[tracelen++] = c;
+  trace[tracelen] = '\0';
+}
+
+static void txend1(IUARTDriver *iuartp) {
+
+  (void)iuartp;
+  note('T');
+}
+
+static void txend2(IUARTDriver *iuartp) {
+
+  (void)iuartp;
+  note('E');
+}
+
+static void rxend(IUARTDriver *iuartp) {
+
+  (void)iuartp;
+  note('R');
+}
+
+static void rxchar(IUARTDriver *iuartp, uint16_t c) {
+
+  (void)iuartp;
+  note('c');
+  if (nrxchars < sizeof rxchars / sizeof rxchars[0])
+    rxchars[nrxchars++] = c;
+}
+
+static void rxerr(IUARTDriver *iuartp, iuartflags_t e) {
+
+  (void)iuartp;
+  note('x');
+  rxerrors |= e;
+}
+
+#if IUART_USE_FRAMING
+static void rxframe(IUARTDriver *iuartp, size_t n) {
+
+  (void)iuartp;
+  note('F');
+  framelen = n;
+}
+#endif
+
+/*===========================================================================*/
+/* Helpers.                                                                  */
+/*===========================================================================*/
+
+static const IUARTConfig cfg_default = {
+  .txend1_cb  = txend1,
+  .txend2_cb  = txend2,
+  .rxend_cb   = rxend,
+  .rxchar_cb  = rxchar,
+  .rxerr_cb   = rxerr,
+  .speed      = 115200,
+};
+
+static void setup(void) {
+
+  /* Test configurations are on the stack of a test that may be gone.*/
+  if (IUARTD1.state == IUART_READY) {
+    IUARTD1.config = &cfg_default;
+    iuartStop(&IUARTD1);
+  }
+  if (IUARTD2.state == IUART_READY) {
+    IUARTD2.config = &cfg_default;
+    iuartStop(&IUARTD2);
+  }
+  modelReset(&m1);
+  modelReset(&m2);
+  tracelen = 0;
+  trace[0] = '\0';
+  nrxchars = 0;
+  rxerrors = 0;
+  framelen = 0;
+}
+
+static bool traced(void *arg) {
+
+  return strstr(trace, (const char *)arg) != NULL;
+}
+
+#if IUART_USE_DEFERRED
+static bool tx_idle(void *arg) {
+  IUARTDriver *iuartp = arg;
+
+  return (iuartp->txstate == IUART_TX_IDLE) &&
+         ((iuartp->usart->CR1 & (USART_CR1_TXEIE | USART_CR1_TCIE)) == 0);
+}
+#endif
+
+static void fill(uint8_t *bp, size_t n, unsigned seed) {
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    bp[i] = (uint8_t)(seed + i * 7);
+}
+
+/*===========================================================================*/
+/* Tests.                                                                    */
+/*===========================================================================*/
+
+/* Block transfer in loopback and order of the callbacks.*/
+static bool test_block_loopback(void) {
+  uint8_t tx[64], rx[64];
+
+  modelLink(&m1, &m1);
+  iuartStart(&IUARTD1, &cfg_default);
+  fill(tx, sizeof tx, 1);
+  memset(rx, 0, sizeof rx);
+  iuartStartReceive(&IUARTD1, sizeof rx, rx);
+  iuartStartSend(&IUARTD1, sizeof tx, tx);
+  CHECK(simRunUntil(traced, "E", 2 * sizeof tx * FRAME));
+  CHECK(memcmp(tx, rx, sizeof tx) == 0);
+  CHECK(strcmp(trace, "TRE") == 0);
+  CHECK(IUARTD1.rxstate == IUART_RX_IDLE);
+  CHECK(IUARTD1.txstate == IUART_TX_IDLE);
+  CHECK(m1.txframes == sizeof tx);
+#if RX_DMA && TX_DMA
+  CHECK(IUARTD1.rxdma && IUARTD1.txdma);
+  CHECK(m1.isrcalls <= 2);
+#endif
+  return true;
+}
+
+/* Characters outside of a block receive go to the character callback.*/
+static bool test_rxchar(void) {
+  static const uint8_t msg[] = "hello";
+
+  iuartStart(&IUARTD1, &cfg_default);
+  modelInjectBytes(&m1, msg, 5);
+  simRun(6 * FRAME);
+  CHECK(strcmp(trace, "ccccc") == 0);
+  CHECK((nrxchars == 5) && (rxchars[0] == 'h') && (rxchars[4] == 'o'));
+  return true;
+}
+
+/* Line errors are reported with the character.*/
+static bool test_errors(void) {
+  static const uint16_t c = 0x55;
+
+  iuartStart(&IUARTD1, &cfg_default);
+  modelInject(&m1, &c, 1, USART_ISR_FE | USART_ISR_NE);
+  simRun(2 * FRAME);
+  CHECK(rxerrors == (IUART_FRAMING_ERROR | IUART_NOISE_ERROR));
+  CHECK(strcmp(trace, "xc") == 0);
+  return true;
+}
+
+/* Interrupt latency above a frame time loses characters.*/
+static bool test_overrun(void) {
+  uint8_t buf[20];
+
+  iuartStart(&IUARTD1, &cfg_default);
+  m1.latency = 15;
+  fill(buf, sizeof buf, 3);
+  modelInjectBytes(&m1, buf, sizeof buf);
+  simRun((sizeof buf + 4) * FRAME);
+  CHECK(m1.overruns > 0);
+  CHECK(rxerrors & IUART_OVERRUN_ERROR);
+  CHECK(nrxchars + m1.overruns == sizeof buf);
+  return true;
+}
+
+/* Stopping a transmission suppresses its callbacks.*/
+static bool test_stop_send(void) {
+  uint8_t tx[32];
+  size_t rem;
+
+  modelLink(&m1, &m1);
+  iuartStart(&IUARTD1, &cfg_default);
+  fill(tx, sizeof tx, 5);
+  iuartStartSend(&IUARTD1, sizeof tx, tx);
+  simRun(8 * FRAME);
+  rem = iuartStopSend(&IUARTD1);
+  CHECK((rem > 0) && (rem < sizeof tx));
+  simRun(4 * FRAME);
+  CHECK(strchr(trace, 'T') == NULL);
+  CHECK(m1.txframes + rem <= sizeof tx);
+  return true;
+}
+
+/* Nine bit data frames use uint16_t buffers.*/
+static bool test_wide(void) {
+  static const uint16_t tx[4] = {0x1FF, 0x100, 0x0AA, 0x155};
+  uint16_t rx[4];
+  IUARTConfig cfg = cfg_default;
+
+  cfg.cr1 = USART_CR1_M0;
+  modelLink(&m1, &m1);
+  iuartStart(&IUARTD1, &cfg);
+  iuartStartReceive(&IUARTD1, 4, rx);
+  iuartStartSend(&IUARTD1, 4, tx);
+  CHECK(simRunUntil(traced, "E", 8 * 11));
+  CHECK(memcmp(tx, rx, sizeof tx) == 0);
+  return true;
+}
+
+/* Rounded divider, oversampling by 8 above the kernel clock over 16.*/
+static uint32_t brr_baud(void) {
+  uint32_t div = USART1->BRR;
+
+  /* The divider the hardware decodes, see the reference manual.*/
+  if (USART1->CR1 & USART_CR1_OVER8)
+    div = ((div & 0xFFF0) | ((div & 7) << 1)) / 2;
+  return (STM32_PCLK2 + div / 2) / div;
+}
+
+static bool test_baud(void) {
+  IUARTConfig cfg = cfg_default;
+  int32_t err;
+
+  iuartStart(&IUARTD1, &cfg);
+  CHECK((USART1->BRR == 625) && ((USART1->CR1 & USART_CR1_OVER8) == 0));
+  CHECK((iuartGetBaudRate(&IUARTD1, &err) == 115200) && (err == 0));
+  iuartStop(&IUARTD1);
+
+  cfg.speed = 4500000;
+  iuartStart(&IUARTD1, &cfg);
+  CHECK((USART1->BRR == 16) && ((USART1->CR1 & USART_CR1_OVER8) == 0));
+  iuartStop(&IUARTD1);
+
+  /* 72 MHz / 6.5 Mbaud is 11.08, the closest divider is 11.*/
+  cfg.speed = 6500000;
+  iuartStart(&IUARTD1, &cfg);
+  CHECK((USART1->BRR == 0x13) && ((USART1->CR1 & USART_CR1_OVER8) != 0));
+  CHECK((iuartGetBaudRate(&IUARTD1, &err) == 6545455) && (err == 6993));
+  CHECK(iuartGetBaudRate(&IUARTD1, NULL) == brr_baud());
+  iuartStop(&IUARTD1);
+
+  /* 72 MHz / 7 Mbaud is 10.29, the closest divider is 10.*/
+  cfg.speed = 7000000;
+  iuartStart(&IUARTD1, &cfg);
+  CHECK((USART1->BRR == 0x12) && ((USART1->CR1 & USART_CR1_OVER8) != 0));
+  CHECK((iuartGetBaudRate(&IUARTD1, &err) == 7200000) && (err == 28571));
+  CHECK(iuartGetBaudRate(&IUARTD1, NULL) == brr_baud());
+  iuartStop(&IUARTD1);
+
+  cfg.speed = 921600;
+  cfg.cr1   = USART_CR1_OVER8;
+  iuartStart(&IUARTD1, &cfg);
+  CHECK((USART1->BRR == 0x96) && ((USART1->CR1 & USART_CR1_OVER8) != 0));
+  CHECK((iuartGetBaudRate(&IUARTD1, NULL) == 923077) &&
+        (brr_baud() == 923077));
+  return true;
+}
+
+#if IUART_USE_RXRING
+/* Ring reader woken by threshold and by idle line.*/
+static bool test_ring(void) {
+  static uint8_t ring[64];
+  uint8_t tx[100], rx[100];
+  size_t got = 0;
+  IUARTConfig cfg = cfg_default;
+
+  cfg.rxring      = ring;
+  cfg.rxring_size = sizeof ring;
+  cfg.rxthreshold = 16;
+  iuartStart(&IUARTD1, &cfg);
+  fill(tx, sizeof tx, 9);
+  modelInjectBytes(&m1, tx, sizeof tx);
+  while (got < sizeof rx) {
+    size_t n = iuartRead(&IUARTD1, rx + got, sizeof rx - got, 10);
+    CHECK(n > 0);
+    got += n;
+  }
+  CHECK(memcmp(tx, rx, sizeof tx) == 0);
+  CHECK(iuartRead(&IUARTD1, rx, 1, 5) == 0);
+  CHECK(nrxchars == 0);
+  return true;
+}
+#endif
+
+#if IUART_USE_RXRING && IUART_USE_TXQUEUE
+/* Queued writes waiting for space, received through a ring.*/
+static bool test_queue(void) {
+  static uint8_t txring[64], rxring[512];
+  uint8_t tx[300], rx[300];
+  size_t got = 0;
+  IUARTConfig cfg1 = cfg_default, cfg2 = cfg_default;
+
+  cfg1.txring      = txring;
+  cfg1.txring_size = sizeof txring;
+  cfg2.rxring      = rxring;
+  cfg2.rxring_size = sizeof rxring;
+  cfg2.rxthreshold = 1;
+  modelLink(&m1, &m2);
+  iuartStart(&IUARTD1, &cfg1);
+  iuartStart(&IUARTD2, &cfg2);
+  fill(tx, sizeof tx, 11);
+  CHECK(iuartWrite(&IUARTD1, tx, sizeof tx) == sizeof txring);
+  CHECK(iuartWriteTimeout(&IUARTD1, tx + sizeof txring,
+                          sizeof tx - sizeof txring, TIME_INFINITE) ==
+        sizeof tx - sizeof txring);
+  while (got < sizeof rx) {
+    size_t n = iuartRead(&IUARTD2, rx + got, sizeof rx - got, 100);
+    CHECK(n > 0);
+    got += n;
+  }
+  CHECK(memcmp(tx, rx, sizeof tx) == 0);
+  CHECK(iuartWriteSpace(&IUARTD1) == sizeof txring);
+  return true;
+}
+#endif
+
+#if IUART_USE_FRAMING
+/* Block receive ended by receiver timeout and by delimiter.*/
+static bool test_framing(void) {
+  static const uint8_t msg[] = "ab\ncd";
+  uint8_t rx[32];
+  IUARTConfig cfg = cfg_default;
+
+  cfg.rxframe_cb = rxframe;
+  cfg.rto        = 20;
+  iuartStart(&IUARTD1, &cfg);
+  iuartStartReceive(&IUARTD1, sizeof rx, rx);
+  modelInjectBytes(&m1, msg, 2);
+  CHECK(simRunUntil(traced, "F", 10 * FRAME));
+  CHECK((framelen == 2) && (memcmp(rx, "ab", 2) == 0));
+
+  setup();
+  cfg.rto   = 0;
+  cfg.match = IUART_MATCH('\n');
+  iuartStart(&IUARTD1, &cfg);
+  iuartStartReceive(&IUARTD1, sizeof rx, rx);
+  modelInjectBytes(&m1, msg, 5);
+  CHECK(simRunUntil(traced, "F", 10 * FRAME));
+  CHECK((framelen == 3) && (memcmp(rx, "ab\n", 3) == 0));
+  simRun(4 * FRAME);
+  CHECK(nrxchars == 2);
+  return true;
+}
+#endif
+
+#if IUART_USE_MODBUS
+/* Frames ended by t3.5, damaged ones dropped with the receive kept armed.*/
+static bool test_modbus(void) {
+  uint8_t frame[8] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x0A};
+  uint8_t rx[256];
+  uint16_t crc = iuartModbusCRC(frame, 6);
+  IUARTConfig cfg = cfg_default;
+
+  frame[6] = (uint8_t)crc;
+  frame[7] = (uint8_t)(crc >> 8);
+  cfg.speed      = 19200;
+  cfg.rxframe_cb = rxframe;
+  cfg.modbus     = true;
+  iuartStart(&IUARTD1, &cfg);
+  CHECK(USART1->RTOR == 39);
+  iuartStartReceive(&IUARTD1, sizeof rx, rx);
+
+  /* Corrupted frame.*/
+  frame[2] ^= 0x10;
+  modelInjectBytes(&m1, frame, sizeof frame);
+  CHECK(simRunUntil(traced, "x", 8 * FRAME + 50));
+  CHECK(rxerrors == IUART_CRC_ERROR);
+  CHECK(IUARTD1.rxstate == IUART_RX_ACTIVE);
+
+  /* Good frame into the same buffer.*/
+  frame[2] ^= 0x10;
+  modelInjectBytes(&m1, frame, sizeof frame);
+  CHECK(simRunUntil(traced, "F", 8 * FRAME + 50));
+  CHECK((framelen == 6) && (memcmp(rx, frame, 6) == 0));
+  CHECK(strcmp(trace, "xF") == 0);
+  CHECK(iuartModbusCRC(frame, sizeof frame) == 0);
+  return true;
+}
+#endif
+
+#if IUART_USE_CRC
+/* Catalogue check values, running CRC in both directions and appended.*/
+static bool test_crc(void) {
+  static iuartcrc_t crc32, xmodem;
+  static const uint8_t check[] = "123456789";
+  uint8_t rx[9];
+  IUARTConfig cfg = cfg_default;
+
+  iuartCRCObjectInit(&crc32, 32, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true);
+  iuartCRCObjectInit(&xmodem, 16, 0x1021, 0, 0, false);
+  CHECK(iuartCRC(&crc32, check, 9) == 0xCBF43926);
+  CHECK(iuartCRC(&xmodem, check, 9) == 0x31C3);
+
+  cfg.crc       = &crc32;
+  cfg.crcappend = true;
+  modelLink(&m1, &m1);
+  iuartStart(&IUARTD1, &cfg);
+  iuartStartReceive(&IUARTD1, sizeof rx, rx);
+  iuartStartSend(&IUARTD1, 9, check);
+  CHECK(simRunUntil(traced, "E", 16 * FRAME));
+  CHECK(iuartGetTxCRC(&IUARTD1) == 0xCBF43926);
+  CHECK(iuartGetRxCRC(&IUARTD1) == 0xCBF43926);
+  CHECK(m1.txframes == 13);
+  CHECK((nrxchars == 4) && (rxchars[0] == 0x26) && (rxchars[3] == 0xCB));
+  CHECK(strcmp(trace, "RccTccE") == 0);
+
+  /* Non reflected CRCs go out high byte first.*/
+  setup();
+  cfg.crc = &xmodem;
+  modelLink(&m1, &m1);
+  iuartStart(&IUARTD1, &cfg);
+  iuartStartSend(&IUARTD1, 9, check);
+  CHECK(simRunUntil(traced, "E", 16 * FRAME));
+  CHECK((nrxchars == 11) && (rxchars[9] == 0x31) && (rxchars[10] == 0xC3));
+  return true;
+}
+#endif
+
+#if IUART_USE_BRIDGE
+static void flow(IUARTDriver *iuartp, bool stop) {
+
+  (void)iuartp;
+  note(stop ? 'S' : 'G');
+}
+
+/* Forwarding into a slower port, with flow control notifications.*/
+static bool test_bridge(void) {
+  static uint8_t txring[64];
+  uint8_t tx[120];
+  uint16_t sent[120];
+  size_t i;
+  IUARTConfig cfg1 = cfg_default, cfg2 = cfg_default;
+
+  cfg1.bridge       = &IUARTD2;
+  cfg1.bridge_hiwat = 8;
+  cfg1.bridge_lowat = 2;
+  cfg1.flow_cb      = flow;
+  cfg2.txend1_cb    = NULL;
+  cfg2.txend2_cb    = NULL;
+  cfg2.txring       = txring;
+  cfg2.txring_size  = sizeof txring;
+  cfg2.cr1          = USART_CR1_M0 | USART_CR1_PCE;   /* 12 bit frames.*/
+  cfg2.cr2          = USART_CR2_STOP_1;
+  iuartStart(&IUARTD2, &cfg2);
+  iuartStart(&IUARTD1, &cfg1);
+  fill(tx, sizeof tx, 31);
+  modelInjectBytes(&m1, tx, sizeof tx);
+  simRun(sizeof tx * 12 + 4 * FRAME);
+  CHECK(modelGetSent(&m2, sent, sizeof tx) == sizeof tx);
+  for (i = 0; i < sizeof tx; i++)
+    CHECK(sent[i] == tx[i]);
+  CHECK(strcmp(trace, "SG") == 0);
+  CHECK(nrxchars == 0);
+  CHECK(IUARTD2.bridgefrom == &IUARTD1);
+  iuartStop(&IUARTD1);
+  CHECK(IUARTD2.bridgefrom == NULL);
+  return true;
+}
+#endif
+
+#if IUART_USE_MUTE
+/* Only the own address wakes the receiver, idle line wakeup on request.*/
+static bool test_mute(void) {
+  static const uint16_t bus[] = {0x103, 0x11, 0x12, 0x105, 0x21, 0x22,
+                                 0x107, 0x31, 0x32};
+  static const uint8_t burst[] = "abcdefgh";
+  IUARTConfig cfg = cfg_default;
+
+  cfg.cr1     = USART_CR1_M0;
+  cfg.mute    = IUART_MUTE_ADDRESS;
+  cfg.address = 5;
+  iuartStart(&IUARTD1, &cfg);
+  modelInject(&m1, bus, 9, 0);
+  simRun(11 * 11);
+  CHECK((nrxchars == 3) && (rxchars[0] == 0x105) && (rxchars[1] == 0x21) &&
+        (rxchars[2] == 0x22));
+  CHECK(m1.isrcalls == 3);
+
+  /* Idle line wakeup, the second burst is skipped on request.*/
+  setup();
+  cfg.cr1  = 0;
+  cfg.mute = IUART_MUTE_IDLE;
+  iuartStart(&IUARTD1, &cfg);
+  modelInjectBytes(&m1, burst, 2);
+  simRun(4 * FRAME);
+  CHECK(nrxchars == 0);
+  modelInjectBytes(&m1, burst + 2, 2);
+  simRun(4 * FRAME);
+  CHECK((nrxchars == 2) && (rxchars[0] == 'c'));
+  iuartMute(&IUARTD1);
+  modelInjectBytes(&m1, burst + 4, 2);
+  simRun(4 * FRAME);
+  modelInjectBytes(&m1, burst + 6, 2);
+  simRun(4 * FRAME);
+  CHECK((nrxchars == 4) && (rxchars[2] == 'g') && (rxchars[3] == 'h'));
+  return true;
+}
+#endif
+
+#if IUART_USE_RXCHAIN
+/* Queued buffers fill back to back, the line is never left unserviced.*/
+static bool test_rxchain(void) {
+  static iuartrxdesc_t chain[4];
+  static uint8_t bufs[3][8];
+  uint8_t tx[64];
+  void *bp;
+  size_t i, n;
+  IUARTConfig cfg = cfg_default;
+
+  cfg.rxchain      = chain;
+  cfg.rxchain_size = 4;
+  iuartStart(&IUARTD1, &cfg);
+  fill(tx, sizeof tx, 7);
+  for (i = 0; i < 3; i++)
+    CHECK(iuartQueueReceive(&IUARTD1, 8, bufs[i]));
+  modelInjectBytes(&m1, tx, 30);
+  simRun(34 * FRAME);
+  for (i = 0; i < 3; i++) {
+    n = iuartFetchReceive(&IUARTD1, &bp, TIME_IMMEDIATE);
+    CHECK((n == 8) && (bp == bufs[i]) && (memcmp(bp, tx + i * 8, 8) == 0));
+  }
+  CHECK(iuartFetchReceive(&IUARTD1, &bp, TIME_IMMEDIATE) == 0);
+  CHECK((nrxchars == 6) && (rxchars[0] == tx[24]));
+  CHECK(strcmp(trace, "RRRcccccc") == 0);
+
+  /* Continuous stream through two buffers recycled by the thread.*/
+  setup();
+  cfg.rxend_cb = NULL;
+  iuartStart(&IUARTD1, &cfg);
+  CHECK(iuartQueueReceive(&IUARTD1, 8, bufs[0]));
+  CHECK(iuartQueueReceive(&IUARTD1, 8, bufs[1]));
+  modelInjectBytes(&m1, tx, sizeof tx);
+  for (i = 0; i < sizeof tx / 8; i++) {
+    n = iuartFetchReceive(&IUARTD1, &bp, 20 * FRAME);
+    CHECK((n == 8) && (memcmp(bp, tx + i * 8, 8) == 0));
+    CHECK(iuartQueueReceive(&IUARTD1, 8, bp));
+  }
+  CHECK(IUARTD1.rxstate == IUART_RX_ACTIVE);
+  CHECK((nrxchars == 0) && (m1.overruns == 0));
+  return true;
+}
+#endif
+
+#if IUART_USE_TXPRIO
+static void txurgent(IUARTDriver *iuartp) {
+
+  (void)iuartp;
+  note('U');
+}
+
+/* Urgent messages go out at the next block boundary, the block resumes.*/
+static bool test_txprio(void) {
+  static const uint8_t urgent[] = "XYZ";
+  uint8_t tx[40];
+  uint16_t sent[43];
+  size_t i, p;
+  IUARTConfig cfg = cfg_default;
+
+  cfg.txprio_frames = 8;
+  cfg.txurgent_cb   = txurgent;
+  iuartStart(&IUARTD1, &cfg);
+  fill(tx, sizeof tx, 3);
+  iuartStartSend(&IUARTD1, sizeof tx, tx);
+  simRun(3 * FRAME);
+  CHECK(iuartStartSendUrgent(&IUARTD1, 3, urgent));
+  CHECK(!iuartStartSendUrgent(&IUARTD1, 3, urgent));
+  CHECK(simRunUntil(traced, "E", 50 * FRAME));
+  CHECK(modelGetSent(&m1, sent, 43) == 43);
+  for (i = 0; i < 43; i++)
+    CHECK(sent[i] == (i < 8 ? tx[i] : i < 11 ? urgent[i - 8] : tx[i - 3]));
+  CHECK(strcmp(trace, "UTE") == 0);
+
+  /* Any data frame is a boundary, the latency is the frames in flight.
+     With DMA the block goes in one transfer and the message follows.*/
+  setup();
+  cfg.txprio_frames = 0;
+  iuartStart(&IUARTD1, &cfg);
+  iuartStartSend(&IUARTD1, sizeof tx, tx);
+  simRun(3 * FRAME);
+  CHECK(iuartStartSendUrgent(&IUARTD1, 3, urgent));
+  CHECK(simRunUntil(traced, "E", 50 * FRAME));
+  CHECK(modelGetSent(&m1, sent, 43) == 43);
+  for (p = 0; (p < 43) && (sent[p] != 'X'); p++)
+    ;
+#if TX_DMA
+  CHECK(p == sizeof tx);
+#else
+  CHECK(p <= 5);
+#endif
+  CHECK((sent[p + 1] == 'Y') && (sent[p + 2] == 'Z'));
+  for (i = 0; i < 43; i++)
+    CHECK((i - p < 3) || (sent[i] == tx[i < p ? i : i - 3]));
+  return true;
+}
+#endif
+
+#if IUART_USE_FLOWCTL
+static void rts(IUARTDriver *iuartp, bool stop) {
+
+  (iuartp == &IUARTD1 ? &m1 : &m2)->rtsoff = stop;
+  note(stop ? 'S' : 'G');
+}
+
+/* A slow reader stops the sender instead of losing data, in both modes.*/
+static bool test_flowctl(void) {
+  static uint8_t ring[64];
+  uint8_t tx[200], rx[200];
+  size_t got, n;
+  uint8_t mode;
+  IUARTConfig cfg1 = cfg_default, cfg2 = cfg_default;
+
+  cfg1.rxring      = ring;
+  cfg1.rxring_size = sizeof ring;
+  /* The DMA ring is only looked at when half and fully written.*/
+  cfg1.rx_hiwat    = RX_DMA ? 32 : 48;
+  cfg1.rx_lowat    = 16;
+  cfg1.rts_cb      = rts;
+  cfg2.rts_cb      = rts;
+  fill(tx, sizeof tx, 17);
+  for (mode = IUART_FLOW_RTSCTS; mode <= IUART_FLOW_SWRTS; mode++) {
+    setup();
+    cfg1.flow = mode;
+    cfg2.flow = mode;
+    modelLink(&m1, &m2);
+    iuartStart(&IUARTD1, &cfg1);
+    iuartStart(&IUARTD2, &cfg2);
+    iuartStartSend(&IUARTD2, sizeof tx, tx);
+    simRun(100 * FRAME);
+    CHECK((m1.rxframes <= 50) && (m1.overruns == 0));
+    for (got = 0; got < sizeof rx; got += n) {
+      n = iuartRead(&IUARTD1, rx + got, sizeof rx - got, 20);
+      CHECK(n > 0);
+    }
+    CHECK(memcmp(tx, rx, sizeof tx) == 0);
+    CHECK(m1.overruns == 0);
+  }
+  CHECK(strncmp(trace, "GGS", 3) == 0);
+  return true;
+}
+#endif
+
+#if IUART_USE_TIMESTAMP
+/* The stamps bracket the data frames of each block receive.*/
+static bool test_timestamp(void) {
+  uint8_t tx[8], rx[8];
+  iuartstamp_t ts;
+  unsigned long t0;
+  IUARTConfig cfg = cfg_default;
+
+  cfg.timestamp = true;
+  iuartStart(&IUARTD1, &cfg);
+  fill(tx, sizeof tx, 19);
+  iuartStartReceive(&IUARTD1, sizeof rx, rx);
+  t0 = simNow();
+  modelInjectBytes(&m1, tx, sizeof tx);
+  CHECK(simRunUntil(traced, "R", 10 * FRAME));
+  iuartGetRxTimestamp(&IUARTD1, &ts);
+  CHECK((ts.start > t0) && (ts.start <= t0 + 2 * FRAME));
+  CHECK((ts.end - ts.start >= 7 * FRAME) && (ts.end - ts.start < 8 * FRAME));
+
+  /* The next block is stamped from its own first frame.*/
+  simRun(5 * FRAME);
+  iuartStartReceive(&IUARTD1, 2, rx);
+  t0 = simNow();
+  modelInjectBytes(&m1, tx, 2);
+  CHECK(simRunUntil(traced, "RR", 4 * FRAME));
+  iuartGetRxTimestamp(&IUARTD1, &ts);
+  CHECK((ts.start > t0) && (ts.start <= t0 + 2 * FRAME));
+  CHECK((ts.end - ts.start >= FRAME) && (ts.end - ts.start < 2 * FRAME));
+
+#if RX_DMA
+  /* The first data frame interrupt hands the receiver over to the DMA.*/
+  setup();
+  iuartStart(&IUARTD1, &cfg);
+  memset(rx, 0, sizeof rx);
+  iuartStartReceive(&IUARTD1, sizeof rx, rx);
+  CHECK((USART1->CR3 & USART_CR3_DMAR) == 0);
+  modelInjectBytes(&m1, tx, sizeof tx);
+  simRun(2 * FRAME);
+  CHECK((USART1->CR3 & USART_CR3_DMAR) != 0);
+  CHECK((USART1->CR1 & USART_CR1_RXNEIE) == 0);
+  CHECK(simRunUntil(traced, "R", 8 * FRAME));
+  CHECK(memcmp(tx, rx, sizeof rx) == 0);
+  CHECK((m1.isrcalls == 1) && (m1.overruns == 0));
+
+  /* Other ports leave the data frames to the DMA from the start.*/
+  setup();
+  iuartStart(&IUARTD1, &cfg_default);
+  memset(rx, 0, sizeof rx);
+  iuartStartReceive(&IUARTD1, sizeof rx, rx);
+  CHECK((USART1->CR3 & USART_CR3_DMAR) != 0);
+  modelInjectBytes(&m1, tx, sizeof tx);
+  CHECK(simRunUntil(traced, "R", 10 * FRAME));
+  CHECK(memcmp(tx, rx, sizeof rx) == 0);
+  CHECK(m1.isrcalls == 0);
+#endif
+  return true;
+}
+#endif
+
+#if IUART_USE_DEFERRED
+/* Callbacks run from the dispatcher, lost events are reported.*/
+static bool test_deferred(void) {
+  static iuartevent_t evq[16];
+  uint8_t tx[8], rx[8];
+  IUARTConfig cfg = cfg_default;
+
+  cfg.evq      = evq;
+  cfg.evq_size = 16;
+  modelLink(&m1, &m1);
+  iuartStart(&IUARTD1, &cfg);
+  fill(tx, sizeof tx, 13);
+  iuartStartReceive(&IUARTD1, sizeof rx, rx);
+  iuartStartSend(&IUARTD1, sizeof tx, tx);
+  CHECK(simRunUntil(tx_idle, &IUARTD1, 4 * sizeof tx * FRAME));
+  CHECK(tracelen == 0);
+  CHECK(iuartDispatch(&IUARTD1, TIME_IMMEDIATE) == MSG_OK);
+  CHECK(strcmp(trace, "TRE") == 0);
+  CHECK(iuartDispatch(&IUARTD1, 2) == MSG_TIMEOUT);
+
+  /* More characters than queue slots.*/
+  fill(tx, sizeof tx, 17);
+  modelInjectBytes(&m1, tx, 8);
+  modelInjectBytes(&m1, tx, 8);
+  modelInjectBytes(&m1, tx, 8);
+  simRun(26 * FRAME);
+  CHECK(iuartDispatch(&IUARTD1, TIME_IMMEDIATE) == MSG_OK);
+  CHECK(nrxchars == 16);
+  CHECK(rxerrors == IUART_EVENT_LOST);
+  iuartStop(&IUARTD1);
+  CHECK(iuartDispatch(&IUARTD1, TIME_INFINITE) == MSG_RESET);
+  return true;
+}
+#endif
+
+#if IUART_USE_CHANNEL
+/* Stream interface between two linked ports.*/
+static bool test_channel(void) {
+  static uint8_t txring[16], rxring[64];
+  static const uint8_t msg[] = "the quick brown fox";
+  uint8_t rx[sizeof msg];
+  IUARTConfig cfg = cfg_default;
+
+  cfg.rxchar_cb   = NULL;
+  cfg.txring      = txring;
+  cfg.txring_size = sizeof txring;
+  cfg.rxring      = rxring;
+  cfg.rxring_size = sizeof rxring;
+  cfg.rxthreshold = 4;
+  modelLink(&m1, &m2);
+  iuartStart(&IUARTD1, &cfg);
+  iuartStart(&IUARTD2, &cfg);
+  CHECK(IUARTD1.vmt->writet(&IUARTD1, msg, sizeof msg, TIME_INFINITE) ==
+        sizeof msg);
+  CHECK(IUARTD2.vmt->readt(&IUARTD2, rx, sizeof rx, 50) == sizeof rx);
+  CHECK(memcmp(msg, rx, sizeof msg) == 0);
+  CHECK(IUARTD2.vmt->gett(&IUARTD2, 5) == MSG_TIMEOUT);
+  CHECK(IUARTD2.vmt->put(&IUARTD2, 'z') == MSG_OK);
+  CHECK(IUARTD1.vmt->get(&IUARTD1) == 'z');
+  return true;
+}
+#endif
+
+#if IUART_USE_RS485
+/* Hardware driver enable, no end of transmission interrupt.*/
+static bool test_rs485(void) {
+  uint8_t tx[4];
+  IUARTConfig cfg = cfg_default;
+
+  cfg.txend2_cb = NULL;
+  cfg.rs485     = true;
+  cfg.deat      = 8;
+  cfg.dedt      = 4;
+  iuartStart(&IUARTD1, &cfg);
+  CHECK(USART1->CR3 & USART_CR3_DEM);
+  CHECK((USART1->CR1 & USART_CR1_DEAT) == (8U << 21));
+  CHECK((USART1->CR1 & USART_CR1_DEDT) == (4U << 16));
+  fill(tx, sizeof tx, 19);
+  iuartStartSend(&IUARTD1, sizeof tx, tx);
+  CHECK(simRunUntil(traced, "T", 6 * FRAME));
+  CHECK((USART1->CR1 & USART_CR1_TCIE) == 0);
+  simRun(6 * FRAME);
+  CHECK(m1.txframes == sizeof tx);
+  return true;
+}
+#endif
+
+#if IUART_USE_STATS
+/* Counters against the model.*/
+static bool test_stats(void) {
+  iuartstats_t st;
+  uint8_t buf[20];
+
+  iuartStart(&IUARTD1, &cfg_default);
+  iuartResetStats(&IUARTD1);
+  m1.latency = 15;
+  fill(buf, sizeof buf, 23);
+  modelInjectBytes(&m1, buf, sizeof buf);
+  simRun((sizeof buf + 4) * FRAME);
+  iuartGetStats(&IUARTD1, &st);
+  CHECK(st.rxbytes == nrxchars);
+  CHECK(st.overrun > 0);
+  CHECK(st.isrcount == m1.isrcalls);
+  return true;
+}
+#endif
+
+#if IUART_USE_RXRING && IUART_USE_TXQUEUE
+/* Echo through a pty, the slave side plays the remote device.*/
+static bool test_pty(void) {
+  static uint8_t txring[64], rxring[64];
+  IUARTConfig cfg = cfg_default;
+  struct termios tio;
+  uint8_t buf[16];
+  size_t got = 0;
+  int master, slave;
+
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if ((master < 0) || (grantpt(master) != 0) || (unlockpt(master) != 0)) {
+    printf("  no pty, skipped\n");
+    return true;
+  }
+  slave = open(ptsname(master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  CHECK(slave >= 0);
+  tcgetattr(slave, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  fcntl(master, F_SETFL, O_NONBLOCK);
+
+  cfg.rxchar_cb   = NULL;
+  cfg.txring      = txring;
+  cfg.txring_size = sizeof txring;
+  cfg.rxring      = rxring;
+  cfg.rxring_size = sizeof rxring;
+  cfg.rxthreshold = 4;
+  m1.fd = master;
+  iuartStart(&IUARTD1, &cfg);
+  CHECK(write(slave, "ping", 4) == 4);
+  while (got < 4) {
+    size_t n = iuartRead(&IUARTD1, buf + got, sizeof buf - got, 20);
+    CHECK(n > 0);
+    got += n;
+  }
+  CHECK(iuartWriteTimeout(&IUARTD1, buf, got, TIME_INFINITE) == got);
+  simRun(6 * FRAME);
+  CHECK(read(slave, buf, sizeof buf) == 4);
+  CHECK(memcmp(buf, "ping", 4) == 0);
+
+  iuartStop(&IUARTD1);
+  m1.fd = -1;
+  close(slave);
+  close(master);
+  return true;
+}
+#endif
+
+static const struct {
+  const char    *name;
+  bool          (*fn)(void);
+} tests[] = {
+  {"block_loopback", test_block_loopback},
+  {"rxchar",         test_rxchar},
+  {"errors",         test_errors},
+  {"overrun",        test_overrun},
+  {"stop_send",      test_stop_send},
+  {"wide",           test_wide},
+  {"baud",           test_baud},
+#if IUART_USE_RXRING
+  {"ring",           test_ring},
+#endif
+#if IUART_USE_RXRING && IUART_USE_TXQUEUE
+  {"queue",          test_queue},
+  {"pty",            test_pty},
+#endif
+#if IUART_USE_FRAMING
+  {"framing",        test_framing},
+#endif
+#if IUART_USE_MODBUS
+  {"modbus",         test_modbus},
+#endif
+#if IUART_USE_CRC
+  {"crc",            test_crc},
+#endif
+#if IUART_USE_BRIDGE
+  {"bridge",         test_bridge},
+#endif
+#if IUART_USE_MUTE
+  {"mute",           test_mute},
+#endif
+#if IUART_USE_RXCHAIN
+  {"rxchain",        test_rxchain},
+#endif
+#if IUART_USE_TXPRIO
+  {"txprio",         test_txprio},
+#endif
+#if IUART_USE_FLOWCTL
+  {"flowctl",        test_flowctl},
+#endif
+#if IUART_USE_TIMESTAMP
+  {"timestamp",      test_timestamp},
+#endif
+#if IUART_USE_DEFERRED
+  {"deferred",       test_deferred},
+#endif
+#if IUART_USE_CHANNEL
+  {"channel",        test_channel},
+#endif
+#if IUART_USE_RS485
+  {"rs485",          test_rs485},
+#endif
+#if IUART_USE_STATS
+  {"stats",          test_stats},
+#endif
+};
+
+/*===========================================================================*/
+/* Benchmark.                                                                */
+/*===========================================================================*/
+
+static int perf_fd = -1;
+static struct timespec isr_t0;
+static uint64_t isr_ns;
+
+static void probe(bool enter) {
+  struct timespec t;
+
+  if (perf_fd >= 0) {
+    ioctl(perf_fd, enter ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+    return;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  if (enter)
+    isr_t0 = t;
+  else
+    isr_ns += (uint64_t)(t.tv_sec - isr_t0.tv_sec) * 1000000000U +
+              (uint64_t)t.tv_nsec - (uint64_t)isr_t0.tv_nsec;
+}
+
+static uint64_t probe_count(void) {
+  uint64_t n = 0;
+
+  if (perf_fd >= 0) {
+    if (read(perf_fd, &n, sizeof n) != sizeof n)
+      n = 0;
+    ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+    return n;
+  }
+  n = isr_ns;
+  isr_ns = 0;
+  return n;
+}
+
+static void perf_open(void) {
+  struct perf_event_attr pe;
+
+  memset(&pe, 0, sizeof pe);
+  pe.type           = PERF_TYPE_HARDWARE;
+  pe.size           = sizeof pe;
+  pe.config         = PERF_COUNT_HW_INSTRUCTIONS;
+  pe.disabled       = 1;
+  pe.exclude_kernel = 1;
+  pe.exclude_hv     = 1;
+  perf_fd = (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+static void report(const char *name, size_t bytes, unsigned long isrs,
+                   uint64_t cost, uint64_t overhead) {
+  const char *unit = perf_fd >= 0 ? "instructions" : "ns";
+  double per_isr = isrs ? (double)cost / isrs - (double)overhead : 0.0;
+
+  printf("%-16s %8zu bytes %8lu ISRs %6.2f ISR/byte %8.1f %s/ISR"
+         " %8.1f %s/byte\n",
+         name, bytes, isrs, (double)isrs / bytes, per_isr, unit,
+         per_isr * isrs / bytes, unit);
+}
+
+static int bench(void) {
+  static uint8_t tx[1024], rx[1024];
+  uint64_t overhead;
+  unsigned long isrs;
+  unsigned i;
+
+  perf_open();
+  simSetProbe(probe);
+
+  /* Cost of the probe itself.*/
+  for (i = 0; i < 1000; i++) {
+    probe(true);
+    probe(false);
+  }
+  overhead = probe_count() / 1000;
+
+  setup();
+  modelLink(&m1, &m1);
+  iuartStart(&IUARTD1, &cfg_default);
+  fill(tx, sizeof tx, 29);
+  for (i = 0; i < 16; i++) {
+    tracelen = 0;
+    trace[0] = '\0';
+    iuartStartReceive(&IUARTD1, sizeof rx, rx);
+    iuartStartSend(&IUARTD1, sizeof tx, tx);
+    if (!simRunUntil(traced, "E", 2 * sizeof tx * FRAME))
+      return 1;
+  }
+  isrs = m1.isrcalls;
+  report("block", 16 * sizeof tx, isrs, probe_count(), overhead);
+
+#if IUART_USE_RXRING && IUART_USE_TXQUEUE
+  {
+    static uint8_t txring[256], rxring[256];
+    IUARTConfig cfg = cfg_default;
+    size_t got = 0;
+
+    cfg.rxchar_cb   = NULL;
+    cfg.txring      = txring;
+    cfg.txring_size = sizeof txring;
+    cfg.rxring      = rxring;
+    cfg.rxring_size = sizeof rxring;
+    cfg.rxthreshold = 64;
+    setup();
+    modelLink(&m1, &m2);
+    iuartStart(&IUARTD1, &cfg);
+    iuartStart(&IUARTD2, &cfg);
+    (void)probe_count();
+    for (i = 0; i < 16; i++) {
+      size_t put = 0;
+      while (put < sizeof tx) {
+        put += iuartWriteTimeout(&IUARTD1, tx + put, sizeof tx - put,
+                                 TIME_IMMEDIATE);
+        got += iuartRead(&IUARTD2, rx, sizeof rx, 1);
+      }
+    }
+    while (got < 16 * sizeof tx) {
+      size_t n = iuartRead(&IUARTD2, rx, sizeof rx, 10);
+      if (n == 0)
+        return 1;
+      got += n;
+    }
+    report("ring+queue", got, m1.isrcalls + m2.isrcalls, probe_count(),
+           overhead);
+  }
+#endif
+
+  setup();
+  simSetProbe(NULL);
+  return 0;
+}
+
+/*===========================================================================*/
+/* Entry point.                                                              */
+/*===========================================================================*/
+
+int main(int argc, char *argv[]) {
+  int failures = 0;
+  size_t i;
+
+  iuartInit();
+  modelInit(&m1, "USART1", USART1, STM32_USART1_NUMBER, Vector_USART1);
+  modelInit(&m2, "USART2", USART2, STM32_USART2_NUMBER, Vector_USART2);
+  simAdd(&m1);
+  simAdd(&m2);
+
+  if ((argc > 1) && (strcmp(argv[1], "-b") == 0))
+    return bench();
+
+  for (i = 0; i < sizeof tests / sizeof tests[0]; i++) {
+    bool ok;
+
+    setup();
+    ok = tests[i].fn();
+    printf("%s %s\n", ok ? "PASS" : "FAIL", tests[i].name);
+    if (!ok)
+      failures++;
+  }
+  setup();
+  printf("%d of %zu tests failed\n", failures, sizeof tests / sizeof tests[0]);
+  return failures;
+}
+
+/** @} */
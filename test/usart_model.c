@@ -0,0 +1,788 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/usart_model.c
+ * @brief   Host model of the STM32 USARTv2 peripheral.
+ * @details The line is driven by a virtual bit clock, one call to
+ *          @p simTick() advances every registered USART by one bit time
+ *          and moves a data item on each DMA stream with a request.
+ *          Frames travel between linked models, from the harness through
+ *          @p modelInject() or from a host descriptor such as a pty. Other
+ *          peripherals join the clock and the DMA through @p simAddDevice().
+ *
+ * @addtogroup IUART_HOST
+ * @{
+ */
+
+#include <unistd.h>
+
+#include "hal.h"
+#include "usart_model.h"
+
+/*===========================================================================*/
+/* Model local definitions.                                                  */
+/*===========================================================================*/
+
+#define MODEL_MAX               4
+#define DEVICE_MAX              4
+
+/* Flags cleared through ICR.*/
+#define ICR_MASK                (USART_ISR_PE | USART_ISR_FE | USART_ISR_NE | \
+                                 USART_ISR_ORE | USART_ISR_IDLE |            \
+                                 USART_ISR_TC | USART_ISR_LBDF |             \
+                                 USART_ISR_CTSIF | USART_ISR_RTOF |          \
+                                 USART_ISR_CMF)
+
+/* Receive errors, in the upper half of the injected characters.*/
+#define RX_ERRORS               (USART_ISR_PE | USART_ISR_FE | USART_ISR_NE)
+
+/*===========================================================================*/
+/* Model exported variables.                                                 */
+/*===========================================================================*/
+
+RCC_TypeDef host_rcc;
+USART_TypeDef host_usart1, host_usart2, host_usart3;
+
+static DMA_Stream_TypeDef dma_regs[STM32_DMA_STREAMS];
+
+#define DMA_STREAM_DESC(id) {&dma_regs[id], id}
+
+const stm32_dma_stream_t _stm32_dma_streams[STM32_DMA_STREAMS] = {
+  DMA_STREAM_DESC(0),  DMA_STREAM_DESC(1),  DMA_STREAM_DESC(2),
+  DMA_STREAM_DESC(3),  DMA_STREAM_DESC(4),  DMA_STREAM_DESC(5),
+  DMA_STREAM_DESC(6),  DMA_STREAM_DESC(7),  DMA_STREAM_DESC(8),
+  DMA_STREAM_DESC(9),  DMA_STREAM_DESC(10), DMA_STREAM_DESC(11),
+  DMA_STREAM_DESC(12), DMA_STREAM_DESC(13), DMA_STREAM_DESC(14),
+  DMA_STREAM_DESC(15)
+};
+
+/*===========================================================================*/
+/* Model local variables and types.                                          */
+/*===========================================================================*/
+
+static usart_model_t *models[MODEL_MAX];
+static unsigned nmodels;
+static sim_device_t *devices[DEVICE_MAX];
+static unsigned ndevices;
+
+/**
+ * @brief   DMA stream state not visible in the registers.
+ */
+static struct {
+  stm32_dmaisr_t            func;
+  void                      *param;
+  bool                      allocated;
+  bool                      running;
+  uint32_t                  ndtr;     /* Transfer size when enabled.      */
+  uint32_t                  flags;    /* Pending ISR flags.               */
+} dmas[STM32_DMA_STREAMS];
+
+/* Stream interrupt enables, in the order of the ISR flags.*/
+#define DMA_CR_IRQ              (STM32_DMA_CR_DMEIE | STM32_DMA_CR_TEIE |   \
+                                 STM32_DMA_CR_HTIE | STM32_DMA_CR_TCIE)
+static unsigned long now;
+static bool inisr;
+static model_probe_t probe;
+
+/*===========================================================================*/
+/* Model local functions.                                                    */
+/*===========================================================================*/
+
+/**
+ * @brief   Data bits per frame, parity included.
+ */
+static unsigned data_bits(usart_model_t *mp) {
+  uint32_t cr1 = mp->u->CR1;
+
+  return (cr1 & USART_CR1_M0) ? 9 : (cr1 & USART_CR1_M1) ? 7 : 8;
+}
+
+/**
+ * @brief   Frame length in bit times, start and stop bits included.
+ */
+static unsigned frame_bits(usart_model_t *mp) {
+  unsigned stop = ((mp->u->CR2 & USART_CR2_STOP) == USART_CR2_STOP_1) ? 2 : 1;
+
+  return 1 + data_bits(mp) + stop;
+}
+
+/**
+ * @brief   Mask of the data bits.
+ */
+static uint32_t data_mask(usart_model_t *mp) {
+
+  return (1U << data_bits(mp)) - 1;
+}
+
+/**
+ * @brief   Applies the side effects of the register writes.
+ */
+static void apply_writes(usart_model_t *mp) {
+  USART_TypeDef *u = mp->u;
+
+  if (u->ICR != 0) {
+    u->ISR &= ~(u->ICR & ICR_MASK);
+    u->ICR = 0;
+  }
+  if (u->TDR != MODEL_TDR_EMPTY)
+    u->ISR &= ~(USART_ISR_TXE | USART_ISR_TC);
+  if (u->RQR != 0) {
+    if ((u->RQR & USART_RQR_MMRQ) && (u->CR1 & USART_CR1_MME))
+      u->ISR |= USART_ISR_RWU;
+    if (u->RQR & USART_RQR_RXFRQ)
+      u->ISR &= ~USART_ISR_RXNE;
+    u->RQR = 0;
+  }
+
+  /* Disabling the USART resets the state machines.*/
+  if (!(u->CR1 & USART_CR1_UE)) {
+    if (mp->enabled) {
+      mp->enabled = false;
+      mp->txbusy  = false;
+      u->TDR      = MODEL_TDR_EMPTY;
+      u->ISR      = USART_ISR_TXE | USART_ISR_TC;
+    }
+  }
+  else
+    mp->enabled = true;
+}
+
+/**
+ * @brief   Starts a frame on the receiver line.
+ */
+static void line_start(usart_model_t *mp, uint32_t c) {
+
+  if (mp->rxbusy)
+    return;                             /* Collision, the frame is lost.*/
+  mp->rxbusy    = true;
+  mp->rxleft    = frame_bits(mp);
+  mp->rxshift   = c;
+  mp->idlearmed = false;
+  mp->rtoarmed  = false;
+}
+
+/**
+ * @brief   Mute mode filter of a received frame.
+ * @details With address mark wakeup a frame with the MSB set is an
+ *          address, a match wakes the receiver and is received, any other
+ *          address mutes it.
+ *
+ * @return  The frame is discarded.
+ */
+static bool muted(usart_model_t *mp, uint32_t c) {
+  USART_TypeDef *u = mp->u;
+
+  if (!(u->CR1 & USART_CR1_MME))
+    return false;
+  if ((u->CR1 & USART_CR1_WAKE) && (c & (1U << (data_bits(mp) - 1)))) {
+    uint32_t mask = (u->CR2 & USART_CR2_ADDM7) ? 0x7FU : 0x0FU;
+
+    if ((c & mask) == ((u->CR2 >> 24) & mask))
+      u->ISR &= ~USART_ISR_RWU;
+    else
+      u->ISR |= USART_ISR_RWU;
+  }
+  return (u->ISR & USART_ISR_RWU) != 0;
+}
+
+/**
+ * @brief   Receiver, stop bit of a frame sampled.
+ */
+static void receive(usart_model_t *mp, uint32_t c) {
+  USART_TypeDef *u = mp->u;
+
+  mp->rxframes++;
+  mp->idlearmed = true;
+  mp->idlecnt   = 0;
+  mp->rtoarmed  = true;
+  mp->rtocnt    = 0;
+  if (!(u->CR1 & USART_CR1_RE) || muted(mp, c))
+    return;
+
+  if (u->ISR & USART_ISR_RXNE) {
+    /* The previous character has not been read, this one is lost.*/
+    u->ISR |= USART_ISR_ORE;
+    mp->overruns++;
+    return;
+  }
+  u->RDR = c & data_mask(mp);
+  u->ISR |= USART_ISR_RXNE | ((c >> 16) & RX_ERRORS);
+  if ((c & 0xFFU) == (u->CR2 >> 24))
+    u->ISR |= USART_ISR_CMF;
+}
+
+/**
+ * @brief   Transmitter, stop bit of a frame sent.
+ */
+static void transmit(usart_model_t *mp, uint32_t c) {
+
+  mp->txframes++;
+  mp->log[mp->loghead++ & (MODEL_LOG_SIZE - 1)] = (uint16_t)c;
+  if (mp->loghead - mp->logtail > MODEL_LOG_SIZE)
+    mp->logtail = mp->loghead - MODEL_LOG_SIZE;
+  if (mp->fd >= 0) {
+    uint8_t b = (uint8_t)c;
+    (void)write(mp->fd, &b, 1);
+  }
+}
+
+/**
+ * @brief   Clear to send, a frame can start on the line.
+ */
+static bool clear_to_send(usart_model_t *mp) {
+  usart_model_t *rx = mp->peer;
+
+  if (!(mp->u->CR3 & USART_CR3_CTSE) || (rx == NULL))
+    return true;
+  if ((rx->u->CR3 & USART_CR3_RTSE) && (rx->u->ISR & USART_ISR_RXNE))
+    return false;
+  return !rx->rtsoff;
+}
+
+/**
+ * @brief   Advances the USART by one bit time.
+ */
+static void clock_model(usart_model_t *mp) {
+  USART_TypeDef *u = mp->u;
+  bool sent = false;
+
+  apply_writes(mp);
+  if (!mp->enabled)
+    return;
+
+  /* Transmitter, the shift register reloads as soon as it is empty.*/
+  if (mp->txbusy && (--mp->txleft == 0)) {
+    mp->txbusy = false;
+    sent = true;
+    transmit(mp, mp->txshift);
+  }
+  if (!mp->txbusy && (u->CR1 & USART_CR1_TE) && (u->TDR != MODEL_TDR_EMPTY) &&
+      clear_to_send(mp)) {
+    mp->txshift = u->TDR & data_mask(mp);
+    mp->txbusy  = true;
+    mp->txleft  = frame_bits(mp);
+    u->TDR      = MODEL_TDR_EMPTY;
+    u->ISR     |= USART_ISR_TXE;
+    if (mp->peer != NULL)
+      line_start(mp->peer, mp->txshift);
+  }
+  else if (sent)
+    u->ISR |= USART_ISR_TC;           /* Last frame out, TDR empty.*/
+
+  /* Receiver, frames come from the peer or from the harness queue.*/
+  if (mp->rxbusy) {
+    if (--mp->rxleft == 0) {
+      mp->rxbusy = false;
+      receive(mp, mp->rxshift);
+    }
+  }
+  else if (mp->inhead != mp->intail)
+    line_start(mp, mp->inq[mp->intail++ & (MODEL_INQ_SIZE - 1)]);
+  else if ((mp->fd >= 0) && (now % frame_bits(mp) == 0)) {
+    uint8_t b;
+    if (read(mp->fd, &b, 1) == 1)
+      line_start(mp, b);
+  }
+
+  /* Line idle detection, one frame time without start bit.*/
+  if (!mp->rxbusy) {
+    if (mp->idlearmed && (++mp->idlecnt >= frame_bits(mp))) {
+      mp->idlearmed = false;
+      /* Idle line wakeup, the flag is not raised in that case.*/
+      if ((u->ISR & USART_ISR_RWU) && !(u->CR1 & USART_CR1_WAKE))
+        u->ISR &= ~USART_ISR_RWU;
+      else
+        u->ISR |= USART_ISR_IDLE;
+    }
+    if (mp->rtoarmed && (u->CR2 & USART_CR2_RTOEN) &&
+        (++mp->rtocnt >= (u->RTOR & USART_RTOR_RTO))) {
+      mp->rtoarmed = false;
+      u->ISR |= USART_ISR_RTOF;
+    }
+  }
+}
+
+/**
+ * @brief   Interrupt request line.
+ */
+static bool irq_pending(usart_model_t *mp) {
+  uint32_t isr = mp->u->ISR, cr1 = mp->u->CR1, cr2 = mp->u->CR2;
+  uint32_t cr3 = mp->u->CR3;
+
+  return ((isr & USART_ISR_RXNE) && (cr1 & USART_CR1_RXNEIE)) ||
+         ((isr & USART_ISR_ORE) &&
+          ((cr1 & USART_CR1_RXNEIE) || (cr3 & USART_CR3_EIE))) ||
+         ((isr & USART_ISR_TXE) && (cr1 & USART_CR1_TXEIE)) ||
+         ((isr & USART_ISR_TC) && (cr1 & USART_CR1_TCIE)) ||
+         ((isr & USART_ISR_IDLE) && (cr1 & USART_CR1_IDLEIE)) ||
+         ((isr & USART_ISR_PE) && (cr1 & USART_CR1_PEIE)) ||
+         ((isr & (USART_ISR_FE | USART_ISR_NE)) && (cr3 & USART_CR3_EIE)) ||
+         ((isr & USART_ISR_LBDF) && (cr2 & USART_CR2_LBDIE)) ||
+         ((isr & USART_ISR_RTOF) && (cr1 & USART_CR1_RTOIE)) ||
+         ((isr & USART_ISR_CMF) && (cr1 & USART_CR1_CMIE));
+}
+
+/**
+ * @brief   Runs the ISR once the request has waited for the latency.
+ * @note    Requests are held while the host thread is in a critical zone.
+ */
+static void service(usart_model_t *mp) {
+  bool rxne;
+
+  if (!host_nvic_enabled(mp->irq) || !irq_pending(mp)) {
+    mp->irqwait = 0;
+    return;
+  }
+  if ((mp->irqwait++ < mp->latency) || host_locked())
+    return;
+  mp->irqwait = 0;
+
+  rxne = (mp->u->ISR & USART_ISR_RXNE) && (mp->u->CR1 & USART_CR1_RXNEIE);
+  mp->isrcalls++;
+  inisr = true;
+  if (probe != NULL)
+    probe(true);
+  mp->vector();
+  if (probe != NULL)
+    probe(false);
+  inisr = false;
+
+  /* Unless the ISR left RDR to the receive DMA.*/
+  if (rxne && !(mp->u->CR3 & USART_CR3_DMAR))
+    mp->u->ISR &= ~USART_ISR_RXNE;
+  apply_writes(mp);
+}
+
+/**
+ * @brief   DMA request of a stream, from the USART owning its register.
+ *
+ * @return  The model or @p NULL if no request is pending.
+ */
+static usart_model_t *dma_request(DMA_Stream_TypeDef *st) {
+  unsigned i;
+
+  for (i = 0; i < nmodels; i++) {
+    USART_TypeDef *u = models[i]->u;
+
+    if (!models[i]->enabled)
+      continue;
+    if (((st->CR & STM32_DMA_CR_DIR_MASK) == STM32_DMA_CR_DIR_P2M) &&
+        (st->PAR == &u->RDR))
+      return ((u->CR3 & USART_CR3_DMAR) && (u->ISR & USART_ISR_RXNE)) ?
+             models[i] : NULL;
+    if (((st->CR & STM32_DMA_CR_DIR_MASK) == STM32_DMA_CR_DIR_M2P) &&
+        (st->PAR == &u->TDR))
+      return ((u->CR3 & USART_CR3_DMAT) && (u->TDR == MODEL_TDR_EMPTY) &&
+              (u->ISR & USART_ISR_TXE)) ? models[i] : NULL;
+  }
+  return NULL;
+}
+
+/**
+ * @brief   DMA request of a stream, from another peripheral.
+ */
+static bool device_request(DMA_Stream_TypeDef *st) {
+  unsigned i;
+
+  for (i = 0; i < ndevices; i++)
+    if (devices[i]->dma_request(devices[i], st))
+      return true;
+  return false;
+}
+
+/**
+ * @brief   Moves one data item on each requesting stream.
+ * @details A stream latches its transfer size when enabled, the normal
+ *          mode clears @p EN at the end, the circular mode reloads.
+ */
+static void clock_dma(void) {
+  unsigned i;
+
+  for (i = 0; i < STM32_DMA_STREAMS; i++) {
+    DMA_Stream_TypeDef *st = &dma_regs[i];
+    bool wide = (st->CR & STM32_DMA_CR_MSIZE_HWORD) != 0;
+    usart_model_t *mp;
+    uint32_t pos, item = 0;
+    bool p2m;
+
+    if (!(st->CR & STM32_DMA_CR_EN)) {
+      dmas[i].running = false;
+      continue;
+    }
+    if (!dmas[i].running) {
+      dmas[i].running = true;
+      dmas[i].ndtr    = st->NDTR;
+    }
+    if (st->NDTR == 0)
+      continue;
+    pos = (st->CR & STM32_DMA_CR_MINC) ? dmas[i].ndtr - st->NDTR : 0;
+    p2m = (st->CR & STM32_DMA_CR_DIR_MASK) == STM32_DMA_CR_DIR_P2M;
+
+    if ((mp = dma_request(st)) != NULL) {
+      if (p2m)
+        item = mp->u->RDR;
+      else
+        mp->u->TDR = wide ? ((const uint16_t *)st->M0AR)[pos] :
+                            ((const uint8_t *)st->M0AR)[pos];
+      mp->u->ISR &= p2m ? ~USART_ISR_RXNE : ~(USART_ISR_TXE | USART_ISR_TC);
+    }
+    else if (device_request(st)) {
+      /* Other peripherals have plain 32 bit data registers.*/
+      if (p2m)
+        item = *(volatile uint32_t *)st->PAR;
+      else
+        *(volatile uint32_t *)st->PAR = wide ?
+                                        ((const uint16_t *)st->M0AR)[pos] :
+                                        ((const uint8_t *)st->M0AR)[pos];
+    }
+    else
+      continue;
+
+    if (p2m) {
+      if (wide)
+        ((uint16_t *)st->M0AR)[pos] = (uint16_t)item;
+      else
+        ((uint8_t *)st->M0AR)[pos] = (uint8_t)item;
+    }
+
+    if (--st->NDTR == dmas[i].ndtr / 2)
+      dmas[i].flags |= STM32_DMA_ISR_HTIF;
+    if (st->NDTR == 0) {
+      dmas[i].flags |= STM32_DMA_ISR_TCIF;
+      if (st->CR & STM32_DMA_CR_CIRC)
+        st->NDTR = dmas[i].ndtr;
+      else {
+        st->CR &= ~STM32_DMA_CR_EN;
+        dmas[i].running = false;
+      }
+    }
+  }
+}
+
+/**
+ * @brief   Runs the ISR of the streams with an enabled flag pending.
+ * @note    Requests are held while the host thread is in a critical zone.
+ */
+static void service_dma(void) {
+  unsigned i;
+
+  for (i = 0; i < STM32_DMA_STREAMS; i++) {
+    uint32_t flags = dmas[i].flags;
+
+    /* The enables sit one bit below the flags they unmask.*/
+    if (!dmas[i].allocated ||
+        ((flags & ((dma_regs[i].CR & DMA_CR_IRQ) << 1)) == 0) ||
+        host_locked())
+      continue;
+    dmas[i].flags = 0;
+    inisr = true;
+    if (probe != NULL)
+      probe(true);
+    dmas[i].func(dmas[i].param, flags);
+    if (probe != NULL)
+      probe(false);
+    inisr = false;
+  }
+  for (i = 0; i < nmodels; i++)
+    apply_writes(models[i]);
+}
+
+/*===========================================================================*/
+/* Model exported functions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Allocates a DMA stream.
+ *
+ * @param[in] dmastp    pointer to the stream descriptor
+ * @param[in] priority  interrupt priority, not modelled
+ * @param[in] func      stream ISR
+ * @param[in] param     ISR parameter
+ * @return              The allocation failed.
+ * @retval true         The stream is already taken.
+ */
+bool dmaStreamAllocate(const stm32_dma_stream_t *dmastp, uint32_t priority,
+                       stm32_dmaisr_t func, void *param) {
+  unsigned i = dmastp->selfindex;
+
+  (void)priority;
+  if (dmas[i].allocated)
+    return true;
+  dmas[i].allocated = true;
+  dmas[i].func      = func;
+  dmas[i].param     = param;
+  dmas[i].running   = false;
+  dmas[i].flags     = 0;
+  dmastp->stream->CR = 0;
+  return false;
+}
+
+/**
+ * @brief   Releases a DMA stream.
+ *
+ * @param[in] dmastp    pointer to the stream descriptor
+ */
+void dmaStreamRelease(const stm32_dma_stream_t *dmastp) {
+
+  host_check(dmas[dmastp->selfindex].allocated, "not allocated",
+             __func__, __LINE__);
+  dmas[dmastp->selfindex].allocated = false;
+}
+
+/**
+ * @brief   Disables a DMA stream, the interrupts and pending flags too.
+ *
+ * @param[in] dmastp    pointer to the stream descriptor
+ */
+void dmaStreamDisable(const stm32_dma_stream_t *dmastp) {
+
+  dmastp->stream->CR &= ~(DMA_CR_IRQ | STM32_DMA_CR_EN);
+  dmas[dmastp->selfindex].running = false;
+  dmas[dmastp->selfindex].flags   = 0;
+}
+
+/**
+ * @brief   Fails the transfer of a stream, as a bus error does.
+ * @details @p EN is cleared and the transfer error flag raised.
+ *
+ * @param[in] dmastp    pointer to the stream descriptor
+ */
+void simDmaFail(const stm32_dma_stream_t *dmastp) {
+
+  dmastp->stream->CR &= ~STM32_DMA_CR_EN;
+  dmas[dmastp->selfindex].running = false;
+  dmas[dmastp->selfindex].flags  |= STM32_DMA_ISR_TEIF;
+}
+
+/**
+ * @brief   Initializes a USART model.
+ *
+ * @param[out] mp       pointer to the model
+ * @param[in] name      model name
+ * @param[in] u         register block
+ * @param[in] irq       interrupt vector number
+ * @param[in] vector    interrupt handler
+ */
+void modelInit(usart_model_t *mp, const char *name, USART_TypeDef *u,
+               uint32_t irq, void (*vector)(void)) {
+
+  mp->name   = name;
+  mp->u      = u;
+  mp->irq    = irq;
+  mp->vector = vector;
+  modelReset(mp);
+}
+
+/**
+ * @brief   Brings a model back to its reset state, links included.
+ *
+ * @param[in] mp        pointer to the model
+ */
+void modelReset(usart_model_t *mp) {
+  USART_TypeDef *u = mp->u;
+
+  u->CR1 = u->CR2 = u->CR3 = 0;
+  u->BRR = u->GTPR = u->RTOR = u->RQR = u->ICR = u->RDR = 0;
+  u->ISR = USART_ISR_TXE | USART_ISR_TC;
+  u->TDR = MODEL_TDR_EMPTY;
+  mp->peer      = NULL;
+  mp->fd        = -1;
+  mp->latency   = 0;
+  mp->rtsoff    = false;
+  mp->irqwait   = 0;
+  mp->txbusy    = false;
+  mp->rxbusy    = false;
+  mp->idlearmed = false;
+  mp->rtoarmed  = false;
+  mp->enabled   = false;
+  mp->inhead    = mp->intail = 0;
+  mp->loghead   = mp->logtail = 0;
+  mp->isrcalls  = mp->rxframes = mp->overruns = mp->txframes = 0;
+}
+
+/**
+ * @brief   Connects the transmitter of each model to the other receiver.
+ * @note    Linking a model to itself makes a loopback.
+ *
+ * @param[in] a         first model
+ * @param[in] b         second model
+ */
+void modelLink(usart_model_t *a, usart_model_t *b) {
+
+  a->peer = b;
+  b->peer = a;
+}
+
+/**
+ * @brief   Queues frames on the receiver line, sent back to back.
+ *
+ * @param[in] mp        pointer to the model
+ * @param[in] bp        frames
+ * @param[in] n         number of frames
+ * @param[in] errors    @p USART_ISR_PE, @p USART_ISR_FE and @p USART_ISR_NE
+ *                      flags raised with each frame
+ */
+void modelInject(usart_model_t *mp, const uint16_t *bp, size_t n,
+                 uint32_t errors) {
+
+  while (n-- > 0) {
+    if (mp->inhead - mp->intail >= MODEL_INQ_SIZE)
+      break;
+    mp->inq[mp->inhead++ & (MODEL_INQ_SIZE - 1)] =
+                                  *bp++ | ((errors & RX_ERRORS) << 16);
+  }
+}
+
+/**
+ * @brief   Queues bytes on the receiver line, sent back to back.
+ *
+ * @param[in] mp        pointer to the model
+ * @param[in] bp        bytes
+ * @param[in] n         number of bytes
+ */
+void modelInjectBytes(usart_model_t *mp, const uint8_t *bp, size_t n) {
+
+  while (n-- > 0) {
+    uint16_t c = *bp++;
+    modelInject(mp, &c, 1, 0);
+  }
+}
+
+/**
+ * @brief   Fetches the frames transmitted since the last call.
+ *
+ * @param[in] mp        pointer to the model
+ * @param[out] bp       frames buffer
+ * @param[in] n         buffer size
+ * @return              The number of frames fetched.
+ */
+size_t modelGetSent(usart_model_t *mp, uint16_t *bp, size_t n) {
+  size_t i;
+
+  for (i = 0; (i < n) && (mp->logtail != mp->loghead); i++)
+    bp[i] = mp->log[mp->logtail++ & (MODEL_LOG_SIZE - 1)];
+  return i;
+}
+
+/**
+ * @brief   Adds a model to the simulation.
+ *
+ * @param[in] mp        pointer to the model
+ */
+void simAdd(usart_model_t *mp) {
+
+  host_check(nmodels < MODEL_MAX, "too many models", __func__, __LINE__);
+  models[nmodels++] = mp;
+}
+
+/**
+ * @brief   Adds another peripheral to the simulation.
+ *
+ * @param[in] dp        pointer to the device hooks
+ */
+void simAddDevice(sim_device_t *dp) {
+  unsigned i;
+
+  for (i = 0; i < ndevices; i++)
+    if (devices[i] == dp)
+      return;
+  host_check(ndevices < DEVICE_MAX, "too many devices", __func__, __LINE__);
+  devices[ndevices++] = dp;
+}
+
+/**
+ * @brief   Advances the simulation by one bit time.
+ */
+void simTick(void) {
+  unsigned i;
+
+  now++;
+  for (i = 0; i < nmodels; i++)
+    clock_model(models[i]);
+  for (i = 0; i < ndevices; i++)
+    devices[i]->clock(devices[i]);
+  clock_dma();
+  for (i = 0; i < nmodels; i++)
+    service(models[i]);
+  service_dma();
+}
+
+/**
+ * @brief   Advances the simulation.
+ *
+ * @param[in] bits      number of bit times
+ */
+void simRun(unsigned long bits) {
+
+  while (bits-- > 0)
+    simTick();
+}
+
+/**
+ * @brief   Advances the simulation until a condition holds.
+ *
+ * @param[in] cond      condition
+ * @param[in] arg       condition argument
+ * @param[in] bits      maximum number of bit times
+ * @return              The condition state.
+ */
+bool simRunUntil(bool (*cond)(void *), void *arg, unsigned long bits) {
+
+  while (!cond(arg)) {
+    if (bits-- == 0)
+      return false;
+    simTick();
+  }
+  return true;
+}
+
+/**
+ * @brief   Bit times elapsed since start.
+ */
+unsigned long simNow(void) {
+
+  return now;
+}
+
+/**
+ * @brief   An ISR is running.
+ */
+bool simInISR(void) {
+
+  return inisr;
+}
+
+/**
+ * @brief   Sets the ISR probe, @p NULL removes it.
+ */
+void simSetProbe(model_probe_t p) {
+
+  probe = p;
+}
+
+/** @} */
@@ -0,0 +1,208 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    test/usart_model.h
+ * @brief   Host model of the STM32 USARTv2 peripheral.
+ *
+ * @addtogroup IUART_HOST
+ * @{
+ */
+
+#ifndef _USART_MODEL_H_
+#define _USART_MODEL_H_
+
+/*===========================================================================*/
+/* Model constants.                                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   TDR content meaning no data written by the driver.
+ */
+#define MODEL_TDR_EMPTY             0xFFFFFFFFU
+
+/**
+ * @brief   Injected characters queue size, must be a power of two.
+ */
+#define MODEL_INQ_SIZE              1024U
+
+/**
+ * @brief   Transmitted characters log size, must be a power of two.
+ */
+#define MODEL_LOG_SIZE              4096U
+
+/*===========================================================================*/
+/* Model data structures and types.                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a USART model.
+ */
+typedef struct usart_model usart_model_t;
+
+/**
+ * @brief   Structure representing a simulated USART.
+ * @details The driver accesses the register block directly. Side effects of
+ *          the accesses are applied by the model at each bit time and after
+ *          each ISR invocation:
+ *          - A write to @p ICR clears the matching flags.
+ *          - A write to @p TDR clears @p TXE and @p TC.
+ *          - A mute request in @p RQR sets @p RWU, a flush request clears
+ *            @p RXNE.
+ *          - @p RXNE is cleared after an ISR entered with @p RXNE and
+ *            @p RXNEIE set, the ISR always reads @p RDR in that case
+ *            unless it leaves it to the DMA by setting @p DMAR.
+ *          - A DMA stream whose peripheral address is @p RDR or @p TDR
+ *            is served on @p RXNE with @p DMAR or on @p TXE with
+ *            @p DMAT.
+ *          .
+ *          With @p CTSE the transmitter waits for the peer RTS, deasserted
+ *          by a full @p RDR with @p RTSE or by @p rtsoff.
+ */
+struct usart_model {
+  /**
+   * @brief Model name, for reports.
+   */
+  const char                *name;
+  /**
+   * @brief Simulated register block.
+   */
+  USART_TypeDef             *u;
+  /**
+   * @brief Interrupt vector number.
+   */
+  uint32_t                  irq;
+  /**
+   * @brief Interrupt handler.
+   */
+  void                      (*vector)(void);
+  /**
+   * @brief Receiver of the transmitted frames, may be the model itself.
+   */
+  usart_model_t             *peer;
+  /**
+   * @brief Host descriptor bridged to the line or -1.
+   */
+  int                       fd;
+  /**
+   * @brief Bit times between an interrupt request and its service.
+   */
+  unsigned                  latency;
+  /**
+   * @brief Software RTS deasserted, driven by the harness.
+   */
+  bool                      rtsoff;
+  /* Interrupt state.*/
+  unsigned                  irqwait;
+  /* Transmitter state.*/
+  bool                      txbusy;
+  unsigned                  txleft;
+  uint32_t                  txshift;
+  /* Receiver state.*/
+  bool                      rxbusy;
+  unsigned                  rxleft;
+  uint32_t                  rxshift;
+  bool                      idlearmed;
+  unsigned                  idlecnt;
+  bool                      rtoarmed;
+  unsigned                  rtocnt;
+  bool                      enabled;
+  /* Characters queued on the line by the harness, error flags in the
+     upper half.*/
+  uint32_t                  inq[MODEL_INQ_SIZE];
+  size_t                    inhead;
+  size_t                    intail;
+  /* Transmitted characters.*/
+  uint16_t                  log[MODEL_LOG_SIZE];
+  size_t                    loghead;
+  size_t                    logtail;
+  /* Counters.*/
+  unsigned long             isrcalls;
+  unsigned long             rxframes;
+  unsigned long             overruns;
+  unsigned long             txframes;
+};
+
+/**
+ * @brief   Type of a peripheral other than a USART.
+ */
+typedef struct sim_device sim_device_t;
+
+/**
+ * @brief   Hooks of a peripheral other than a USART, the first member of
+ *          its model.
+ */
+struct sim_device {
+  /**
+   * @brief Advances the peripheral by one bit time.
+   */
+  void                      (*clock)(sim_device_t *dp);
+  /**
+   * @brief Takes the request for a stream addressing the peripheral.
+   * @details The transfer follows in the same bit time, on a 32 bit data
+   *          register at the stream peripheral address.
+   */
+  bool                      (*dma_request)(sim_device_t *dp,
+                                           DMA_Stream_TypeDef *st);
+};
+
+/**
+ * @brief   ISR probe, invoked around each simulated interrupt.
+ */
+typedef void (*model_probe_t)(bool enter);
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void modelInit(usart_model_t *mp, const char *name, USART_TypeDef *u,
+                 uint32_t irq, void (*vector)(void));
+  void modelReset(usart_model_t *mp);
+  void modelLink(usart_model_t *a, usart_model_t *b);
+  void modelInject(usart_model_t *mp, const uint16_t *bp, size_t n,
+                   uint32_t errors);
+  void modelInjectBytes(usart_model_t *mp, const uint8_t *bp, size_t n);
+  size_t modelGetSent(usart_model_t *mp, uint16_t *bp, size_t n);
+  void simAdd(usart_model_t *mp);
+  void simAddDevice(sim_device_t *dp);
+  void simDmaFail(const stm32_dma_stream_t *dmastp);
+  void simTick(void);
+  void simRun(unsigned long bits);
+  bool simRunUntil(bool (*cond)(void *), void *arg, unsigned long bits);
+  unsigned long simNow(void);
+  bool simInISR(void);
+  void simSetProbe(model_probe_t probe);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _USART_MODEL_H_ */
+
+/** @} */